@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+# Measures the startup time of cealr, which dominates when it is run for one file at a time (e.g. from a build):
+# "--help" needs none of properties, gpgme and curl, verifying a small file reads the properties and makes one request.
+# Uses hyperfine if it is installed, otherwise a timed loop.
+# usage: benchmark-startup.sh [<cealr binary> [<runs>]]
+# The file is verified with the server in CEALR_SERVER (or the properties), the verification is skipped if CEALR_SERVER
+# is not set.
+CEALR=${1:-build/release/cealr}
+RUNS=${2:-100}
+if [ ! -x "$CEALR" ]; then
+  echo "cealr has not been found at \"$CEALR\", build it first or pass the binary as first argument." >&2
+  exit 1
+fi
+SMALL_FILE=$(mktemp)
+trap 'rm -f "$SMALL_FILE"' EXIT
+echo 'Hello, world.' >"$SMALL_FILE"
+COMMANDS=("$CEALR --help")
+if [ -n "$CEALR_SERVER" ]; then
+  COMMANDS+=("$CEALR $SMALL_FILE")
+fi
+
+if command -v hyperfine >/dev/null; then
+  # cealr --help exits with 1
+  hyperfine --ignore-failure --warmup 3 --runs "$RUNS" "${COMMANDS[@]}"
+  exit
+fi
+for command in "${COMMANDS[@]}"; do
+  $command >/dev/null 2>&1
+  start=$(date +%s%N)
+  for ((i = 0; i < RUNS; i++)); do
+    $command >/dev/null 2>&1
+  done
+  end=$(date +%s%N)
+  echo "$command: $(( (end - start) / RUNS / 1000 )) us per run ($RUNS runs)"
+done
@@ -0,0 +1,343 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ * The original algorithms were copied from
+ * Copyright (c) 2016 tomykaira
+ *
+ * https://gist.github.com/tomykaira/f0fd86b6c73063283afe550bc5d77594#file-base64-h
+ *
+ * The vectorized algorithms follow Wojciech Muła and Daniel Lemire, "Faster Base64 Encoding and Decoding using AVX2
+ * Instructions", ACM Transactions on the Web 12(3), 2018.
+ *
+ * The original code is licensed under MIT License <https://opensource.org/licenses/MIT>
+ * The changes made to adapt the code to the purposes of CryptoWerk are licensed under the
+ * Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ * Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "base64.h"
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BASE64_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static constexpr const char *binary2ascii = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static constexpr unsigned char ascii2binary[] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3E, 0xff, 0xff, 0xff, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// a vectorized kernel processes whole blocks and returns the number of input bytes (characters) it has consumed
+typedef size_t (*encode_kernel)(const unsigned char *in, size_t in_len, char *out);
+typedef size_t (*decode_kernel)(const char *in, size_t in_len, unsigned char *out);
+
+static size_t encode_none(const unsigned char *, size_t, char *)
+{
+  return 0;
+}
+
+static size_t decode_none(const char *, size_t, unsigned char *)
+{
+  return 0;
+}
+
+static void invalid_character(char c)
+{
+  throw base64_exception(__FILE__, __LINE__, "Character \'" + string(1, c) + "\' is not valid supported in this base 64 implementation.");
+}
+
+#ifdef BASE64_X86_SIMD
+
+// 12 input bytes of each 128 bit lane are spread to 16 bytes, each 32 bit word holding 3 bytes in the order b1 b0 b2 b1
+#define BASE64_ENCODE_SHUFFLE 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1
+// offsets added to the 6 bit values to get the ASCII characters, indexed by the reduced value
+#define BASE64_ENCODE_SHIFT 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, \
+                            '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+// flags of invalid characters by lower and by higher nibble, a character is invalid if both flags have a common bit
+#define BASE64_DECODE_LUT_LO 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A
+#define BASE64_DECODE_LUT_HI 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10
+// offsets added to the characters to get the 6 bit values, indexed by the higher nibble (and '/')
+#define BASE64_DECODE_ROLL 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0
+// packs the 24 bits of each 32 bit word into 3 consecutive bytes
+#define BASE64_DECODE_PACK 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+
+__attribute__((target("ssse3")))
+static inline __m128i encode_block_ssse3(__m128i in)
+{
+  in = _mm_shuffle_epi8(in, _mm_set_epi8(BASE64_ENCODE_SHUFFLE));
+  const __m128i t0      = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  const __m128i t1      = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  const __m128i t2      = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  const __m128i t3      = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  const __m128i indices = _mm_or_si128(t1, t3);
+  __m128i reduced       = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  const __m128i less    = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  reduced               = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+  const __m128i shift   = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_ENCODE_SHIFT), reduced);
+  return _mm_add_epi8(shift, indices);
+}
+
+__attribute__((target("ssse3")))
+static size_t encode_ssse3(const unsigned char *in, size_t in_len, char *out)
+{
+  size_t i = 0;
+  // 16 bytes are loaded for each block of 12 bytes
+  for (; i + 16 <= in_len; i += 12, out += 16)
+  {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), encode_block_ssse3(block));
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t encode_avx2(const unsigned char *in, size_t in_len, char *out)
+{
+  size_t i = 0;
+  // 28 bytes are loaded for each block of 24 bytes
+  for (; i + 28 <= in_len; i += 24, out += 32)
+  {
+    const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 12));
+    __m256i block    = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    block            = _mm256_shuffle_epi8(block, _mm256_set_epi8(BASE64_ENCODE_SHUFFLE, BASE64_ENCODE_SHUFFLE));
+    const __m256i t0      = _mm256_and_si256(block, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1      = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2      = _mm256_and_si256(block, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3      = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+    const __m256i indices = _mm256_or_si256(t1, t3);
+    __m256i reduced       = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    const __m256i less    = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    reduced               = _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+    const __m256i shift   = _mm256_shuffle_epi8(_mm256_setr_epi8(BASE64_ENCODE_SHIFT, BASE64_ENCODE_SHIFT), reduced);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_add_epi8(shift, indices));
+  }
+  // the rest of the blocks that fit into 16 byte loads
+  return i + encode_ssse3(in + i, in_len - i, out);
+}
+
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const char *in, size_t in_len, unsigned char *out)
+{
+  size_t i = 0;
+  // 16 bytes are stored for each block of 12 bytes, the last quantum (with padding) is left to the scalar decoder
+  for (; i + 20 < in_len; i += 16, out += 12)
+  {
+    const __m128i chars  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i higher = _mm_and_si128(_mm_srli_epi32(chars, 4), _mm_set1_epi8(0x0f));
+    const __m128i lower  = _mm_and_si128(chars, _mm_set1_epi8(0x0f));
+    const __m128i lo     = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_DECODE_LUT_LO), lower);
+    const __m128i hi     = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_DECODE_LUT_HI), higher);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())))
+    {
+      break; // the scalar decoder reports the invalid character
+    }
+    const __m128i eq_2f  = _mm_cmpeq_epi8(chars, _mm_set1_epi8(0x2f));
+    const __m128i roll   = _mm_shuffle_epi8(_mm_setr_epi8(BASE64_DECODE_ROLL), _mm_add_epi8(eq_2f, higher));
+    const __m128i values = _mm_add_epi8(chars, roll);
+    const __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i packed = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_shuffle_epi8(packed, _mm_setr_epi8(BASE64_DECODE_PACK)));
+  }
+  return i;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const char *in, size_t in_len, unsigned char *out)
+{
+  size_t i = 0;
+  // 32 bytes are stored for each block of 24 bytes
+  for (; i + 48 < in_len; i += 32, out += 24)
+  {
+    const __m256i chars  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+    const __m256i higher = _mm256_and_si256(_mm256_srli_epi32(chars, 4), _mm256_set1_epi8(0x0f));
+    const __m256i lower  = _mm256_and_si256(chars, _mm256_set1_epi8(0x0f));
+    const __m256i lo     = _mm256_shuffle_epi8(_mm256_setr_epi8(BASE64_DECODE_LUT_LO, BASE64_DECODE_LUT_LO), lower);
+    const __m256i hi     = _mm256_shuffle_epi8(_mm256_setr_epi8(BASE64_DECODE_LUT_HI, BASE64_DECODE_LUT_HI), higher);
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256())))
+    {
+      break;
+    }
+    const __m256i eq_2f  = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(0x2f));
+    const __m256i roll   = _mm256_shuffle_epi8(_mm256_setr_epi8(BASE64_DECODE_ROLL, BASE64_DECODE_ROLL),
+                                               _mm256_add_epi8(eq_2f, higher));
+    const __m256i values = _mm256_add_epi8(chars, roll);
+    const __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    const __m256i packed = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    const __m256i lanes  = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(BASE64_DECODE_PACK, BASE64_DECODE_PACK));
+    // move the 12 bytes of the upper lane right behind the 12 bytes of the lower lane
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out),
+                        _mm256_permutevar8x32_epi32(lanes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7)));
+  }
+  return i + decode_ssse3(in + i, in_len - i, out);
+}
+
+#endif //BASE64_X86_SIMD
+
+static encode_kernel select_encode_kernel()
+{
+#ifdef BASE64_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return encode_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    return encode_ssse3;
+  }
+#endif
+  return encode_none;
+}
+
+static decode_kernel select_decode_kernel()
+{
+#ifdef BASE64_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+  {
+    return decode_avx2;
+  }
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    return decode_ssse3;
+  }
+#endif
+  return decode_none;
+}
+
+size_t base64::encode(const void *data, size_t len, char *out)
+{
+  static const encode_kernel kernel = select_encode_kernel();
+  const auto *in = static_cast<const unsigned char *>(data);
+  size_t i = kernel(in, len, out);
+  char *p  = out + i / 3 * 4;
+
+  for (; i + 2 < len; i += 3)
+  {
+    *p++ = binary2ascii[in[i] >> 2];
+    *p++ = binary2ascii[((in[i] & 0x3) << 4) | (in[i + 1] >> 4)];
+    *p++ = binary2ascii[((in[i + 1] & 0xF) << 2) | (in[i + 2] >> 6)];
+    *p++ = binary2ascii[in[i + 2] & 0x3F];
+  }
+  if (i < len)
+  {
+    *p++ = binary2ascii[in[i] >> 2];
+    if (i == (len - 1))
+    {
+      *p++ = binary2ascii[((in[i] & 0x3) << 4)];
+      *p++ = '=';
+    }
+    else
+    {
+      *p++ = binary2ascii[((in[i] & 0x3) << 4) | (in[i + 1] >> 4)];
+      *p++ = binary2ascii[((in[i + 1] & 0xF) << 2)];
+    }
+    *p++ = '=';
+  }
+  return static_cast<size_t>(p - out);
+}
+
+size_t base64::decoded_length(const char *in, size_t in_len)
+{
+  if (in_len & 0x03)
+  {
+    throw base64_exception(__FILE__, __LINE__, "Size of string to be decoded must be a multiple of 4");
+  }
+  size_t out_len = (in_len / 4) * 3;
+  if (in_len && in[in_len - 1] == '=')
+  {
+    out_len--;
+    if (in[in_len - 2] == '=')
+    {
+      out_len--;
+    }
+  }
+  return out_len;
+}
+
+size_t base64::decode(const char *in, size_t in_len, char *out)
+{
+  static const decode_kernel kernel = select_decode_kernel();
+  const size_t out_len = decoded_length(in, in_len);
+  auto *o  = reinterpret_cast<unsigned char *>(out);
+  size_t i = kernel(in, in_len, o);
+  size_t j = i / 4 * 3;
+
+  // padding is only accepted in the last quantum
+  const size_t padding = in_len / 4 * 3 - out_len;
+  const size_t data_len = in_len - padding;
+  for (; i < in_len; i += 4)
+  {
+    uint32_t quantum = 0;
+    for (size_t k = 0; k < 4; k++)
+    {
+      const char c = in[i + k];
+      uint32_t value;
+      if (i + k >= data_len)
+      {
+        value = 0; // padding
+      }
+      else if ((value = ascii2binary[static_cast<unsigned char>(c)]) == 0xff)
+      {
+        invalid_character(c);
+      }
+      quantum = (quantum << 6) | value;
+    }
+    for (int shift = 16; shift >= 0 && j < out_len; shift -= 8)
+    {
+      o[j++] = static_cast<unsigned char>(quantum >> shift);
+    }
+  }
+  return out_len;
+}
+
+vector<char> *base64::decode(const string &rawInput)
+{
+  const string *input = &rawInput;
+  string stripped;
+  if (rawInput.find_first_of("\r\n ") != string::npos)
+  {
+    stripped.reserve(rawInput.size());
+    for (char c:rawInput)
+    {
+      if (c != '\r' && c != '\n' && c != ' ')
+      {
+        stripped.push_back(c);
+      }
+    }
+    input = &stripped;
+  }
+  auto out = new vector<char>(decoded_length(input->data(), input->size()));
+  try
+  {
+    decode(input->data(), input->size(), out->data());
+  }
+  catch (...)
+  {
+    delete out;
+    throw;
+  }
+  return out;
+}
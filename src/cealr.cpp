@@ -10,16 +10,22 @@
  */
 
 #include "cealr.h"
+#include "cealr_daemon.h"
 #include "curl_util.h"
 #include "file_util.h"
+#include "hex.h"
+#include "parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
 
-string cealr::hash_file(const string file)
+unsigned char *cealr::hash_file(const string &file, unsigned char *md) const
 {
   ifstream ifs(file.c_str(), ifstream::binary);
-  string hash_hex;
   if (ifs.is_open())
   {
-    hash_hex = getHashAsHex(ifs);
+    getHash(ifs, md);
     ifs.close();
   }
   else
@@ -29,7 +35,7 @@ string cealr::hash_file(const string file)
     string str_what = what.str();
     throw print_usage_msg(cmd_name, new string(str_what));
   }
-  return hash_hex;
+  return md;
 }
 
 void print_usage_msg::usage_message(string cmd_name)
@@ -50,6 +56,21 @@ void print_usage_msg::usage_message(string cmd_name)
   cout << "  General options:" << endl;
   cout << "  --verbose         enable verbose output" << endl;
   cout << "  --server          server URL, e.g. '" << sampleServerUrl << "'" << endl;
+  cout << "  --output <format> 'text' (default) or 'ndjson' to write one JSON record per verified file and" << endl
+       << "                    registration" << endl;
+  cout << "  --manifest <file> seal or verify the files listed in <file> ('-' for standard input), one per line as" << endl
+       << "                    '[<sha256>  ]<file>[@<version>]', in batches of " << MANIFEST_BATCH_SIZE << " files" << endl;
+  cout << "  --null            the entries of the manifest are terminated by NUL characters (find -print0)" << endl;
+  cout << "  --recursive <dir> seal or verify all files in the directory tree <dir>, may be given several times" << endl;
+  cout << "  --include <glob>  with --recursive only files matching <glob>, e.g. '*.pdf' or 'docs/*.txt'" << endl;
+  cout << "  --exclude <glob>  with --recursive skip files and directories matching <glob>, e.g. '.git'" << endl;
+  cout << "  --follow-symlinks with --recursive follow symbolic links instead of skipping them" << endl;
+  cout << "  --watch <dir>     seal the files written to or moved into the directory tree <dir> as they arrive, in" << endl
+       << "                    batches of up to " << WATCH_BATCH_SIZE << " files or " << WATCH_BATCH_DELAY
+       << " ms, until <dir> is removed" << endl;
+  cout << "  --daemon          keep running and serve sealing and verification requests on a Unix socket" << endl;
+  cout << "  --connect         run the command in the daemon instead of starting gpg and connecting again" << endl;
+  cout << "  --socket <file>   socket of the daemon, default $XDG_RUNTIME_DIR/" << DEFAULT_SOCKET << endl;
   cout << endl;
   cout << "  Mode of operation, one of:" << endl;
   cout << "  --help            this help" << endl;
@@ -59,6 +80,10 @@ void print_usage_msg::usage_message(string cmd_name)
   cout << endl;
   cout << "Additional options with --seal:" << endl;
   cout << "  --update          Email update when submitted file is verifiable in blockchain" << endl;
+  cout << "  --bundle <file>   seal all given files with one registration, the leaves of the local Merkle tree are" << endl
+       << "                    stored in <file>, which is needed later to verify the files" << endl;
+  cout << "  --sign-manifest   sign one manifest with the names and hashes of all given files instead of signing" << endl
+       << "                    each file" << endl;
   cout << "  --apiKey          API key, e.g. '" << "TskZZ8Zc2QzE3G+lxvUnWPKMk27Ucd1tm9K/YSPXWww=" << "'" << endl;
   cout << "  --apiCredential   API credential, e.g. ' " << "vV/2buaDD5aAcCQxCtk4WRJs/yK+BewThR1qUXikdJo=" << "'"
        << endl;
@@ -71,33 +96,53 @@ void print_usage_msg::usage_message(string cmd_name)
   cout << endl;
   cout << "Example verify a file" << endl;
   cout << "  " << cmd_name << " hello.txt" << endl;
+  cout << endl;
+  cout << "Example for sealing and verifying files in a bundle:" << endl;
+  cout << "  " << cmd_name << " --bundle release.bundle --seal hello.txt --seal world.txt" << endl;
+  cout << "  " << cmd_name << " --bundle release.bundle hello.txt" << endl;
+  cout << endl;
+  cout << "Example for sealing all files of a directory tree:" << endl;
+  cout << "  find data -type f -print0 | " << cmd_name << " --null --manifest - --seal" << endl;
+  cout << "  " << cmd_name << " --bundle data.bundle --exclude '*.tmp' --recursive data --seal" << endl;
+  cout << "  " << cmd_name << " --exclude '*.part' --output ndjson --watch ingest" << endl;
+  cout << endl;
+  cout << "Example for sealing with a daemon:" << endl;
+  cout << "  " << cmd_name << " --daemon &" << endl;
+  cout << "  " << cmd_name << " --connect --seal hello.txt" << endl;
 
 }
 
-cealr::cealr(const int argc, const char **argv)
+cealr::cealr(const int argc, const char **argv, bool _interactive)
 {
+  interactive = _interactive;
 #ifndef NDEBUG
   //todo oz: Only for testing/debugging
-  if (isatty(fileno(stdin)))
+  if (interactive && isatty(fileno(stdin)))
   {
     get_single_character_answer("Attach debugger?", {-1, 'N'}, 'N');
   }
 #endif
   cmd_name = argc > 0 ? argv[0] : CEALR;
   verbose = false;
+  ndjson  = false;
 
   p_properties = new properties();
-  cout << *p_properties << endl;
 
   // should call default constructor
   register_arg_found  = false;
   reg_client          = false;
   seal                = false;
   sign                = false;
+  sign_manifest       = false;
   server              = nullptr;
   email               = nullptr;
   api_key             = nullptr;
   api_credential      = nullptr;
+  bundle_file         = nullptr;
+  bundle              = nullptr;
+  manifest_file       = nullptr;
+  manifest_null       = false;
+  watch_dir           = nullptr;
 
   for (int i = 1; i < argc; i++)
   {
@@ -113,6 +158,11 @@ cealr::cealr(const int argc, const char **argv)
       reg_client = arg == "--register";
       register_arg_found = true;
     }
+    else if (arg == "--seal" && (!more_args || strncmp(argv[i + 1], "--", 2) == 0))
+    {
+      // the files to be sealed are given by --manifest
+      seal = true;
+    }
     else if (i + 1 < argc && arg == "--seal")
     {
       seal = true;
@@ -126,6 +176,12 @@ cealr::cealr(const int argc, const char **argv)
       call_add_to_hashes = true;
       arg = argv[++i];
     }
+    else if (arg == "--sign-manifest")
+    {
+      seal          = true;
+      sign          = true;
+      sign_manifest = true;
+    }
     else if (more_args && arg == "--server")
     {
       server = new string(argv[++i]);
@@ -138,6 +194,48 @@ cealr::cealr(const int argc, const char **argv)
     {
       api_credential = new string(argv[++i]);
     }
+    else if (more_args && arg == "--bundle")
+    {
+      bundle_file = new string(argv[++i]);
+    }
+    else if (more_args && arg == "--manifest")
+    {
+      manifest_file = new string(argv[++i]);
+    }
+    else if (arg == "--null")
+    {
+      manifest_null = true;
+    }
+    else if (more_args && arg == "--recursive")
+    {
+      recursive_dirs.push_back(argv[++i]);
+    }
+    else if (more_args && arg == "--include")
+    {
+      walker.include(argv[++i]);
+    }
+    else if (more_args && arg == "--exclude")
+    {
+      walker.exclude(argv[++i]);
+    }
+    else if (more_args && arg == "--watch")
+    {
+      watch_dir = new string(argv[++i]);
+      seal      = true;
+    }
+    else if (arg == "--follow-symlinks")
+    {
+      walker.set_follow_symlinks(true);
+    }
+    else if (more_args && arg == "--output")
+    {
+      const string format = argv[++i];
+      if (format != "text" && format != "ndjson")
+      {
+        throw print_usage_msg(cmd_name, new string("Unknown output format \"" + format + "\"."));
+      }
+      ndjson = format == "ndjson";
+    }
     else if (arg == "--help" || arg == "-h")
     {
       throw print_usage_msg(cmd_name);
@@ -174,6 +272,16 @@ cealr::cealr(const int argc, const char **argv)
       }
     }
   }
+  if (manifest_file && (bundle_file || sign || !file_names.empty() || !recursive_dirs.empty()))
+  {
+    throw print_usage_msg(cmd_name, new string("The option --manifest cannot be combined with --bundle, --sign, "
+                                               "--recursive or files on the command line."));
+  }
+  if (watch_dir && (manifest_file || bundle_file || sign || !file_names.empty() || !recursive_dirs.empty()))
+  {
+    throw print_usage_msg(cmd_name, new string("The option --watch cannot be combined with --manifest, --bundle, "
+                                               "--sign, --recursive or files on the command line."));
+  }
   if (api_key && !api_credential)
   {
     stringstream what;
@@ -194,20 +302,54 @@ cealr::cealr(const int argc, const char **argv)
   }
 }
 
-void cealr::add2hashes(const string &file_name, const string *version)
+cealr::cealr(const string *_server, const string *_api_key, const string *_api_credential,
+             function<void(const json &)> _sink) : cealr(0, nullptr, false)
 {
-  if (!hex_hashes.empty())
+  ndjson      = true;
+  record_sink = move(_sink);
+  // calls of the library run at the same time, none of them writes the properties file
+  p_properties->set_read_only();
+  if (_server)
+  {
+    server = new string(*_server);
+  }
+  if (_api_key)
+  {
+    delete api_key;
+    api_key = new string(*_api_key);
+  }
+  if (_api_credential)
   {
-    hex_hashes.append(",");
+    delete api_credential;
+    api_credential = new string(*_api_credential);
   }
-  hex_hashes.append(hash_file(file_name));
+}
+
+void cealr::add2hashes(const string &file_name, const string *version, const string *signed_name)
+{
   file_names.push_back(file_name);
+  if (signed_name)
+  {
+    signed_names.push_back(*signed_name);
+  }
+  else
+  {
+    string *name = file_name_without_path(file_name);
+    signed_names.push_back(*name);
+    delete name;
+  }
+  append_doc_name(doc_names, file_name, version);
+}
+
+void cealr::append_doc_name(string &doc_names, const string &file_name, const string *version)
+{
   string *doc_name = file_name_without_path(file_name);
   if (!doc_names.empty())
   {
     doc_names.append(",");
   }
   doc_names.append(*doc_name);
+  delete doc_name;
   if (version && !version->empty())
   {
     doc_names.append(" @");
@@ -215,25 +357,413 @@ void cealr::add2hashes(const string &file_name, const string *version)
   }
 }
 
-void cealr::run()
+void cealr::add_tree_files()
 {
-  if (!server)
+  vector<string> rel_paths;
+  const vector<string> files = walker.walk(recursive_dirs, &rel_paths);
+  file_names.reserve(file_names.size() + files.size());
+  signed_names.reserve(signed_names.size() + files.size());
+  for (size_t i = 0; i < files.size(); i++)
   {
-    server = p_properties->get("server", get_env_str("CEALR_SERVER"), false);
-    if (!server)
+    add2hashes(files[i], nullptr, &rel_paths[i]);
+  }
+  if (file_names.empty())
+  {
+    throw print_usage_msg(cmd_name, new string("There are no files to be sealed or verified in the given directories."));
+  }
+  if (!ndjson)
+  {
+    cout << "Found " << files.size() << " file(s) in " << recursive_dirs.size() << " directory tree(s)." << endl;
+  }
+}
+
+void cealr::hash_files()
+{
+  file_hashes.assign(file_names.size(), string());
+  if (bundle_file && seal)
+  {
+    // only the root is needed for sealing, the paths are calculated from the bundle file during verification
+    bundle = new merkle_tree(BundleMethod::BALANCED_CONCURRENT_MERKLE_TREE, false);
+    bundle->reserve_leaves(file_names.size());
+  }
+  vector<unsigned char> hashes = hash_files(file_names, file_hashes, bundle_file && seal ? bundle : nullptr);
+  hex_hashes = hex_codec::encode_list(hashes.data(), file_names.size(), SHA256_DIGEST_LENGTH, ',');
+}
+
+vector<unsigned char> cealr::hash_files(const vector<string> &names, vector<string> &hashes, merkle_tree *leaves) const
+{
+  vector<unsigned char> raw(names.size() * SHA256_DIGEST_LENGTH);
+  hashes.resize(names.size());
+  parallel_for(names.size(), [this, &names, &hashes, &raw, leaves](size_t i)
+  {
+    unsigned char *hash = &raw[i * SHA256_DIGEST_LENGTH];
+    if (hashes[i].empty())
     {
-      server = new string(DEFAULT_SERVER);
+      hash_file(names[i], hash);
+    }
+    else
+    {
+      hex_codec::decode(hashes[i].data(), hashes[i].size(), hash);
+    }
+    if (leaves)
+    {
+      leaves->set_leaf(i, hash);
+    }
+  });
+  // precomputed hashes are normalized to lower case as well
+  hex_codec::encode_batch(raw.data(), names.size(), SHA256_DIGEST_LENGTH, hashes.data());
+  return raw;
+}
+
+bool cealr::read_batch(manifest_reader &reader, file_batch &batch) const
+{
+  batch.file_names.clear();
+  batch.file_hashes.clear();
+  batch.signed_names.clear();
+  batch.doc_names.clear();
+  manifest_entry entry;
+  while (batch.file_names.size() < MANIFEST_BATCH_SIZE && reader.next(entry))
+  {
+    batch.file_names.push_back(entry.file);
+    batch.file_hashes.push_back(entry.hash);
+    string *name = file_name_without_path(entry.file);
+    batch.signed_names.push_back(*name);
+    delete name;
+    append_doc_name(batch.doc_names, entry.file, &entry.version);
+  }
+  if (batch.file_names.empty())
+  {
+    return false;
+  }
+  vector<unsigned char> hashes = hash_files(batch.file_names, batch.file_hashes);
+  batch.hex_hashes = hex_codec::encode_list(hashes.data(), batch.file_names.size(), SHA256_DIGEST_LENGTH, ',');
+  return true;
+}
+
+void cealr::run_manifest()
+{
+  manifest_reader reader(*manifest_file, manifest_null ? '\0' : '\n');
+  file_batch next;
+  size_t total = 0;
+  bool more = read_batch(reader, next);
+  while (more)
+  {
+    file_names.swap(next.file_names);
+    file_hashes.swap(next.file_hashes);
+    signed_names.swap(next.signed_names);
+    hex_hashes.swap(next.hex_hashes);
+    doc_names.swap(next.doc_names);
+    // the next batch is read and hashed while this one is submitted (the future waits for it, even if this one fails)
+    future<bool> reading = async(launch::async, &cealr::read_batch, this, ref(reader), ref(next));
+    if (seal)
+    {
+      const json ret_json = seal_file();
+      if (ndjson)
+      {
+        write_sealed_records(ret_json);
+      }
+      else
+      {
+        cout << "Sealed " << file_names.size() << " file(s) from \"" << *manifest_file << "\"." << endl;
+      }
+    }
+    else
+    {
+      verify();
+    }
+    total += file_names.size();
+    more = reading.get();
+  }
+  if (!total)
+  {
+    throw print_usage_msg(cmd_name, new string("The manifest \"" + *manifest_file + "\" does not contain any files."));
+  }
+  if (!ndjson)
+  {
+    cout << (seal ? "Sealed " : "Verified ") << total << " file(s) from \"" << *manifest_file << "\"." << endl;
+  }
+}
+
+void cealr::write_sealed_records(const json &ret_json)
+{
+  // the retrieval ids are only assigned to the files if the server returned one document per file
+  const auto docs     = ret_json.find("documents");
+  const bool with_ids = docs != ret_json.end() && docs->is_array() && docs->size() == file_names.size();
+  for (size_t i = 0; i < file_names.size(); i++)
+  {
+    json record;
+    record["file"]   = file_names[i];
+    record["hash"]   = file_hashes[i];
+    record["sealed"] = true;
+    if (with_ids && (*docs)[i].count("retrievalId"))
+    {
+      record["retrievalId"] = (*docs)[i]["retrievalId"];
+    }
+    write_record(record);
+  }
+}
+
+/*!
+@brief returns the message of the exception being handled, what() of the exceptions of cealr is not virtual
+*/
+static string current_error_message()
+{
+  try
+  {
+    throw;
+  }
+  catch (print_usage_msg &e)
+  {
+    return e.what();
+  }
+  catch (pgp_exception &e)
+  {
+    return e.what();
+  }
+  catch (hex_exception &e)
+  {
+    return e.what();
+  }
+  catch (SmartStampError &e)
+  {
+    return e.what();
+  }
+  catch (file_exception &e)
+  {
+    return e.what();
+  }
+  catch (curl_exception &e)
+  {
+    return e.what();
+  }
+  catch (cealr_exception &e)
+  {
+    return e.what();
+  }
+  catch (exception &e)
+  {
+    return e.what();
+  }
+  catch (...)
+  {
+    return "Unknown error.";
+  }
+}
+
+void cealr::run_watch()
+{
+  dir_watcher watcher(*watch_dir, walker);
+  if (!ndjson)
+  {
+    cout << "Watching \"" << *watch_dir << "\" for new files." << endl;
+  }
+  size_t total  = 0;
+  size_t failed = 0;
+  const auto report_failure = [this, &failed](const string &file, const string &error)
+  {
+    if (ndjson)
+    {
+      json record;
+      record["file"]   = file;
+      record["sealed"] = false;
+      record["error"]  = error;
+      write_record(record);
+    }
+    else
+    {
+      cerr << "Cannot seal \"" << file << "\": " << error << endl;
+    }
+    failed++;
+  };
+  unordered_map<string, int> attempts;  // failed registrations of the files to be sealed with the next batches
+  vector<string>             batch;
+  while (watcher.next(batch, WATCH_BATCH_SIZE, WATCH_BATCH_DELAY))
+  {
+    // every file is hashed on its own, a file that cannot be read (e.g. removed in the meantime) is left out
+    vector<unsigned char> raw(batch.size() * SHA256_DIGEST_LENGTH);
+    vector<string>        errors(batch.size());
+    parallel_for(batch.size(), [this, &batch, &raw, &errors](size_t i)
+    {
+      try
+      {
+        hash_file(batch[i], &raw[i * SHA256_DIGEST_LENGTH]);
+      }
+      catch (...)
+      {
+        errors[i] = current_error_message();
+      }
+    });
+    file_names.clear();
+    doc_names.clear();
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      if (!errors[i].empty())
+      {
+        report_failure(batch[i], errors[i]);
+        attempts.erase(batch[i]);
+        continue;
+      }
+      memmove(&raw[file_names.size() * SHA256_DIGEST_LENGTH], &raw[i * SHA256_DIGEST_LENGTH], SHA256_DIGEST_LENGTH);
+      append_doc_name(doc_names, batch[i], nullptr);
+      file_names.push_back(move(batch[i]));
+    }
+    if (file_names.empty())
+    {
+      continue;
+    }
+    file_hashes.resize(file_names.size());
+    hex_codec::encode_batch(raw.data(), file_names.size(), SHA256_DIGEST_LENGTH, file_hashes.data());
+    hex_hashes = hex_codec::encode_list(raw.data(), file_names.size(), SHA256_DIGEST_LENGTH, ',');
+    json ret_json;
+    try
+    {
+      ret_json = seal_file();
+    }
+    catch (...)
+    {
+      // the registration is retried with the next batches, the files are given up after WATCH_SEAL_ATTEMPTS
+      const string   error = current_error_message();
+      vector<string> retry;
+      for (const string &file:file_names)
+      {
+        if (++attempts[file] < WATCH_SEAL_ATTEMPTS)
+        {
+          retry.push_back(file);
+        }
+        else
+        {
+          attempts.erase(file);
+          report_failure(file, error);
+        }
+      }
+      if (!retry.empty())
+      {
+        cerr << "Cannot seal " << file_names.size() << " file(s), retrying with the next batch: " << error << endl;
+      }
+      watcher.retry(retry);
+      continue;
+    }
+    for (const string &file:file_names)
+    {
+      attempts.erase(file);
+    }
+    if (ndjson)
+    {
+      write_sealed_records(ret_json);
+    }
+    else
+    {
+      cout << "Sealed " << file_names.size() << " file(s) from \"" << *watch_dir << "\"." << endl;
+    }
+    total += file_names.size();
+  }
+  if (!ndjson)
+  {
+    cout << "\"" << *watch_dir << "\" has been removed, sealed " << total << " file(s)";
+    if (failed)
+    {
+      cout << ", " << failed << " file(s) could not be sealed";
+    }
+    cout << "." << endl;
+  }
+}
+
+void cealr::write_bundle()
+{
+  ofstream ofs(bundle_file->c_str(), ofstream::out);
+  if (ofs.fail())
+  {
+    throw file_exception(*bundle_file);
+  }
+  for (size_t i = 0; i < file_names.size(); i++)
+  {
+    bundle_leaves.push_back(i);
+    ofs << file_hashes[i] << "  " << file_names[i] << endl;
+  }
+  ofs.close();
+  hex_hashes   = to_hex(bundle->root(), SHA256_DIGEST_LENGTH);
+  string *name = file_name_without_path(*bundle_file);
+  doc_names    = *name;
+  delete name;
+  cout << "Bundled " << file_names.size() << " file(s) into \"" << *bundle_file << "\" with root hash " << hex_hashes
+       << endl;
+}
+
+void cealr::read_bundle()
+{
+  ifstream ifs(bundle_file->c_str());
+  if (!ifs.is_open())
+  {
+    throw file_exception(*bundle_file);
+  }
+  bundle = new merkle_tree(BundleMethod::BALANCED_CONCURRENT_MERKLE_TREE);
+  string line;
+  while (getline(ifs, line))
+  {
+    line = trim(line);
+    if (!line.empty())
+    {
+      bundle->add_leaf(line.substr(0, line.find(' ')));
+    }
+  }
+  ifs.close();
+  vector<unsigned char> hashes(file_hashes.size() * SHA256_DIGEST_LENGTH);
+  hex_codec::decode_batch(file_hashes.data(), file_hashes.size(), SHA256_DIGEST_LENGTH, hashes.data());
+  for (size_t i = 0; i < file_names.size(); i++)
+  {
+    long leaf = bundle->find_leaf(&hashes[i * SHA256_DIGEST_LENGTH]);
+    if (leaf < 0)
+    {
+      throw print_usage_msg(cmd_name, new string("The file \"" + file_names[i] + "\" is not part of the bundle \"" +
+                                                 *bundle_file + "\"."));
     }
+    bundle_leaves.push_back(leaf);
+  }
+  hex_hashes = to_hex(bundle->root(), SHA256_DIGEST_LENGTH);
+}
+
+vector<string> cealr::signed_files() const
+{
+  return bundle_file ? vector<string>{*bundle_file} : file_names;
+}
+
+vector<string> cealr::signed_file_names() const
+{
+  if (!bundle_file)
+  {
+    return signed_names;
   }
+  string *name = file_name_without_path(*bundle_file);
+  const vector<string> names{*name};
+  delete name;
+  return names;
+}
+
+void cealr::run()
+{
+  if (!recursive_dirs.empty())
+  {
+    add_tree_files();
+  }
+  if (!manifest_file && !watch_dir)
+  {
+    hash_files();
+  }
+  init_server();
   //in case of option --seal
   if (register_arg_found || (seal && !api_key && !p_properties->get("apiKey") && !p_properties->get("email")))
   {
+    if (!interactive)
+    {
+      throw print_usage_msg(cmd_name, new string("There is no account configured, please use --register or --login "
+                                                 "without --connect first."));
+    }
     init_properties();
-    // todo No need to exit here, if user just has been created we could wait in cealr (password entry) for activation
-    // todo or we exit here and they just need to start cealr again after activation
+    // todo No need to stop here, if user just has been created we could wait in cealr (password entry) for activation
+    // todo or we stop here and they just need to start cealr again after activation
     if (reg_client)
     {
-      exit(1);
+      throw cealr_exception(__FILE__, __LINE__, "Please start cealr again after the activation of your account.");
     }
   }
   if (seal)
@@ -244,6 +774,11 @@ void cealr::run()
     init_from_prop_if_null(&server, "server");
     if (!api_key || !api_key->length() || !api_credential || !api_credential->length())
     {
+      if (!interactive)
+      {
+        throw print_usage_msg(cmd_name, new string("The account credentials are not configured, please use --login "
+                                                   "without --connect first."));
+      }
       string *password = read_password();
       cout << endl << "Contacting server \"" << *server << "\" to retrieve your account credentials." << endl << endl;
       json ret_json = creds(*password);
@@ -252,7 +787,8 @@ void cealr::run()
       api_credential = new string((string&)ret_json["apiCredential"]);
       if (!api_credential || !api_credential->length())
       {
-        cerr << "The apiCredential has already been revealed for this apiKey." << endl
+        stringstream what;
+        what << "The apiCredential has already been revealed for this apiKey." << endl
              << "For your security we can show an apiCredential exactly one time." << endl
              << "The command line tool is usually storing it in ~/.cealr/config.properties." << endl
              << "If you have another system or user where you use the same CryptoWerk account" << endl
@@ -261,34 +797,59 @@ void cealr::run()
              << "Alternatively you could login to your CryptoWerk Portal and generate a new API key." << endl
              << "Be careful: This would invalidate the current API key for this account-user" << endl
              << "combination which may be used in other systems." << endl;
-        exit(1);
+        throw cealr_exception(__FILE__, __LINE__, what.str());
       }
       p_properties->put("apiKey",        *api_key);
       p_properties->put("apiCredential", *api_credential);
       p_properties->save();
     }
   }
+  if (manifest_file)
+  {
+    run_manifest();
+    return;
+  }
+  if (watch_dir)
+  {
+    run_watch();
+    return;
+  }
   if (hex_hashes.empty())
   {
     throw print_usage_msg(cmd_name, new string("Missing mode of operation. You might want to try option '--help'."));
   }
+  if (bundle_file)
+  {
+    if (seal)
+    {
+      write_bundle();
+    }
+    else
+    {
+      read_bundle();
+    }
+  }
   if (seal)
   {
-    if (sign)
+    if (sign_manifest)
     {
-      open_pgp open_pgp(GPGME_SIG_MODE_DETACH, p_properties, email);
-      for (const string &file_name:file_names)
+      seal_signed_manifest();
+    }
+    else if (sign)
+    {
+      // the files are signed concurrently, each signature stays with its file
+      const vector<string> files = signed_files();
+      open_pgp_pool pgp_pool(GPGME_SIG_MODE_DETACH, p_properties, email, files.size());
+      const vector<string> &signatures = pgp_pool.sign(files);
+      const vector<string> names = signed_file_names();
+      for (size_t i = 0; verbose && i < files.size(); i++)
       {
-        open_pgp.sign(file_name);
-        if (verbose)
-        {
-          json json = open_pgp.toJson();
-          cout << "Signature: " << file_name << endl << json.dump() << endl;
-        }
+        cout << "Signature: " << files[i] << endl << signatures[i] << endl;
       }
+      const json sealed_meta_data = pgp_pool.toJson(names);
       cout << endl << "Contacting server \"" << *server << "\" to seal your file \"" << doc_names << "\"" << endl
            << endl;
-      seal_file(&open_pgp);
+      seal_file(&sealed_meta_data);
       cout << "File \"" << doc_names << "\" is successfully registered with Cryptowerk." << endl;
     }
     else
@@ -305,6 +866,31 @@ void cealr::run()
   }
 }
 
+void cealr::seal_signed_manifest()
+{
+  // in a bundle the manifest lists the files, not the bundle file
+  const string manifest = signed_manifest::build(signed_names, file_hashes);
+  open_pgp open_pgp(GPGME_SIG_MODE_DETACH, p_properties, email);
+  const string signature = open_pgp.sign_data(manifest);
+  if (verbose)
+  {
+    cout << "Manifest:" << endl << manifest << "Signature:" << endl << signature << endl;
+  }
+  istringstream manifest_stream(manifest);
+  const string manifest_hash = getHashAsHex(manifest_stream);
+  cout << endl << "Contacting server \"" << *server << "\" to seal the signed manifest of " << signed_names.size()
+       << " file(s)" << endl << endl;
+  seal_manifest(manifest, manifest_hash);
+  // the files refer to the manifest by its hash, so their meta data does not grow with the number of files
+  json sealed_meta_data = open_pgp.toJson();
+  sealed_meta_data.erase("signature");
+  sealed_meta_data["manifestHash"]      = manifest_hash;
+  sealed_meta_data["manifestSignature"] = open_pgp::compact_signature(signature);
+  cout << "Contacting server \"" << *server << "\" to seal your file \"" << doc_names << "\"" << endl << endl;
+  seal_file(&sealed_meta_data);
+  cout << "File \"" << doc_names << "\" is successfully registered with Cryptowerk." << endl;
+}
+
 void cealr::init_properties()
 {
   // ask if seal without apiKey
@@ -355,105 +941,339 @@ void cealr::init_properties()
   p_properties->save();
 }
 
-void cealr::verify()
+void cealr::verify()
+{
+  const json &ret_json = verify_seal();
+//  const json &ret_json = json::parse("{\"maxSupportedAPIVersion\":5,\"documents\":[{\"retrievalId\":\"ri21728553502aace61892c04cb822308ace41937c2afa38acaabdda08ac56207cae7c3e3\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEOQ01ha2VDYWNoZS50eHQBGGFwcGxpY2F0aW9uL29jdGV0LXN0cmVhbQiJD3sic2lnbmF0dXJlIjoiIGlRSXpCQUVCQ0FBZEZpRUVmTFlBdjNhcFF6bmg1Q2l2T1dVVFh6eUorcFVGQWx1SFB6TUFDZ2tRT1dVVFh6eUogK3BVUU1BLy9hM3hSbWxFRjdYa21MT09aWjhnQTVRT1ZybytNazRVS0xjZWh4cXViYkRENER4Y0RBaEtFcXkzcyAwV3dRVXR3TkY5MldtaElWeHVLMVdaOUU1c0p0d0pERnYyemRrK1Uwc1JCbFFzZW85SHgzOVVWcENhQWNGTEk3IEp6dmE5Mk8zcTlUUGZxblFXeGdWaVpGNFdlWm9tOFJTYVlaRkJWUXpIUkticEIzNTRLVGw2UFVRS2R5TnhtcXEgdEp6UWlXREhISDF5RThiNE12WXdwb2NYR0VYc1ZoanZReVhpMjdhNmpiQVlkWmllVmVubkQ0MWZiZjJBelluQSBYVDhQWG5Way8yTktxMEc2VnhhY01KU0dvTDd4Wk9QR0RXOVVJVW9NZFNGck9haXQzQlBFWU5GOHoveXJncE5KIFpqWE5CZ2NBMFZheU50MjVtSHdDSEVZSitWWW1sWmcxZWdVYTFmWW56Zng5bkN5NDhnTEo5VlZyM1hBaTA5WVYgUWJQZVRZYi9maGZUU1hZc0pVcjlBUTFsNG1YL2s2NlE1T01zNWJKRnpKZkFZS0R6eGdvcFZMTFlrdzRDMkdqUiBYUUJkK0hBdW4yeUdaVjdIS2NzTC83Wk0zZDcyTzllaEFrVWlVYXNONWZCVm5LTkpYQ1dYNi8rc2VRb29JbjdnIFBVSE1PSEtGV1BidmlWWkdhZlNZMkEybE83OVZFOE1BUmV2RE9oMHRsNkRmc0UwTEw5VXVwLytkRmMxUjRRSFQgditFT2lWNURuY1NSRDJNQkwrWURJTHM1T3NjVzNJSVJxSHNDY0YwMTB6aVNnaUZOZHpMNDNjVnI1VEQ2TE56cyBnWmlEcDNBZkZYV3FYWnFxSzMyQzVKcjFZSEJ1UWVqTStLYkMrTE1lY1YrR1FLdE5Kb009ID1QS1JGICIsImtleVNlcnZlciI6InBncC5taXQuZWR1IiwiZG9jSGFzaCI6IjEzMGMxYzg4NmVlMThkYjgzYzhhYTE5MmZhNzdhMjAyYWE3MWU5OTA5ZmZlNTRkZDFkOTFlMGRjY2FiNjIxMzIiLCJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJ2ZXJpZmllZFN1Ym1pdHRlckVtYWlsIjoib2xhZi56dW1wZUBnbWFpbC5jb20ifQG+A1NUBRQBBwABE0NNYWtlQ2FjaGUudHh0Lm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAAWJhYzViYzI0YzBiNTE1Yjk4ZWQ0MjhlYWNmN2MyMDBkNjFhMDUyNmZkOWIyNzJjMTQyNjE1YmEyZDM0NmMzMTCi2fqEsVkBJ8llKDLpbb8ZhIBoR+o1lIeBRWobnTfnjLHGkOMR5hMDEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIEZSKroLW/eRrXFas+nr7+uZRfn9dyhtt1KDu0VgRmewYGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABYmFjNWJjMjRjMGI1MTViOThlZDQyOGVhY2Y3YzIwMGQ2MWEwNTI2ZmQ5YjI3MmMxNDI2MTViYTJkMzQ2YzMxMKLZ+oSxWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgInyWUoMultvxmEgGhH6jWUh4FFahudN+eMscaQ4xHmEwRlIqugtb95GtcVqz6evv65lF+f13KG23UoO7RWBGZ7BgY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri21728562f2d8793cafdf5ab1dcc13a0c69995f288bd3de3541a44d263500ff9f68afa03\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAETQ01ha2VDYWNoZS50eHQubWV0YQEbYXBwbGljYXRpb24vY3J5cHRvd2Vyay1tZXRhBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABYmFjNWJjMjRjMGI1MTViOThlZDQyOGVhY2Y3YzIwMGQ2MWEwNTI2ZmQ5YjI3MmMxNDI2MTViYTJkMzQ2YzMxMKLZ+oSxWQEnyWUoMultvxmEgGhH6jWUh4FFahudN+eMscaQ4xHmEwMTDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgRlIqugtb95GtcVqz6evv65lF+f13KG23UoO7RWBGZ7BgY=\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"bac5bc24c0b515b98ed428eacf7c200d61a0526fd9b272c142615ba2d346c310\",\"insertedIntoBlockchainAt\":1535590225506,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"signature\\\":\\\" iQIzBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluHPzMACgkQOWUTXzyJ +pUQMA//a3xRmlEF7XkmLOOZZ8gA5QOVro+Mk4UKLcehxqubbDD4DxcDAhKEqy3s 0WwQUtwNF92WmhIVxuK1WZ9E5sJtwJDFv2zdk+U0sRBlQseo9Hx39UVpCaAcFLI7 Jzva92O3q9TPfqnQWxgViZF4WeZom8RSaYZFBVQzHRKbpB354KTl6PUQKdyNxmqq tJzQiWDHHH1yE8b4MvYwpocXGEXsVhjvQyXi27a6jbAYdZieVennD41fbf2AzYnA XT8PXnVk/2NKq0G6VxacMJSGoL7xZOPGDW9UIUoMdSFrOait3BPEYNF8z/yrgpNJ ZjXNBgcA0VayNt25mHwCHEYJ+VYmlZg1egUa1fYnzfx9nCy48gLJ9VVr3XAi09YV QbPeTYb/fhfTSXYsJUr9AQ1l4mX/k66Q5OMs5bJFzJfAYKDzxgopVLLYkw4C2GjR XQBd+HAun2yGZV7HKcsL/7ZM3d72O9ehAkUiUasN5fBVnKNJXCWX6/+seQooIn7g PUHMOHKFWPbviVZGafSY2A2lO79VE8MARevDOh0tl6DfsE0LL9Uup/+dFc1R4QHT v+EOiV5DncSRD2MBL+YDILs5OscW3IIRqHsCcF010ziSgiFNdzL43cVr5TD6LNzs gZiDp3AfFXWqXZqqK32C5Jr1YHBuQejM+KbC+LMecV+GQKtNJoM= =PKRF \\\",\\\"keyServer\\\":\\\"pgp.mit.edu\\\",\\\"docHash\\\":\\\"130c1c886ee18db83c8aa192fa77a202aa71e9909ffe54dd1d91e0dccab62132\\\",\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"verifiedSubmitterEmail\\\":\\\"olaf.zumpe@gmail.com\\\"}\"},\"name\":\"CMakeCache.txt\",\"submittedAt\":1535590203615,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"bac5bc24c0b515b98ed428eacf7c200d61a0526fd9b272c142615ba2d346c310\",\"insertedIntoBlockchainAt\":1535590225506,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true},{\"retrievalId\":\"ri213018397ae2f7960d0efc668c40209a565d384b4e3aac440995d63c073078b3e9f08c8\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEOQ01ha2VDYWNoZS50eHQBGGFwcGxpY2F0aW9uL29jdGV0LXN0cmVhbQiJD3sic2lnbmF0dXJlIjoiIGlRSXpCQUVCQ0FBZEZpRUVmTFlBdjNhcFF6bmg1Q2l2T1dVVFh6eUorcFVGQWx1RndsUUFDZ2tRT1dVVFh6eUogK3BXeWlBLy9meXZkdkJpUmljdWRnWWF1VWdtN1lqLzNwVzc2SS8ySGVXc2k5OHE2aFM3bGhYdU5BNGJrMW90ZSA0WFAwRDNiVmRnRGF0UUFBRmorcDlzejFwQUlYYnVQNVpJOEExMW9EK0JZbGRJYm1UUUEzSXR5YkhZMjVtckhEIFJKdTVBOCtmcDhBVUFIUUhXR0xlb0RMWVJDWERrd3NuYXBWMHpVR29QT2g2dUxHbUZldlo5QzY3QWhGWVNyRSsga1hLT2o1SWN1NTVYTVRCM1pxbWZ2ZTZPOXVIaG5Va3M1NUFBZkNIQm94ZHpvV2FUSFc0UGZsTWpPWHBrdVpBSSA5dE1YenFZZXpTTy9SeS9kZUJKdE9jaHNwU0xlaUFlLzZxSllNL0sxOEttNEZZMkQxdFIyNFFBcXY2YWNzMnlIIDNZb09zWXYxOTQ1eGw2VUpPeFJ6QzY1anlzRDlORkxxeXVrK0JKUWIwWlBXQnVWckF2TlYybzEydjYyWmdTbEUgVzJTOVZYNmZ3d3AwV211ZXFIZ1hWVmJsdkx5Uzl4MksvaWZXR2tESkxQTHlmNWs2dEEwYzFnSkZOc1hYbit4UCBzeUdqNmdEQk9EYjMxYncwOCtMVlhSWTVzaldzNGQrK3Fxc05Mdno2MWxYVGdsSG5SUE0xbEJrbkMveW92emZ2IHN4RE40RWlDR05vakEyOUgreFVBL1VZVUc5WTdKMVdQQUR2NXBZU3VKb1JIM1FXd2tEV2RyS3ZrQ3JwYzdLTVggMy85azIyYVBoMmFMSjBOLzdwc2xuZUpaSytMTUNGSmJNb0IwRFNmVmhicjR0bEMvc0Z2WTQ1UXhGL0pSaTNaUSAyZlNjcFBZQzY4akpIVFlPM2FwMk54K0Y5VStKckNmVVkzWUFUMGYrVDIreUVFM1VhRTA9ID1kTCtXICIsImtleVNlcnZlciI6InBncC5taXQuZWR1IiwiZG9jSGFzaCI6IjEzMGMxYzg4NmVlMThkYjgzYzhhYTE5MmZhNzdhMjAyYWE3MWU5OTA5ZmZlNTRkZDFkOTFlMGRjY2FiNjIxMzIiLCJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJ2ZXJpZmllZFN1Ym1pdHRlckVtYWlsIjoib2xhZi56dW1wZUBnbWFpbC5jb20ifQG+A1NUBRQBBwABE0NNYWtlQ2FjaGUudHh0Lm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAATNhZTgxODM4MjcwMWM0MGZjODBiY2JmNWVlZWFkZjBlYTc0OWVkZjQxOTIxZjA0Mjg5NGZjMDQzOTljOWEyMGS2ppGosFkBKl8dpcuGqGpnsbEnZjQuNn2uf5dmNTkW+NuXjdZ1dU8DEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIE8pYOpQlrDndt+SJWnpp2FNruuU+QpIcbH8Dz/19/vTsGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABM2FlODE4MzgyNzAxYzQwZmM4MGJjYmY1ZWVlYWRmMGVhNzQ5ZWRmNDE5MjFmMDQyODk0ZmMwNDM5OWM5YTIwZLamkaiwWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgIqXx2ly4aoamexsSdmNC42fa5/l2Y1ORb425eN1nV1TwTylg6lCWsOd235IlaemnYU2u65T5CkhxsfwPP/X3+9OwY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri21301840d2b6615d83281a20fc227369e11fe70c87a8314a943573c80f2e7a7aae46038\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAETQ01ha2VDYWNoZS50eHQubWV0YQEbYXBwbGljYXRpb24vY3J5cHRvd2Vyay1tZXRhBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABM2FlODE4MzgyNzAxYzQwZmM4MGJjYmY1ZWVlYWRmMGVhNzQ5ZWRmNDE5MjFmMDQyODk0ZmMwNDM5OWM5YTIwZLamkaiwWQEqXx2ly4aoamexsSdmNC42fa5/l2Y1ORb425eN1nV1TwMTDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgTylg6lCWsOd235IlaemnYU2u65T5CkhxsfwPP/X3+9OwY=\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"3ae818382701c40fc80bcbf5eeeadf0ea749edf41921f042894fc04399c9a20d\",\"insertedIntoBlockchainAt\":1535492893110,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"signature\\\":\\\" iQIzBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluFwlQACgkQOWUTXzyJ +pWyiA//fyvdvBiRicudgYauUgm7Yj/3pW76I/2HeWsi98q6hS7lhXuNA4bk1ote 4XP0D3bVdgDatQAAFj+p9sz1pAIXbuP5ZI8A11oD+BYldIbmTQA3ItybHY25mrHD RJu5A8+fp8AUAHQHWGLeoDLYRCXDkwsnapV0zUGoPOh6uLGmFevZ9C67AhFYSrE+ kXKOj5Icu55XMTB3Zqmfve6O9uHhnUks55AAfCHBoxdzoWaTHW4PflMjOXpkuZAI 9tMXzqYezSO/Ry/deBJtOchspSLeiAe/6qJYM/K18Km4FY2D1tR24QAqv6acs2yH 3YoOsYv1945xl6UJOxRzC65jysD9NFLqyuk+BJQb0ZPWBuVrAvNV2o12v62ZgSlE W2S9VX6fwwp0WmueqHgXVVblvLyS9x2K/ifWGkDJLPLyf5k6tA0c1gJFNsXXn+xP syGj6gDBODb31bw08+LVXRY5sjWs4d++qqsNLvz61lXTglHnRPM1lBknC/yovzfv sxDN4EiCGNojA29H+xUA/UYUG9Y7J1WPADv5pYSuJoRH3QWwkDWdrKvkCrpc7KMX 3/9k22aPh2aLJ0N/7pslneJZK+LMCFJbMoB0DSfVhbr4tlC/sFvY45QxF/JRi3ZQ 2fScpPYC68jJHTYO3ap2Nx+F9U+JrCfUY3YAT0f+T2+yEE3UaE0= =dL+W \\\",\\\"keyServer\\\":\\\"pgp.mit.edu\\\",\\\"docHash\\\":\\\"130c1c886ee18db83c8aa192fa77a202aa71e9909ffe54dd1d91e0dccab62132\\\",\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"verifiedSubmitterEmail\\\":\\\"olaf.zumpe@gmail.com\\\"}\"},\"name\":\"CMakeCache.txt\",\"submittedAt\":1535492831166,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"3ae818382701c40fc80bcbf5eeeadf0ea749edf41921f042894fc04399c9a20d\",\"insertedIntoBlockchainAt\":1535492893110,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true},{\"retrievalId\":\"ri2199635a3a4937f266b9d00915b0c9527d85f21da9bf0888c07e04794003fb2072be816\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEOQ01ha2VDYWNoZS50eHQBGGFwcGxpY2F0aW9uL29jdGV0LXN0cmVhbQiCEHsic2lnbmF0dXJlIjoiIGlRSXpCQUVCQ0FBZEZpRUVmTFlBdjNhcFF6bmg1Q2l2T1dVVFh6eUorcFVGQWx1RnZSMEFDZ2tRT1dVVFh6eUogK3BVY0x3Ly9WV2R2bXpvOVJiTTI5UDJRSWowdlkwMTdoUzhPcWZiSVVmU2lWZ3I2KytoZ3dCclhrVStlc0dTRSBjSWsrcEJXc0djSGlrQnlVRUVmbFUwNWVvWHRFV3h2dWttT2UrM2E1bXNycDdwOHFMVFI4MVFqdy9RVDkxN2JQIFY4Q0xEaVd1VkRKWjBCSEF4MzYwRityYUlhMXpKMFR4eFoyYitJMHMwUC9pZGxNcWswRnFONS9ZOVVkUHBoU2oga2Mram9acEI3dlFydkNSMFpSYjQwVFNWOU93a2tjcUl0R0hRdmtjdU9YRVJWMEd0OE82S3RsRklIaTVjTUE4TSBELzZ2TVdiVWEwbFptMHdBN2FsMmpZbEZpMkNkQVJJNjI3dmxaSHcyRUhBMTBlcDIwaGZHbHc4ZlZydGRZOWhKIExjd3pGbDg2VnoydXZBeUZTekViem1PdW90REpKRzByNXRMWk1MVVNHcHI1MlRZZWxDcUpnR0xxWnNuL3kxSTcgZEhiSVdWVEp2Sm5CdXY4NXNvUFMxNHcwdG15VlN5eXNCNkIxbXlCSXB0dlB4VHdjTWV5dTJEeWxMQW1hM3N0WCArTkhrYmh3RURNR1Ztc2JMazEwYjRMTGVCM011S2FRbWNIYmo5b3lmVklqbDhDaUFJeDBnNEV4Q0pFSy9QV2FGIFFPTkwyQXZRdTZNbUUrWEcrN3NUa1dZM0RvR0RHbkFRYUZGU0tUWW41amFLUEhXdXZnMkQ1bjA3Yi8zMlluS3MgTWVFYmk1WTd4dUNkK3ZPSG9kYlduWXdNQksyb2VCVDZaeEJvTktZRUpGc2FUTWwrVnJBSCs1c0Z5MTBwY0RMbiBmcDVNdlhuR3pnRy9ZTWJ6V0JHVHdOU2cwcGpHTGZDdmkzUlBpVHhFVzRqdlpUbFVOMXM9ID1qR1ViICIsImtleVNlcnZlciI6InBncC5taXQuZWR1IiwiZG9jSGFzaCI6WzE5LDEyLDI4LC0xMjAsMTEwLC0zMSwtMTE1LC03Miw2MCwtMTE4LC05NSwtMTEwLC02LDExOSwtOTQsMiwtODYsMTEzLC0yMywtMTEyLC05NywtMiw4NCwtMzUsMjksLTExMSwtMzIsLTM2LC01NCwtNzQsMzMsNTBdLCJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJ2ZXJpZmllZFN1Ym1pdHRlckVtYWlsIjoib2xhZi56dW1wZUBnbWFpbC5jb20ifQG+A1NUBRQBBwABE0NNYWtlQ2FjaGUudHh0Lm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAAWRiZjFlYmRiZTBmNTI2Y2IyYmZhMjg3YzBkZGYxNjk1MmRlZTI1Y2I4NjVkZTEzMTJjM2IwYzFhNDhkM2ZmYTWyveGmsFkBRb6XQJGRS85s0rKp0FGJmSeOK63niU/QJO5TLtACzFYDEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIEtRc7f8lugCrz9XgPbAjHugZ8bM9FcRu9GR5AG/eiA1QGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABZGJmMWViZGJlMGY1MjZjYjJiZmEyODdjMGRkZjE2OTUyZGVlMjVjYjg2NWRlMTMxMmMzYjBjMWE0OGQzZmZhNbK94aawWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgJFvpdAkZFLzmzSsqnQUYmZJ44rreeJT9Ak7lMu0ALMVgS1Fzt/yW6AKvP1eA9sCMe6Bnxsz0VxG70ZHkAb96IDVAY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri219963632c7f4442238445afec31293d5af83a43cbb369f004bf6eeba7e39d16b56a2f4\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAETQ01ha2VDYWNoZS50eHQubWV0YQEbYXBwbGljYXRpb24vY3J5cHRvd2Vyay1tZXRhBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABZGJmMWViZGJlMGY1MjZjYjJiZmEyODdjMGRkZjE2OTUyZGVlMjVjYjg2NWRlMTMxMmMzYjBjMWE0OGQzZmZhNbK94aawWQFFvpdAkZFLzmzSsqnQUYmZJ44rreeJT9Ak7lMu0ALMVgMTDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgS1Fzt/yW6AKvP1eA9sCMe6Bnxsz0VxG70ZHkAb96IDVAY=\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"dbf1ebdbe0f526cb2bfa287c0ddf16952dee25cb865de1312c3b0c1a48d3ffa5\",\"insertedIntoBlockchainAt\":1535491452786,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"signature\\\":\\\" iQIzBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluFvR0ACgkQOWUTXzyJ +pUcLw//VWdvmzo9RbM29P2QIj0vY017hS8OqfbIUfSiVgr6++hgwBrXkU+esGSE cIk+pBWsGcHikByUEEflU05eoXtEWxvukmOe+3a5msrp7p8qLTR81Qjw/QT917bP V8CLDiWuVDJZ0BHAx360F+raIa1zJ0TxxZ2b+I0s0P/idlMqk0FqN5/Y9UdPphSj kc+joZpB7vQrvCR0ZRb40TSV9OwkkcqItGHQvkcuOXERV0Gt8O6KtlFIHi5cMA8M D/6vMWbUa0lZm0wA7al2jYlFi2CdARI627vlZHw2EHA10ep20hfGlw8fVrtdY9hJ LcwzFl86Vz2uvAyFSzEbzmOuotDJJG0r5tLZMLUSGpr52TYelCqJgGLqZsn/y1I7 dHbIWVTJvJnBuv85soPS14w0tmyVSyysB6B1myBIptvPxTwcMeyu2DylLAma3stX +NHkbhwEDMGVmsbLk10b4LLeB3MuKaQmcHbj9oyfVIjl8CiAIx0g4ExCJEK/PWaF QONL2AvQu6MmE+XG+7sTkWY3DoGDGnAQaFFSKTYn5jaKPHWuvg2D5n07b/32YnKs MeEbi5Y7xuCd+vOHodbWnYwMBK2oeBT6ZxBoNKYEJFsaTMl+VrAH+5sFy10pcDLn fp5MvXnGzgG/YMbzWBGTwNSg0pjGLfCvi3RPiTxEW4jvZTlUN1s= =jGUb \\\",\\\"keyServer\\\":\\\"pgp.mit.edu\\\",\\\"docHash\\\":[19,12,28,-120,110,-31,-115,-72,60,-118,-95,-110,-6,119,-94,2,-86,113,-23,-112,-97,-2,84,-35,29,-111,-32,-36,-54,-74,33,50],\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"verifiedSubmitterEmail\\\":\\\"olaf.zumpe@gmail.com\\\"}\"},\"name\":\"CMakeCache.txt\",\"submittedAt\":1535491422581,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"dbf1ebdbe0f526cb2bfa287c0ddf16952dee25cb865de1312c3b0c1a48d3ffa5\",\"insertedIntoBlockchainAt\":1535491452786,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true},{\"retrievalId\":\"ri2179949c32bcc46560c9542cf0e48f981d0f26a6633ebbcedc9a96e3482416de1011b09\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEuQ01ha2VDYWNoZS50eHQsIHNlYWxlZCBieSBvbGFmLnp1bXBlQGdtYWlsLmNvbQEYYXBwbGljYXRpb24vb2N0ZXQtc3RyZWFtCLIMeyJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJzaWduYXR1cmUiOiIgaVFJeUJBRUJDQUFkRmlFRWZMWUF2M2FwUXpuaDVDaXZPV1VUWHp5SitwVUZBbHVBNFJRQUNna1FPV1VUWHp5SiArcFhKbEEvNDVSTndUbldDaVMvcXZ5UmRzQ0huMmUxSXQ3UFJKT3E4ODhQQjVucm8vN045czhWWU90d0sxMDY3IER6QWNod2c2NWRuV2ZFdjNPR2dQQ0hpWEoycDJyNU83MXFDVDdML1hHSWVFMHZaaWV4OXA4bm1DcGkrNU5rUTcgK01oV1RQSnBaTHZBZm1USUhQa0ZNdXhDaG5abnFXNkNCdDkvYVBPL0RNdjgvUm1OenRId0ZMUnVVVWs3YVI4TSBVaWg4TzFNRDE2eG40anZVOHAwKzdjOVpTNVZuL0ZsWnY0MzRzVE5abU9iWFNaV3RDbWJubVlzeERCa0ZQZXpuIGZzV2hwM29WMXVQTC9tTW8ya0V3UERZbElVaFFBWEI1QTZyalpmNHZEUk1zaHppQ3pFUWMxWnFTcHpYN2hxZGMgaDVGUm5xdGdHS3Q3aFZqNzlyZytCYkRSOXZ5STFpS0dTQXNybVRwcjdlU2E1bTJSWEFrMnJwU3FXKzJjOGxVNiB3aksxUTBzWkk3SmdOQUZXWmI3dHhqNDJJUEFxYW90aEJpVFZuWXp0Z1I4alMwV2dpR2k4OUlyNFl2YlIvbzBzIC82MWx2czhjUGIwU21jdmFhNWtNeHY2UFVyVUtOZXFYazJoQUg1YlZ5RU9uZ3p5SW9CQWFOUm5DUDMxWStZeEUgakIzdEEwTFVZWFkwYXczOGhwV3k5WnhXUVFPTHQ5bWM0ZTJTRVNmbzJ0WmY4SDRvVEMrZ0RWNk5uNEVZeGdVbyA2UUZTTVlsanY5Sk9nTDVpYmdnSkpWbkJVNUxmaXp3bVh2N3Z2dzhkcDg1MW9nblRCS3lRNkRzSCs0a01qZGQ5IEh3OXVOZGZlem8rOTUyTzdkQ1pVWTdBZkRMWHBvekU3aUdUS0xOSXllS3JYc2FuZ2JBPT0gPW8wUlggIn0BngRTVAUUAQcAATNDTWFrZUNhY2hlLnR4dCwgc2VhbGVkIGJ5IG9sYWYuenVtcGVAZ21haWwuY29tLm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAATdmOTA2ZWY3MWJjNDUxMjA4ZWUxM2NmOWExM2EyZjc1ZDUyM2M3YzQ3ZTkyMWQ5YTMzNjQzN2JjZGJiMTgyOTGRvZWbrlkBNfzYEUM+hG7s2B0CgNtmxOol97xLK9zIAeoxRshI02UDEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIExSDasFDkL9O2/vdUzKY1F0Rw1FK5xWcO6dLBbM+/5tsGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABN2Y5MDZlZjcxYmM0NTEyMDhlZTEzY2Y5YTEzYTJmNzVkNTIzYzdjNDdlOTIxZDlhMzM2NDM3YmNkYmIxODI5MZG9lZuuWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgI1/NgRQz6EbuzYHQKA22bE6iX3vEsr3MgB6jFGyEjTZQTFINqwUOQv07b+91TMpjUXRHDUUrnFZw7p0sFsz7/m2wY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri2179950c388f94e32bd565762546d33015b9a901efd9c6cade59cda6bee0678d4024123\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEzQ01ha2VDYWNoZS50eHQsIHNlYWxlZCBieSBvbGFmLnp1bXBlQGdtYWlsLmNvbS5tZXRhARthcHBsaWNhdGlvbi9jcnlwdG93ZXJrLW1ldGEFCk11bHRpY2hhaW4MbWNjcnlwdG93ZXJrgAE3ZjkwNmVmNzFiYzQ1MTIwOGVlMTNjZjlhMTNhMmY3NWQ1MjNjN2M0N2U5MjFkOWEzMzY0MzdiY2RiYjE4Mjkxkb2Vm65ZATX82BFDPoRu7NgdAoDbZsTqJfe8SyvcyAHqMUbISNNlAxMMHIhu4Y24PIqhkvp3ogKqcemQn/5U3R2R4NzKtiEyBMUg2rBQ5C/Ttv73VMymNRdEcNRSucVnDunSwWzPv+bbBg==\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"7f906ef71bc451208ee13cf9a13a2f75d523c7c47e921d9a336437bcdbb18291\",\"insertedIntoBlockchainAt\":1535210860369,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"signature\\\":\\\" iQIyBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluA4RQACgkQOWUTXzyJ +pXJlA/45RNwTnWCiS/qvyRdsCHn2e1It7PRJOq888PB5nro/7N9s8VYOtwK1067 DzAchwg65dnWfEv3OGgPCHiXJ2p2r5O71qCT7L/XGIeE0vZiex9p8nmCpi+5NkQ7 +MhWTPJpZLvAfmTIHPkFMuxChnZnqW6CBt9/aPO/DMv8/RmNztHwFLRuUUk7aR8M Uih8O1MD16xn4jvU8p0+7c9ZS5Vn/FlZv434sTNZmObXSZWtCmbnmYsxDBkFPezn fsWhp3oV1uPL/mMo2kEwPDYlIUhQAXB5A6rjZf4vDRMshziCzEQc1ZqSpzX7hqdc h5FRnqtgGKt7hVj79rg+BbDR9vyI1iKGSAsrmTpr7eSa5m2RXAk2rpSqW+2c8lU6 wjK1Q0sZI7JgNAFWZb7txj42IPAqaothBiTVnYztgR8jS0WgiGi89Ir4YvbR/o0s /61lvs8cPb0Smcvaa5kMxv6PUrUKNeqXk2hAH5bVyEOngzyIoBAaNRnCP31Y+YxE jB3tA0LUYXY0aw38hpWy9ZxWQQOLt9mc4e2SESfo2tZf8H4oTC+gDV6Nn4EYxgUo 6QFSMYljv9JOgL5ibggJJVnBU5LfizwmXv7vvw8dp851ognTBKyQ6DsH+4kMjdd9 Hw9uNdfezo+952O7dCZUY7AfDLXpozE7iGTKLNIyeKrXsangbA== =o0RX \\\"}\"},\"name\":\"CMakeCache.txt, sealed by olaf.zumpe@gmail.com\",\"submittedAt\":1535172960448,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"7f906ef71bc451208ee13cf9a13a2f75d523c7c47e921d9a336437bcdbb18291\",\"insertedIntoBlockchainAt\":1535210860369,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true}],\"minSupportedAPIVersion\":1}");
+  auto docs = ret_json["documents"];
+  if (docs != nullptr)
+  {
+    int found = docs.size();
+    if (found)
+    {
+      // print out details for the document what blockchain(s), transaction(s), time registered
+      // Verification (traverse SmartStamp(s), verify signature, if it is there)!
+      // the documents are verified concurrently (each one may wait for gpg), the output is printed in order
+      vector<stringstream> outputs(docs.size());
+      vector<exception_ptr> errors(docs.size());
+      vector<vector<size_t>> matched(docs.size());
+      vector<char> assigned(docs.size(), 0);
+      file_index.clear();
+      for (size_t i = 0; i < file_hashes.size(); i++)
+      {
+        // files with the same content share the documents of their hash
+        file_index[file_hashes[i]].push_back(i);
+      }
+      prefetch_keys(docs);
+      parallel_for(docs.size(), [this, &docs, &outputs, &errors, &matched, &assigned](size_t i)
+      {
+        try
+        {
+          assigned[i] = verify_document(docs[i], outputs[i], matched[i]);
+        }
+        catch (...)
+        {
+          errors[i] = current_exception();
+        }
+      });
+      if (!ndjson)
+      {
+        cout << "A file with the same hash as \"" << registered_names(matched)
+             << "\" has been registered with Cryptowerk " << found << " time(s)." << endl;
+        cout << "Details:" << endl;
+      }
+      for (size_t i = 0; i < outputs.size(); i++)
+      {
+        if (!ndjson)
+        {
+          cout << outputs[i].str();
+        }
+        if (errors[i])
+        {
+          rethrow_exception(errors[i]);
+        }
+      }
+      if (!bundle && file_names.size() > 1)
+      {
+        report_unregistered(matched, assigned);
+      }
+    }
+    else if (ndjson)
+    {
+      for (size_t i = 0; i < file_names.size(); i++)
+      {
+        json record;
+        record["file"]       = file_names[i];
+        record["hash"]       = file_hashes[i];
+        record["registered"] = false;
+        write_record(record);
+      }
+    }
+    else
+    {
+      cout << endl << "This file has not been registered with Cryptowerk." << endl;
+    }
+  }
+  else
+  {
+    throw cealr_exception(__FILE__, __LINE__, "Unexpected answer from server: \"" + ret_json.dump() + "\"");
+  }
+}
+
+bool cealr::verify_document(json &doc, ostream &out, vector<size_t> &matched)
 {
-  const json &ret_json = verify_seal();
-//  const json &ret_json = json::parse("{\"maxSupportedAPIVersion\":5,\"documents\":[{\"retrievalId\":\"ri21728553502aace61892c04cb822308ace41937c2afa38acaabdda08ac56207cae7c3e3\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEOQ01ha2VDYWNoZS50eHQBGGFwcGxpY2F0aW9uL29jdGV0LXN0cmVhbQiJD3sic2lnbmF0dXJlIjoiIGlRSXpCQUVCQ0FBZEZpRUVmTFlBdjNhcFF6bmg1Q2l2T1dVVFh6eUorcFVGQWx1SFB6TUFDZ2tRT1dVVFh6eUogK3BVUU1BLy9hM3hSbWxFRjdYa21MT09aWjhnQTVRT1ZybytNazRVS0xjZWh4cXViYkRENER4Y0RBaEtFcXkzcyAwV3dRVXR3TkY5MldtaElWeHVLMVdaOUU1c0p0d0pERnYyemRrK1Uwc1JCbFFzZW85SHgzOVVWcENhQWNGTEk3IEp6dmE5Mk8zcTlUUGZxblFXeGdWaVpGNFdlWm9tOFJTYVlaRkJWUXpIUkticEIzNTRLVGw2UFVRS2R5TnhtcXEgdEp6UWlXREhISDF5RThiNE12WXdwb2NYR0VYc1ZoanZReVhpMjdhNmpiQVlkWmllVmVubkQ0MWZiZjJBelluQSBYVDhQWG5Way8yTktxMEc2VnhhY01KU0dvTDd4Wk9QR0RXOVVJVW9NZFNGck9haXQzQlBFWU5GOHoveXJncE5KIFpqWE5CZ2NBMFZheU50MjVtSHdDSEVZSitWWW1sWmcxZWdVYTFmWW56Zng5bkN5NDhnTEo5VlZyM1hBaTA5WVYgUWJQZVRZYi9maGZUU1hZc0pVcjlBUTFsNG1YL2s2NlE1T01zNWJKRnpKZkFZS0R6eGdvcFZMTFlrdzRDMkdqUiBYUUJkK0hBdW4yeUdaVjdIS2NzTC83Wk0zZDcyTzllaEFrVWlVYXNONWZCVm5LTkpYQ1dYNi8rc2VRb29JbjdnIFBVSE1PSEtGV1BidmlWWkdhZlNZMkEybE83OVZFOE1BUmV2RE9oMHRsNkRmc0UwTEw5VXVwLytkRmMxUjRRSFQgditFT2lWNURuY1NSRDJNQkwrWURJTHM1T3NjVzNJSVJxSHNDY0YwMTB6aVNnaUZOZHpMNDNjVnI1VEQ2TE56cyBnWmlEcDNBZkZYV3FYWnFxSzMyQzVKcjFZSEJ1UWVqTStLYkMrTE1lY1YrR1FLdE5Kb009ID1QS1JGICIsImtleVNlcnZlciI6InBncC5taXQuZWR1IiwiZG9jSGFzaCI6IjEzMGMxYzg4NmVlMThkYjgzYzhhYTE5MmZhNzdhMjAyYWE3MWU5OTA5ZmZlNTRkZDFkOTFlMGRjY2FiNjIxMzIiLCJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJ2ZXJpZmllZFN1Ym1pdHRlckVtYWlsIjoib2xhZi56dW1wZUBnbWFpbC5jb20ifQG+A1NUBRQBBwABE0NNYWtlQ2FjaGUudHh0Lm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAAWJhYzViYzI0YzBiNTE1Yjk4ZWQ0MjhlYWNmN2MyMDBkNjFhMDUyNmZkOWIyNzJjMTQyNjE1YmEyZDM0NmMzMTCi2fqEsVkBJ8llKDLpbb8ZhIBoR+o1lIeBRWobnTfnjLHGkOMR5hMDEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIEZSKroLW/eRrXFas+nr7+uZRfn9dyhtt1KDu0VgRmewYGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABYmFjNWJjMjRjMGI1MTViOThlZDQyOGVhY2Y3YzIwMGQ2MWEwNTI2ZmQ5YjI3MmMxNDI2MTViYTJkMzQ2YzMxMKLZ+oSxWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgInyWUoMultvxmEgGhH6jWUh4FFahudN+eMscaQ4xHmEwRlIqugtb95GtcVqz6evv65lF+f13KG23UoO7RWBGZ7BgY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri21728562f2d8793cafdf5ab1dcc13a0c69995f288bd3de3541a44d263500ff9f68afa03\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAETQ01ha2VDYWNoZS50eHQubWV0YQEbYXBwbGljYXRpb24vY3J5cHRvd2Vyay1tZXRhBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABYmFjNWJjMjRjMGI1MTViOThlZDQyOGVhY2Y3YzIwMGQ2MWEwNTI2ZmQ5YjI3MmMxNDI2MTViYTJkMzQ2YzMxMKLZ+oSxWQEnyWUoMultvxmEgGhH6jWUh4FFahudN+eMscaQ4xHmEwMTDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgRlIqugtb95GtcVqz6evv65lF+f13KG23UoO7RWBGZ7BgY=\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"bac5bc24c0b515b98ed428eacf7c200d61a0526fd9b272c142615ba2d346c310\",\"insertedIntoBlockchainAt\":1535590225506,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"signature\\\":\\\" iQIzBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluHPzMACgkQOWUTXzyJ +pUQMA//a3xRmlEF7XkmLOOZZ8gA5QOVro+Mk4UKLcehxqubbDD4DxcDAhKEqy3s 0WwQUtwNF92WmhIVxuK1WZ9E5sJtwJDFv2zdk+U0sRBlQseo9Hx39UVpCaAcFLI7 Jzva92O3q9TPfqnQWxgViZF4WeZom8RSaYZFBVQzHRKbpB354KTl6PUQKdyNxmqq tJzQiWDHHH1yE8b4MvYwpocXGEXsVhjvQyXi27a6jbAYdZieVennD41fbf2AzYnA XT8PXnVk/2NKq0G6VxacMJSGoL7xZOPGDW9UIUoMdSFrOait3BPEYNF8z/yrgpNJ ZjXNBgcA0VayNt25mHwCHEYJ+VYmlZg1egUa1fYnzfx9nCy48gLJ9VVr3XAi09YV QbPeTYb/fhfTSXYsJUr9AQ1l4mX/k66Q5OMs5bJFzJfAYKDzxgopVLLYkw4C2GjR XQBd+HAun2yGZV7HKcsL/7ZM3d72O9ehAkUiUasN5fBVnKNJXCWX6/+seQooIn7g PUHMOHKFWPbviVZGafSY2A2lO79VE8MARevDOh0tl6DfsE0LL9Uup/+dFc1R4QHT v+EOiV5DncSRD2MBL+YDILs5OscW3IIRqHsCcF010ziSgiFNdzL43cVr5TD6LNzs gZiDp3AfFXWqXZqqK32C5Jr1YHBuQejM+KbC+LMecV+GQKtNJoM= =PKRF \\\",\\\"keyServer\\\":\\\"pgp.mit.edu\\\",\\\"docHash\\\":\\\"130c1c886ee18db83c8aa192fa77a202aa71e9909ffe54dd1d91e0dccab62132\\\",\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"verifiedSubmitterEmail\\\":\\\"olaf.zumpe@gmail.com\\\"}\"},\"name\":\"CMakeCache.txt\",\"submittedAt\":1535590203615,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"bac5bc24c0b515b98ed428eacf7c200d61a0526fd9b272c142615ba2d346c310\",\"insertedIntoBlockchainAt\":1535590225506,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true},{\"retrievalId\":\"ri213018397ae2f7960d0efc668c40209a565d384b4e3aac440995d63c073078b3e9f08c8\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEOQ01ha2VDYWNoZS50eHQBGGFwcGxpY2F0aW9uL29jdGV0LXN0cmVhbQiJD3sic2lnbmF0dXJlIjoiIGlRSXpCQUVCQ0FBZEZpRUVmTFlBdjNhcFF6bmg1Q2l2T1dVVFh6eUorcFVGQWx1RndsUUFDZ2tRT1dVVFh6eUogK3BXeWlBLy9meXZkdkJpUmljdWRnWWF1VWdtN1lqLzNwVzc2SS8ySGVXc2k5OHE2aFM3bGhYdU5BNGJrMW90ZSA0WFAwRDNiVmRnRGF0UUFBRmorcDlzejFwQUlYYnVQNVpJOEExMW9EK0JZbGRJYm1UUUEzSXR5YkhZMjVtckhEIFJKdTVBOCtmcDhBVUFIUUhXR0xlb0RMWVJDWERrd3NuYXBWMHpVR29QT2g2dUxHbUZldlo5QzY3QWhGWVNyRSsga1hLT2o1SWN1NTVYTVRCM1pxbWZ2ZTZPOXVIaG5Va3M1NUFBZkNIQm94ZHpvV2FUSFc0UGZsTWpPWHBrdVpBSSA5dE1YenFZZXpTTy9SeS9kZUJKdE9jaHNwU0xlaUFlLzZxSllNL0sxOEttNEZZMkQxdFIyNFFBcXY2YWNzMnlIIDNZb09zWXYxOTQ1eGw2VUpPeFJ6QzY1anlzRDlORkxxeXVrK0JKUWIwWlBXQnVWckF2TlYybzEydjYyWmdTbEUgVzJTOVZYNmZ3d3AwV211ZXFIZ1hWVmJsdkx5Uzl4MksvaWZXR2tESkxQTHlmNWs2dEEwYzFnSkZOc1hYbit4UCBzeUdqNmdEQk9EYjMxYncwOCtMVlhSWTVzaldzNGQrK3Fxc05Mdno2MWxYVGdsSG5SUE0xbEJrbkMveW92emZ2IHN4RE40RWlDR05vakEyOUgreFVBL1VZVUc5WTdKMVdQQUR2NXBZU3VKb1JIM1FXd2tEV2RyS3ZrQ3JwYzdLTVggMy85azIyYVBoMmFMSjBOLzdwc2xuZUpaSytMTUNGSmJNb0IwRFNmVmhicjR0bEMvc0Z2WTQ1UXhGL0pSaTNaUSAyZlNjcFBZQzY4akpIVFlPM2FwMk54K0Y5VStKckNmVVkzWUFUMGYrVDIreUVFM1VhRTA9ID1kTCtXICIsImtleVNlcnZlciI6InBncC5taXQuZWR1IiwiZG9jSGFzaCI6IjEzMGMxYzg4NmVlMThkYjgzYzhhYTE5MmZhNzdhMjAyYWE3MWU5OTA5ZmZlNTRkZDFkOTFlMGRjY2FiNjIxMzIiLCJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJ2ZXJpZmllZFN1Ym1pdHRlckVtYWlsIjoib2xhZi56dW1wZUBnbWFpbC5jb20ifQG+A1NUBRQBBwABE0NNYWtlQ2FjaGUudHh0Lm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAATNhZTgxODM4MjcwMWM0MGZjODBiY2JmNWVlZWFkZjBlYTc0OWVkZjQxOTIxZjA0Mjg5NGZjMDQzOTljOWEyMGS2ppGosFkBKl8dpcuGqGpnsbEnZjQuNn2uf5dmNTkW+NuXjdZ1dU8DEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIE8pYOpQlrDndt+SJWnpp2FNruuU+QpIcbH8Dz/19/vTsGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABM2FlODE4MzgyNzAxYzQwZmM4MGJjYmY1ZWVlYWRmMGVhNzQ5ZWRmNDE5MjFmMDQyODk0ZmMwNDM5OWM5YTIwZLamkaiwWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgIqXx2ly4aoamexsSdmNC42fa5/l2Y1ORb425eN1nV1TwTylg6lCWsOd235IlaemnYU2u65T5CkhxsfwPP/X3+9OwY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri21301840d2b6615d83281a20fc227369e11fe70c87a8314a943573c80f2e7a7aae46038\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAETQ01ha2VDYWNoZS50eHQubWV0YQEbYXBwbGljYXRpb24vY3J5cHRvd2Vyay1tZXRhBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABM2FlODE4MzgyNzAxYzQwZmM4MGJjYmY1ZWVlYWRmMGVhNzQ5ZWRmNDE5MjFmMDQyODk0ZmMwNDM5OWM5YTIwZLamkaiwWQEqXx2ly4aoamexsSdmNC42fa5/l2Y1ORb425eN1nV1TwMTDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgTylg6lCWsOd235IlaemnYU2u65T5CkhxsfwPP/X3+9OwY=\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"3ae818382701c40fc80bcbf5eeeadf0ea749edf41921f042894fc04399c9a20d\",\"insertedIntoBlockchainAt\":1535492893110,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"signature\\\":\\\" iQIzBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluFwlQACgkQOWUTXzyJ +pWyiA//fyvdvBiRicudgYauUgm7Yj/3pW76I/2HeWsi98q6hS7lhXuNA4bk1ote 4XP0D3bVdgDatQAAFj+p9sz1pAIXbuP5ZI8A11oD+BYldIbmTQA3ItybHY25mrHD RJu5A8+fp8AUAHQHWGLeoDLYRCXDkwsnapV0zUGoPOh6uLGmFevZ9C67AhFYSrE+ kXKOj5Icu55XMTB3Zqmfve6O9uHhnUks55AAfCHBoxdzoWaTHW4PflMjOXpkuZAI 9tMXzqYezSO/Ry/deBJtOchspSLeiAe/6qJYM/K18Km4FY2D1tR24QAqv6acs2yH 3YoOsYv1945xl6UJOxRzC65jysD9NFLqyuk+BJQb0ZPWBuVrAvNV2o12v62ZgSlE W2S9VX6fwwp0WmueqHgXVVblvLyS9x2K/ifWGkDJLPLyf5k6tA0c1gJFNsXXn+xP syGj6gDBODb31bw08+LVXRY5sjWs4d++qqsNLvz61lXTglHnRPM1lBknC/yovzfv sxDN4EiCGNojA29H+xUA/UYUG9Y7J1WPADv5pYSuJoRH3QWwkDWdrKvkCrpc7KMX 3/9k22aPh2aLJ0N/7pslneJZK+LMCFJbMoB0DSfVhbr4tlC/sFvY45QxF/JRi3ZQ 2fScpPYC68jJHTYO3ap2Nx+F9U+JrCfUY3YAT0f+T2+yEE3UaE0= =dL+W \\\",\\\"keyServer\\\":\\\"pgp.mit.edu\\\",\\\"docHash\\\":\\\"130c1c886ee18db83c8aa192fa77a202aa71e9909ffe54dd1d91e0dccab62132\\\",\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"verifiedSubmitterEmail\\\":\\\"olaf.zumpe@gmail.com\\\"}\"},\"name\":\"CMakeCache.txt\",\"submittedAt\":1535492831166,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"3ae818382701c40fc80bcbf5eeeadf0ea749edf41921f042894fc04399c9a20d\",\"insertedIntoBlockchainAt\":1535492893110,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true},{\"retrievalId\":\"ri2199635a3a4937f266b9d00915b0c9527d85f21da9bf0888c07e04794003fb2072be816\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEOQ01ha2VDYWNoZS50eHQBGGFwcGxpY2F0aW9uL29jdGV0LXN0cmVhbQiCEHsic2lnbmF0dXJlIjoiIGlRSXpCQUVCQ0FBZEZpRUVmTFlBdjNhcFF6bmg1Q2l2T1dVVFh6eUorcFVGQWx1RnZSMEFDZ2tRT1dVVFh6eUogK3BVY0x3Ly9WV2R2bXpvOVJiTTI5UDJRSWowdlkwMTdoUzhPcWZiSVVmU2lWZ3I2KytoZ3dCclhrVStlc0dTRSBjSWsrcEJXc0djSGlrQnlVRUVmbFUwNWVvWHRFV3h2dWttT2UrM2E1bXNycDdwOHFMVFI4MVFqdy9RVDkxN2JQIFY4Q0xEaVd1VkRKWjBCSEF4MzYwRityYUlhMXpKMFR4eFoyYitJMHMwUC9pZGxNcWswRnFONS9ZOVVkUHBoU2oga2Mram9acEI3dlFydkNSMFpSYjQwVFNWOU93a2tjcUl0R0hRdmtjdU9YRVJWMEd0OE82S3RsRklIaTVjTUE4TSBELzZ2TVdiVWEwbFptMHdBN2FsMmpZbEZpMkNkQVJJNjI3dmxaSHcyRUhBMTBlcDIwaGZHbHc4ZlZydGRZOWhKIExjd3pGbDg2VnoydXZBeUZTekViem1PdW90REpKRzByNXRMWk1MVVNHcHI1MlRZZWxDcUpnR0xxWnNuL3kxSTcgZEhiSVdWVEp2Sm5CdXY4NXNvUFMxNHcwdG15VlN5eXNCNkIxbXlCSXB0dlB4VHdjTWV5dTJEeWxMQW1hM3N0WCArTkhrYmh3RURNR1Ztc2JMazEwYjRMTGVCM011S2FRbWNIYmo5b3lmVklqbDhDaUFJeDBnNEV4Q0pFSy9QV2FGIFFPTkwyQXZRdTZNbUUrWEcrN3NUa1dZM0RvR0RHbkFRYUZGU0tUWW41amFLUEhXdXZnMkQ1bjA3Yi8zMlluS3MgTWVFYmk1WTd4dUNkK3ZPSG9kYlduWXdNQksyb2VCVDZaeEJvTktZRUpGc2FUTWwrVnJBSCs1c0Z5MTBwY0RMbiBmcDVNdlhuR3pnRy9ZTWJ6V0JHVHdOU2cwcGpHTGZDdmkzUlBpVHhFVzRqdlpUbFVOMXM9ID1qR1ViICIsImtleVNlcnZlciI6InBncC5taXQuZWR1IiwiZG9jSGFzaCI6WzE5LDEyLDI4LC0xMjAsMTEwLC0zMSwtMTE1LC03Miw2MCwtMTE4LC05NSwtMTEwLC02LDExOSwtOTQsMiwtODYsMTEzLC0yMywtMTEyLC05NywtMiw4NCwtMzUsMjksLTExMSwtMzIsLTM2LC01NCwtNzQsMzMsNTBdLCJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJ2ZXJpZmllZFN1Ym1pdHRlckVtYWlsIjoib2xhZi56dW1wZUBnbWFpbC5jb20ifQG+A1NUBRQBBwABE0NNYWtlQ2FjaGUudHh0Lm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAAWRiZjFlYmRiZTBmNTI2Y2IyYmZhMjg3YzBkZGYxNjk1MmRlZTI1Y2I4NjVkZTEzMTJjM2IwYzFhNDhkM2ZmYTWyveGmsFkBRb6XQJGRS85s0rKp0FGJmSeOK63niU/QJO5TLtACzFYDEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIEtRc7f8lugCrz9XgPbAjHugZ8bM9FcRu9GR5AG/eiA1QGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABZGJmMWViZGJlMGY1MjZjYjJiZmEyODdjMGRkZjE2OTUyZGVlMjVjYjg2NWRlMTMxMmMzYjBjMWE0OGQzZmZhNbK94aawWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgJFvpdAkZFLzmzSsqnQUYmZJ44rreeJT9Ak7lMu0ALMVgS1Fzt/yW6AKvP1eA9sCMe6Bnxsz0VxG70ZHkAb96IDVAY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri219963632c7f4442238445afec31293d5af83a43cbb369f004bf6eeba7e39d16b56a2f4\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAETQ01ha2VDYWNoZS50eHQubWV0YQEbYXBwbGljYXRpb24vY3J5cHRvd2Vyay1tZXRhBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABZGJmMWViZGJlMGY1MjZjYjJiZmEyODdjMGRkZjE2OTUyZGVlMjVjYjg2NWRlMTMxMmMzYjBjMWE0OGQzZmZhNbK94aawWQFFvpdAkZFLzmzSsqnQUYmZJ44rreeJT9Ak7lMu0ALMVgMTDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgS1Fzt/yW6AKvP1eA9sCMe6Bnxsz0VxG70ZHkAb96IDVAY=\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"dbf1ebdbe0f526cb2bfa287c0ddf16952dee25cb865de1312c3b0c1a48d3ffa5\",\"insertedIntoBlockchainAt\":1535491452786,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"signature\\\":\\\" iQIzBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluFvR0ACgkQOWUTXzyJ +pUcLw//VWdvmzo9RbM29P2QIj0vY017hS8OqfbIUfSiVgr6++hgwBrXkU+esGSE cIk+pBWsGcHikByUEEflU05eoXtEWxvukmOe+3a5msrp7p8qLTR81Qjw/QT917bP V8CLDiWuVDJZ0BHAx360F+raIa1zJ0TxxZ2b+I0s0P/idlMqk0FqN5/Y9UdPphSj kc+joZpB7vQrvCR0ZRb40TSV9OwkkcqItGHQvkcuOXERV0Gt8O6KtlFIHi5cMA8M D/6vMWbUa0lZm0wA7al2jYlFi2CdARI627vlZHw2EHA10ep20hfGlw8fVrtdY9hJ LcwzFl86Vz2uvAyFSzEbzmOuotDJJG0r5tLZMLUSGpr52TYelCqJgGLqZsn/y1I7 dHbIWVTJvJnBuv85soPS14w0tmyVSyysB6B1myBIptvPxTwcMeyu2DylLAma3stX +NHkbhwEDMGVmsbLk10b4LLeB3MuKaQmcHbj9oyfVIjl8CiAIx0g4ExCJEK/PWaF QONL2AvQu6MmE+XG+7sTkWY3DoGDGnAQaFFSKTYn5jaKPHWuvg2D5n07b/32YnKs MeEbi5Y7xuCd+vOHodbWnYwMBK2oeBT6ZxBoNKYEJFsaTMl+VrAH+5sFy10pcDLn fp5MvXnGzgG/YMbzWBGTwNSg0pjGLfCvi3RPiTxEW4jvZTlUN1s= =jGUb \\\",\\\"keyServer\\\":\\\"pgp.mit.edu\\\",\\\"docHash\\\":[19,12,28,-120,110,-31,-115,-72,60,-118,-95,-110,-6,119,-94,2,-86,113,-23,-112,-97,-2,84,-35,29,-111,-32,-36,-54,-74,33,50],\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"verifiedSubmitterEmail\\\":\\\"olaf.zumpe@gmail.com\\\"}\"},\"name\":\"CMakeCache.txt\",\"submittedAt\":1535491422581,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"dbf1ebdbe0f526cb2bfa287c0ddf16952dee25cb865de1312c3b0c1a48d3ffa5\",\"insertedIntoBlockchainAt\":1535491452786,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true},{\"retrievalId\":\"ri2179949c32bcc46560c9542cf0e48f981d0f26a6633ebbcedc9a96e3482416de1011b09\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEuQ01ha2VDYWNoZS50eHQsIHNlYWxlZCBieSBvbGFmLnp1bXBlQGdtYWlsLmNvbQEYYXBwbGljYXRpb24vb2N0ZXQtc3RyZWFtCLIMeyJrZXlJZCI6IjM5NjUxMzVGM0M4OUZBOTUiLCJzaWduYXR1cmUiOiIgaVFJeUJBRUJDQUFkRmlFRWZMWUF2M2FwUXpuaDVDaXZPV1VUWHp5SitwVUZBbHVBNFJRQUNna1FPV1VUWHp5SiArcFhKbEEvNDVSTndUbldDaVMvcXZ5UmRzQ0huMmUxSXQ3UFJKT3E4ODhQQjVucm8vN045czhWWU90d0sxMDY3IER6QWNod2c2NWRuV2ZFdjNPR2dQQ0hpWEoycDJyNU83MXFDVDdML1hHSWVFMHZaaWV4OXA4bm1DcGkrNU5rUTcgK01oV1RQSnBaTHZBZm1USUhQa0ZNdXhDaG5abnFXNkNCdDkvYVBPL0RNdjgvUm1OenRId0ZMUnVVVWs3YVI4TSBVaWg4TzFNRDE2eG40anZVOHAwKzdjOVpTNVZuL0ZsWnY0MzRzVE5abU9iWFNaV3RDbWJubVlzeERCa0ZQZXpuIGZzV2hwM29WMXVQTC9tTW8ya0V3UERZbElVaFFBWEI1QTZyalpmNHZEUk1zaHppQ3pFUWMxWnFTcHpYN2hxZGMgaDVGUm5xdGdHS3Q3aFZqNzlyZytCYkRSOXZ5STFpS0dTQXNybVRwcjdlU2E1bTJSWEFrMnJwU3FXKzJjOGxVNiB3aksxUTBzWkk3SmdOQUZXWmI3dHhqNDJJUEFxYW90aEJpVFZuWXp0Z1I4alMwV2dpR2k4OUlyNFl2YlIvbzBzIC82MWx2czhjUGIwU21jdmFhNWtNeHY2UFVyVUtOZXFYazJoQUg1YlZ5RU9uZ3p5SW9CQWFOUm5DUDMxWStZeEUgakIzdEEwTFVZWFkwYXczOGhwV3k5WnhXUVFPTHQ5bWM0ZTJTRVNmbzJ0WmY4SDRvVEMrZ0RWNk5uNEVZeGdVbyA2UUZTTVlsanY5Sk9nTDVpYmdnSkpWbkJVNUxmaXp3bVh2N3Z2dzhkcDg1MW9nblRCS3lRNkRzSCs0a01qZGQ5IEh3OXVOZGZlem8rOTUyTzdkQ1pVWTdBZkRMWHBvekU3aUdUS0xOSXllS3JYc2FuZ2JBPT0gPW8wUlggIn0BngRTVAUUAQcAATNDTWFrZUNhY2hlLnR4dCwgc2VhbGVkIGJ5IG9sYWYuenVtcGVAZ21haWwuY29tLm1ldGEBG2FwcGxpY2F0aW9uL2NyeXB0b3dlcmstbWV0YQUKTXVsdGljaGFpbgxtY2NyeXB0b3dlcmuAATdmOTA2ZWY3MWJjNDUxMjA4ZWUxM2NmOWExM2EyZjc1ZDUyM2M3YzQ3ZTkyMWQ5YTMzNjQzN2JjZGJiMTgyOTGRvZWbrlkBNfzYEUM+hG7s2B0CgNtmxOol97xLK9zIAeoxRshI02UDEwwciG7hjbg8iqGS+neiAqpx6ZCf/lTdHZHg3Mq2ITIExSDasFDkL9O2/vdUzKY1F0Rw1FK5xWcO6dLBbM+/5tsGBQpNdWx0aWNoYWluDG1jY3J5cHRvd2Vya4ABN2Y5MDZlZjcxYmM0NTEyMDhlZTEzY2Y5YTEzYTJmNzVkNTIzYzdjNDdlOTIxZDlhMzM2NDM3YmNkYmIxODI5MZG9lZuuWQETDByIbuGNuDyKoZL6d6ICqnHpkJ/+VN0dkeDcyrYhMgI1/NgRQz6EbuzYHQKA22bE6iX3vEsr3MgB6jFGyEjTZQTFINqwUOQv07b+91TMpjUXRHDUUrnFZw7p0sFsz7/m2wY=\"}],\"registrarInfo\":{\"organization\":\"test\"},\"sealedMetaData\":{\"retrievalId\":\"ri2179950c388f94e32bd565762546d33015b9a901efd9c6cade59cda6bee0678d4024123\",\"smartStamps\":[{\"data\":\"U1QFFAEHAAEzQ01ha2VDYWNoZS50eHQsIHNlYWxlZCBieSBvbGFmLnp1bXBlQGdtYWlsLmNvbS5tZXRhARthcHBsaWNhdGlvbi9jcnlwdG93ZXJrLW1ldGEFCk11bHRpY2hhaW4MbWNjcnlwdG93ZXJrgAE3ZjkwNmVmNzFiYzQ1MTIwOGVlMTNjZjlhMTNhMmY3NWQ1MjNjN2M0N2U5MjFkOWEzMzY0MzdiY2RiYjE4Mjkxkb2Vm65ZATX82BFDPoRu7NgdAoDbZsTqJfe8SyvcyAHqMUbISNNlAxMMHIhu4Y24PIqhkvp3ogKqcemQn/5U3R2R4NzKtiEyBMUg2rBQ5C/Ttv73VMymNRdEcNRSucVnDunSwWzPv+bbBg==\"}],\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"7f906ef71bc451208ee13cf9a13a2f75d523c7c47e921d9a336437bcdbb18291\",\"insertedIntoBlockchainAt\":1535210860369,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"content\":\"{\\\"keyId\\\":\\\"3965135F3C89FA95\\\",\\\"signature\\\":\\\" iQIyBAEBCAAdFiEEfLYAv3apQznh5CivOWUTXzyJ+pUFAluA4RQACgkQOWUTXzyJ +pXJlA/45RNwTnWCiS/qvyRdsCHn2e1It7PRJOq888PB5nro/7N9s8VYOtwK1067 DzAchwg65dnWfEv3OGgPCHiXJ2p2r5O71qCT7L/XGIeE0vZiex9p8nmCpi+5NkQ7 +MhWTPJpZLvAfmTIHPkFMuxChnZnqW6CBt9/aPO/DMv8/RmNztHwFLRuUUk7aR8M Uih8O1MD16xn4jvU8p0+7c9ZS5Vn/FlZv434sTNZmObXSZWtCmbnmYsxDBkFPezn fsWhp3oV1uPL/mMo2kEwPDYlIUhQAXB5A6rjZf4vDRMshziCzEQc1ZqSpzX7hqdc h5FRnqtgGKt7hVj79rg+BbDR9vyI1iKGSAsrmTpr7eSa5m2RXAk2rpSqW+2c8lU6 wjK1Q0sZI7JgNAFWZb7txj42IPAqaothBiTVnYztgR8jS0WgiGi89Ir4YvbR/o0s /61lvs8cPb0Smcvaa5kMxv6PUrUKNeqXk2hAH5bVyEOngzyIoBAaNRnCP31Y+YxE jB3tA0LUYXY0aw38hpWy9ZxWQQOLt9mc4e2SESfo2tZf8H4oTC+gDV6Nn4EYxgUo 6QFSMYljv9JOgL5ibggJJVnBU5LfizwmXv7vvw8dp851ognTBKyQ6DsH+4kMjdd9 Hw9uNdfezo+952O7dCZUY7AfDLXpozE7iGTKLNIyeKrXsangbA== =o0RX \\\"}\"},\"name\":\"CMakeCache.txt, sealed by olaf.zumpe@gmail.com\",\"submittedAt\":1535172960448,\"contentType\":\"application/octet-stream\",\"hasBeenInsertedIntoAtLeastOneBlockchain\":true,\"blockchainRegistrations\":[{\"blockChainId\":\"7f906ef71bc451208ee13cf9a13a2f75d523c7c47e921d9a336437bcdbb18291\",\"insertedIntoBlockchainAt\":1535210860369,\"blockChainDesc\":{\"instanceName\":\"mccryptowerk\",\"generalName\":\"Multichain\"}}],\"hasBeenInsertedIntoAllRequestedBlockchains\":true}],\"minSupportedAPIVersion\":1}");
-  auto docs = ret_json["documents"];
-  if (docs != nullptr)
+  const auto started = chrono::steady_clock::now();
+  auto elapsed_ms = [&started]()
   {
-    int found = docs.size();
-    if (found)
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - started).count() / 1000.0;
+  };
+  string doc_name = doc["name"];
+  // fields shared by the records of all files of this registration
+  json registration;
+  registration["registered"]  = true;
+  registration["name"]        = doc_name;
+  registration["submittedAt"] = doc["submittedAt"];
+  if (doc.count("retrievalId"))
+  {
+    registration["retrievalId"] = doc["retrievalId"];
+  }
+  out << "Submitted at " << format_time(doc["submittedAt"], "%H:%M:%ST%Y-%m-%d");
+  if (doc_name.empty())
+  {
+    out << " without name";
+  }
+  else if (file_names.size() > 1 && doc_name.find(',') != string::npos)
+  {
+    // the files of the registration are printed with their results, a registration of a batch lists thousands of them
+    out << " as a registration of " << count(doc_name.begin(), doc_name.end(), ',') + 1 << " files";
+  }
+  else
+  {
+    out << " as " << doc_name;
+  }
+  out << endl;
+  //todo implement minimalistic server response for better scalability
+//  auto bc_regs = doc["blockchainRegistrations"];
+//  if (bc_regs != NULL)
+//  {
+//    for (auto bcReg:bc_regs)
+//    {
+//      auto bcDesc = bcReg["blockChainDesc"];
+//      auto bc = bcDesc["generalName"];
+//      auto instance = bcDesc["instanceName"];
+//      out << " put into blockchain: " << bc << ":" << instance << " at "
+//           << format_time(bcReg["insertedIntoBlockchainAt"], "%H:%M:%ST%Y-%m-%d")
+//           << ", Transaction ID: " << bcReg["blockChainId"] << endl;
+//    }
+//  }
+//  else
+//  {
+//    out << endl << "There was no blockchain registration for this file." << endl;
+//  }
+  //todo minimize server response to one smart stamp
+//  verify_metadata(doc);
+  const auto smartStamps = doc["smartStamps"];
+  if (smartStamps!= nullptr)
+  {
+    const auto sObj = smartStamps[0];
+    string smartStampTextualRepresentation = sObj["data"];
+    SmartStamp smartStamp(smartStampTextualRepresentation);
+    smartStamp.initFields();
+    auto bc = smartStamp.getBlockchain();
+    auto bcDesc = bc->getBlockChainDesc()->toString();
+    // todo: output verification value (SW+root hash) to verify it in bc browser
+    out << " Registered with blockchain: " << bcDesc << " at "
+        << format_time(bc->getInsertedIntoBlockchainAt(), "%H:%M:%ST%Y-%m-%d")
+        << ", Transaction ID: " << bc->getBlockChainId() << endl;
+    registration["blockchain"]               = bcDesc;
+    registration["insertedIntoBlockchainAt"] = bc->getInsertedIntoBlockchainAt();
+    registration["transactionId"]            = bc->getBlockChainId();
+    // and analyze metadata from document smart stamp
+    verify_metadata(smartStamp, out, ndjson ? &registration : nullptr);
+
+    if (bundle)
     {
-      cout << "A file with the same hash as \"" << doc_names << " has been registered with Cryptowerk " << found
-           << " time(s)." << endl;
-      cout << "Details:" << endl;
-      // print out details for the document what blockchain(s), transaction(s), time registered
-      // Verification (traverse SmartStamp(s), verify signature, if it is there)!
-      for (auto &doc : docs)
+      // compose the SmartStamp of each file from its path in the bundle and the SmartStamp of the root
+      for (size_t i = 0; i < file_names.size(); i++)
       {
-        string doc_name = doc["name"];
-        cout << "Submitted at " << format_time(doc["submittedAt"], "%H:%M:%ST%Y-%m-%d");
-        if (doc_name.empty())
+        vector<char> *raw = bundle->compose_stamp(smartStamp, static_cast<size_t>(bundle_leaves[i]));
+        SmartStamp fileStamp(*raw);
+        delete raw;
+        out << " " << file_names[i] << ": ";
+        const unsigned char *leaf = bundle->leaf(static_cast<size_t>(bundle_leaves[i]));
+        const bool verified       = print_verification_result(fileStamp, leaf, out);
+        if (verbose)
         {
-          cout << " without name";
+          out << " SmartStamp: " << base64::encode(*fileStamp.toRawData()) << endl;
         }
-        else
+        if (ndjson)
         {
-          cout << " as " << doc_name;
+          json record = registration;
+          record["file"]     = file_names[i];
+          record["hash"]     = to_hex(leaf, SHA256_DIGEST_LENGTH);
+          record["verified"] = verified;
+          record["timings"]  = {{"verifyMs", elapsed_ms()}};
+          write_record(record);
         }
-        cout << endl;
-        //todo implement minimalistic server response for better scalability
-//        auto bc_regs = doc["blockchainRegistrations"];
-//        if (bc_regs != NULL)
-//        {
-//          for (auto bcReg:bc_regs)
-//          {
-//            auto bcDesc = bcReg["blockChainDesc"];
-//            auto bc = bcDesc["generalName"];
-//            auto instance = bcDesc["instanceName"];
-//            cout << " put into blockchain: " << bc << ":" << instance << " at "
-//                 << format_time(bcReg["insertedIntoBlockchainAt"], "%H:%M:%ST%Y-%m-%d")
-//                 << ", Transaction ID: " << bcReg["blockChainId"] << endl;
-//          }
-//        }
-//        else
-//        {
-//          cout << endl << "There was no blockchain registration for this file." << endl;
-//        }
-        //todo minimize server response to one smart stamp
-//        verify_metadata(doc);
-        const auto smartStamps = doc["smartStamps"];
-        if (smartStamps!= nullptr)
+      }
+    }
+    else
+    {
+      // with several files the document belongs to the files with the hash in its SmartStamp
+      const auto match = file_index.find(to_hex(smartStamp.getDocHash(), SHA256_DIGEST_LENGTH));
+      if (match == file_index.end() && file_names.size() > 1)
+      {
+        out << " The hash in the smart stamp does not match any of the files." << endl;
+        return false;
+      }
+      matched = match == file_index.end() ? vector<size_t>(1, 0) : match->second;
+      for (size_t i:matched)
+      {
+        if (file_names.size() > 1)
         {
-          const auto sObj = smartStamps[0];
-          string smartStampTextualRepresentation = sObj["data"];
-          SmartStamp smartStamp(smartStampTextualRepresentation);
-          smartStamp.initFields();
-          auto bc = smartStamp.getBlockchain();
-          auto bcDesc = bc->getBlockChainDesc()->toString();
-          // todo: output verification value (SW+root hash) to verify it in bc browser
-          cout << " Registered with blockchain: " << bcDesc << " at "
-               << format_time(bc->getInsertedIntoBlockchainAt(), "%H:%M:%ST%Y-%m-%d")
-               << ", Transaction ID: " << bc->getBlockChainId() << endl;
-          // and analyze metadata from document smart stamp
-          verify_metadata(smartStamp);
-
-          vector<char> hash = from_hex(hex_hashes);
-          // todo if root is retrievable by bc call with:
-          // SmartStamp::VerificationResult verificationResult=smartStamp.verifyByHash((unsigned char *) &(hash[0]), anchorInBlockchain, nullptr, true);
-          SmartStamp::VerificationResult *verificationResult = smartStamp.verifyByHash((unsigned char *) &(hash[0]), nullptr, true);
-            if (verificationResult->hasBeenVerified())
-            {
-              cout << "The verification of the smart stamp was successful" << endl;
-            }
-            else
-            {
-              cout << "The hash of the file does not match the stored hash in the smart stamp. Verification failed!" << endl;
-            }
+          out << " " << file_names[i] << ": ";
         }
-        else
+        vector<char> hash   = from_hex(file_hashes[i]);
+        const bool verified = print_verification_result(smartStamp, (unsigned char *) &(hash[0]), out);
+        if (ndjson)
         {
-          cout << endl << "There was no blockchain registration for this file." << endl;
+          json record = registration;
+          record["file"]     = file_names[i];
+          record["hash"]     = file_hashes[i];
+          record["verified"] = verified;
+          record["timings"]  = {{"verifyMs", elapsed_ms()}};
+          write_record(record);
         }
       }
     }
+    return true;
+  }
+  else
+  {
+    out << endl << "There was no blockchain registration for this file." << endl;
+    if (ndjson && (bundle || file_names.size() == 1))
+    {
+      for (size_t i = 0; i < file_names.size(); i++)
+      {
+        json record = registration;
+        record["file"]     = file_names[i];
+        record["hash"]     = file_hashes[i];
+        record["verified"] = false;
+        record["timings"]  = {{"verifyMs", elapsed_ms()}};
+        write_record(record);
+      }
+    }
+    else if (ndjson)
+    {
+      // without SmartStamp the document cannot be assigned to one of several files
+      registration["verified"] = false;
+      registration["timings"]  = {{"verifyMs", elapsed_ms()}};
+      write_record(registration);
+    }
+  }
+  return false;
+}
+
+string cealr::registered_names(const vector<vector<size_t>> &matched) const
+{
+  if (bundle || file_names.size() == 1)
+  {
+    return doc_names;
+  }
+  vector<bool> registered(file_names.size(), false);
+  for (const vector<size_t> &files:matched)
+  {
+    for (size_t i:files)
+    {
+      registered[i] = true;
+    }
+  }
+  string names;
+  for (size_t i = 0; i < file_names.size(); i++)
+  {
+    if (registered[i])
+    {
+      append_doc_name(names, file_names[i], nullptr);
+    }
+  }
+  return names.empty() ? doc_names : names;
+}
+
+void cealr::report_unregistered(const vector<vector<size_t>> &matched, const vector<char> &assigned)
+{
+  vector<bool> registered(file_names.size(), false);
+  for (size_t document = 0; document < matched.size(); document++)
+  {
+    if (!assigned[document])
+    {
+      // a document that could not be assigned to a file may belong to any of them
+      return;
+    }
+    for (size_t i:matched[document])
+    {
+      registered[i] = true;
+    }
+  }
+  for (size_t i = 0; i < file_names.size(); i++)
+  {
+    if (registered[i])
+    {
+      continue;
+    }
+    if (ndjson)
+    {
+      json record;
+      record["file"]       = file_names[i];
+      record["hash"]       = file_hashes[i];
+      record["registered"] = false;
+      write_record(record);
+    }
     else
     {
-      cout << endl << "This file has not been registered with Cryptowerk." << endl;
+      cout << " " << file_names[i] << ": This file has not been registered with Cryptowerk." << endl;
     }
   }
+}
+
+void cealr::write_record(const json &record)
+{
+  if (record_sink)
+  {
+    lock_guard<mutex> lock(output_mutex);
+    record_sink(record);
+    return;
+  }
+  const string line = record.dump();
+  lock_guard<mutex> lock(output_mutex);
+  cout << line << '\n';
+  cout.flush();
+}
+
+bool cealr::print_verification_result(SmartStamp &smartStamp, const unsigned char *hash, ostream &out)
+{
+  // todo if root is retrievable by bc call with:
+  // SmartStamp::VerificationResult verificationResult=smartStamp.verifyByHash((unsigned char *) &(hash[0]), anchorInBlockchain, nullptr, true);
+  SmartStamp::VerificationResult *verificationResult = smartStamp.verifyByHash((unsigned char *) hash, nullptr, true);
+  const bool verified = verificationResult->hasBeenVerified();
+  if (verified)
+  {
+    out << "The verification of the smart stamp was successful" << endl;
+  }
   else
   {
-    cerr << "unexpected answer from server: \"" << ret_json.dump() << "\"" << endl;
+    out << "The hash of the file does not match the stored hash in the smart stamp. Verification failed!" << endl;
   }
+  delete verificationResult;
+  return verified;
 }
 
-void cealr::verify_metadata(SmartStamp &smartStamp)
+void cealr::verify_metadata(SmartStamp &smartStamp, ostream &out, json *record)
 {
   auto sealed_meta_data = smartStamp.getSealedMetaData();
   if (sealed_meta_data != nullptr)
   {
+    json metadata   = json::array();
+    json signatures = json::array();
     const auto sealedContent = *sealed_meta_data->getData();
     auto content = json::parse(sealedContent); // keep string to build hash
     // check hash of sealed_meta_data, output verification info of sealed metadata
@@ -479,7 +1299,9 @@ void cealr::verify_metadata(SmartStamp &smartStamp)
     {
       SmartStamp smartStampMeta(smStamp);
       SmartStamp::VerificationResult *md_verified = smartStampMeta.verifyByHash(metadataHash, nullptr, false);
-      if (md_verified->hasBeenVerified())
+      const bool md_valid = md_verified->hasBeenVerified();
+      delete md_verified;
+      if (md_valid)
       {
         auto bc = smartStampMeta.getBlockchain();
         auto bcDesc = bc->getBlockChainDesc()->toString();
@@ -488,93 +1310,362 @@ void cealr::verify_metadata(SmartStamp &smartStamp)
         regDat.append(to_hex(_sw, 2));
         auto str = to_hex(smartStampMeta.getRootHash(), SHA256_DIGEST_LENGTH);
         regDat.append(str);
-        cout << " Metadata is valid and must have been registered with blockchain: " << bcDesc << " at "
-             << format_time(bc->getInsertedIntoBlockchainAt(), "%H:%M:%ST%Y-%m-%d")
-             << ", Transaction ID: " << bc->getBlockChainId() << endl
-             << " Please verify that the data in this transaction is \"" << regDat << "\"." << endl;
+        out << " Metadata is valid and must have been registered with blockchain: " << bcDesc << " at "
+            << format_time(bc->getInsertedIntoBlockchainAt(), "%H:%M:%ST%Y-%m-%d")
+            << ", Transaction ID: " << bc->getBlockChainId() << endl
+            << " Please verify that the data in this transaction is \"" << regDat << "\"." << endl;
+        metadata.push_back({{"verified",                 true},
+                            {"blockchain",               bcDesc},
+                            {"insertedIntoBlockchainAt", bc->getInsertedIntoBlockchainAt()},
+                            {"transactionId",            bc->getBlockChainId()},
+                            {"transactionData",          regDat}});
       }
       else
       {
-        cout << "The hash over the meta data does not match the hash in the meta data smart stamp. Verification failed. The data seems to be corrupted." << endl;
-        return;
+        // the mismatch is recorded, the signatures are still checked below
+        out << "The hash over the meta data does not match the hash in the meta data smart stamp. Verification failed. The data seems to be corrupted." << endl;
+        metadata.push_back({{"verified", false}});
       }
     }
 
     if (hasJson)
     {
       // verification and output of authenticity/signer
-      if (content.count("signature"))
+      if (content.count("manifestSignature"))
+      {
+        verify_manifest_membership(smartStamp, content, out, signatures);
+      }
+      else if (content.count("signature") || content.count("signatures"))
       {
-        string signature = content["signature"];
+        // a registration of several signed files contains one signature per file, matched by the name of the file
+        // (path relative to the root of the tree for files sealed with --recursive)
+        vector<pair<string, string>> signed_files_sigs;
+        if (content.count("signatures"))
+        {
+          map<string, string> sig_by_name;
+          for (const auto &entry:content["signatures"])
+          {
+            sig_by_name[entry["name"]] = entry["signature"];
+          }
+          const vector<string> files = signed_files();
+          const vector<string> names = signed_file_names();
+          for (size_t i = 0; i < files.size(); i++)
+          {
+            const auto sig = sig_by_name.find(names[i]);
+            if (sig != sig_by_name.end())
+            {
+              signed_files_sigs.emplace_back(files[i], sig->second);
+            }
+          }
+        }
+        else
+        {
+          for (const string &file_name:signed_files())
+          {
+            signed_files_sigs.emplace_back(file_name, content["signature"]);
+          }
+        }
         if (verbose)
         {
-          cout << endl << "The metadata contains a signature of a file. Trying to verify it ..." << endl << endl;
+          out << endl << "The metadata contains a signature of a file. Trying to verify it ..." << endl << endl;
         }
         string key_id = content["keyId"];
         open_pgp open_pgp(GPGME_SIG_MODE_DETACH, p_properties);
-        for (const string &file_name:file_names)
+        open_pgp.set_interactive(interactive);
+        for (auto &file_sig:signed_files_sigs)
         {
-          json verification_js = open_pgp.verify(file_name, &signature);
+          const string &file_name = file_sig.first;
+          json verification_js = open_pgp.verify(file_name, &file_sig.second);
           if (verbose)
           {
-            cout << verification_js.dump(2, ' ', false) << endl;
+            out << verification_js.dump(2, ' ', false) << endl;
           }
           bool is_valid = verification_js["isValid"];
-          cout << "The signature of \"" << file_name << "\" is " << (is_valid ? "matching" : "not matching")
-               << " the stored signature on the server." << endl;
+          out << "The signature of \"" << file_name << "\" is " << (is_valid ? "matching" : "not matching")
+              << " the stored signature on the server." << endl;
+          json signature_record = {{"file", file_name}, {"valid", is_valid}, {"keyId", key_id}};
           if (is_valid)
           {
-            cout << "The file was signed on " << format_time(verification_js["timestamp"], "%H:%M:%ST%Y-%m-%d")
-                 << " with the key with ID " << key_id << endl;
-            auto name = verification_js["name"];
-            if (name != nullptr)
-            {
-              cout << "The signing key was issued by " << verification_js["name"] << endl;
-            }
-            else
-            {
-              cout << "The signing key has no name" << endl;
-            }
-            string signature_email = verification_js["email"];
-            cout << "The email address in the signing key is " << signature_email;
-            auto submitter_email = content["verifiedSubmitterEmail"];
-            if (submitter_email != nullptr && (submitter_email == signature_email))
-            {
-              cout
-                  << " and matches the verified email address of the CryptoWerk customer who submitted this file for sealing.";
-            }
-            else
-            {
-              cout << endl
-                   << "However. The verified email address of the CryptoWerk customer who submitted this file for sealing is "
-                   << submitter_email;
-            }
-            cout << endl << endl;
+            print_signer(verification_js, content, key_id, out, signature_record);
           }
+          signatures.push_back(signature_record);
         }
       }
     }
     else
     {
-      cout << "Metadata has valid tata in it. It cannot be verified by this cealr version" << endl;
+      out << "Metadata has valid tata in it. It cannot be verified by this cealr version" << endl;
+    }
+    if (record)
+    {
+      (*record)["metadata"]   = metadata;
+      (*record)["signatures"] = signatures;
+    }
+  }
+}
+
+void cealr::prefetch_keys(const json &docs)
+{
+  set<string> key_ids;
+  bool signed_docs = false;
+  mutex key_ids_mutex;
+  parallel_for(docs.size(), [&docs, &key_ids, &signed_docs, &key_ids_mutex](size_t i)
+  {
+    try
+    {
+      const json &smart_stamps = docs[i].at("smartStamps");
+      const string data        = smart_stamps.at(0).at("data");
+      SmartStamp smartStamp(data);
+      smartStamp.initFields();
+      auto sealed_meta_data = smartStamp.getSealedMetaData();
+      if (sealed_meta_data)
+      {
+        const json content = json::parse(*sealed_meta_data->getData());
+        lock_guard<mutex> lock(key_ids_mutex);
+        signed_docs = signed_docs || content.count("signature") || content.count("signatures") ||
+                      content.count("manifestSignature");
+        if (content.count("keyId") && content["keyId"].is_string())
+        {
+          key_ids.insert(content["keyId"].get<string>());
+        }
+      }
+    }
+    catch (...)
+    {
+      // reported when the document is verified
+    }
+  });
+  if (!signed_docs)
+  {
+    // gpg is not needed to verify documents without signatures
+    return;
+  }
+  // contexts are created by the verifying threads, gpgme has to be initialized before
+  open_pgp::init_engine();
+  if (!key_ids.empty())
+  {
+    open_pgp open_pgp(GPGME_SIG_MODE_DETACH, p_properties);
+    open_pgp.set_interactive(interactive);
+    open_pgp.prefetch_keys(key_ids);
+  }
+}
+
+void cealr::verify_manifest_membership(SmartStamp &smartStamp, json &content, ostream &out, json &signatures)
+{
+  // the files of this document: all files of a bundle or the file with the hash of the document
+  vector<size_t> files;
+  if (bundle)
+  {
+    for (size_t i = 0; i < file_names.size(); i++)
+    {
+      files.push_back(i);
+    }
+  }
+  else
+  {
+    const auto match = file_index.find(to_hex(smartStamp.getDocHash(), SHA256_DIGEST_LENGTH));
+    if (match != file_index.end())
+    {
+      files = match->second;
+    }
+  }
+  const string signature     = content["manifestSignature"];
+  const string key_id        = content["keyId"];
+  const string manifest_hash = content.value("manifestHash", string());
+  const signed_manifest *manifest;
+  json verification_js;
+  {
+    // the manifest is shared by all documents of the registration, it is fetched and verified only once
+    lock_guard<mutex> lock(manifests_mutex);
+    const string key = manifest_hash + " " + signature;
+    auto found = manifests.find(key);
+    if (found == manifests.end())
+    {
+      string manifest_text;
+      bool   matching;
+      if (content.count("manifest"))
+      {
+        // registrations of older versions contain the manifest itself
+        manifest_text = content["manifest"];
+        istringstream manifest_stream(manifest_text);
+        matching = manifest_hash.empty() || getHashAsHex(manifest_stream) == manifest_hash;
+      }
+      else
+      {
+        matching = !manifest_hash.empty() && fetch_manifest(manifest_hash, manifest_text);
+      }
+      if (!matching)
+      {
+        manifest_text.clear();
+      }
+      found = manifests.emplace(key, signed_manifest(manifest_text)).first;
+      if (matching)
+      {
+        if (verbose)
+        {
+          out << endl << "The metadata refers to a signed manifest of " << found->second.size()
+              << " file(s). Trying to verify it ..." << endl << endl;
+        }
+        string sig = signature;
+        open_pgp open_pgp(GPGME_SIG_MODE_DETACH, p_properties);
+        open_pgp.set_interactive(interactive);
+        manifest_verifications[key] = open_pgp.verify_data(manifest_text, &sig);
+      }
+      else
+      {
+        out << "The signed manifest with the hash " << manifest_hash
+            << " has not been found or does not match its hash." << endl;
+        manifest_verifications[key] = {{"isValid", false}};
+      }
+    }
+    manifest        = &found->second;
+    verification_js = manifest_verifications[key];
+  }
+  if (verbose)
+  {
+    out << verification_js.dump(2, ' ', false) << endl;
+  }
+  const bool is_sig_valid = verification_js["isValid"];
+  for (size_t i:files)
+  {
+    const bool listed = manifest->contains(signed_names[i], file_hashes[i]);
+    const bool is_valid = listed && is_sig_valid;
+    out << "The file \"" << file_names[i] << "\" is " << (listed ? "listed" : "not listed")
+        << " in the signed manifest, the signature of the manifest is " << (is_sig_valid ? "matching" : "not matching")
+        << " the stored signature on the server." << endl;
+    json signature_record = {{"file", file_names[i]}, {"valid", is_valid}, {"keyId", key_id}, {"manifest", true},
+                             {"listed", listed}};
+    if (is_valid)
+    {
+      print_signer(verification_js, content, key_id, out, signature_record);
     }
+    signatures.push_back(signature_record);
+  }
+}
+
+void cealr::print_signer(const json &verification_js, const json &content, const string &key_id, ostream &out,
+                         json &signature_record) const
+{
+  out << "The file was signed on " << format_time(verification_js["timestamp"], "%H:%M:%ST%Y-%m-%d")
+      << " with the key with ID " << key_id << endl;
+  const auto name = verification_js.count("name") ? verification_js["name"] : json();
+  if (name != nullptr)
+  {
+    out << "The signing key was issued by " << name << endl;
+  }
+  else
+  {
+    out << "The signing key has no name" << endl;
+  }
+  const string signature_email = verification_js.value("email", string());
+  out << "The email address in the signing key is " << signature_email;
+  const auto submitter_email = content.count("verifiedSubmitterEmail") ? content["verifiedSubmitterEmail"] : json();
+  signature_record["timestamp"]      = verification_js["timestamp"];
+  signature_record["name"]           = name;
+  signature_record["email"]          = signature_email;
+  signature_record["submitterEmail"] = submitter_email;
+  signature_record["emailMatches"]   = submitter_email != nullptr && submitter_email == signature_email;
+  if (submitter_email != nullptr && (submitter_email == signature_email))
+  {
+    out << " and matches the verified email address of the CryptoWerk customer who submitted this file for sealing.";
   }
+  else
+  {
+    out << endl
+        << "However. The verified email address of the CryptoWerk customer who submitted this file for sealing is "
+        << submitter_email;
+  }
+  out << endl << endl;
 }
 
-json cealr::seal_file(const open_pgp *open_pgp_sign) const
+json cealr::seal_file(const json *sealed_meta_data) const
 {
   json json;
-  json["name"] = doc_names;
-  json["lookupInfo"] = doc_names;
-  json["contentType"] = *new string("application/octet-stream");
+  json["contentType"] = "application/octet-stream";
   json["store"] = true; //
-    json["hashes"] = hex_hashes;
   json["publiclyRetrievable"] = true;
-  if (open_pgp_sign)
+  if (sealed_meta_data)
   {
-    json["sealedMetaDataJson"] = open_pgp_sign->toJson();
+    json["sealedMetaDataJson"] = *sealed_meta_data;
     // json["sealedMetaData"] = open_pgp_sign->toJson().dump(); // submitting as string
   }
+  // names and hashes of large batches are serialized while they are sent instead of being copied into the json
+  json_stream_body body(json);
+  body.add_string("name", doc_names);
+  body.add_string("lookupInfo", doc_names);
+  if (bundle_file)
+  {
+    body.add_string("hashes", hex_hashes);
+  }
+  else
+  {
+    body.add_list("hashes", file_hashes.size(), [this](size_t i, string &buffer)
+    {
+      buffer.append(file_hashes[i]);
+    });
+  }
+  return post_registration(body);
+}
+
+json cealr::seal_manifest(const string &manifest, const string &manifest_hash) const
+{
+  json json;
+  json["contentType"]         = "text/plain";
+  json["store"]               = true;
+  json["publiclyRetrievable"] = true;
+  json["sealedMetaDataJson"]  = {{"manifest", manifest}};
+  json_stream_body body(json);
+  const string name = MANIFEST_DOC_NAME;
+  body.add_string("name", name);
+  body.add_string("lookupInfo", name);
+  body.add_string("hashes", manifest_hash);
+  return post_registration(body);
+}
+
+bool cealr::fetch_manifest(const string &manifest_hash, string &manifest) const
+{
+  auto docs = verify_hashes(MANIFEST_DOC_NAME, manifest_hash)["documents"];
+  if (docs == nullptr)
+  {
+    return false;
+  }
+  for (auto &doc:docs)
+  {
+    const auto smartStamps = doc["smartStamps"];
+    if (smartStamps == nullptr || smartStamps.empty())
+    {
+      continue;
+    }
+    const string smartStampTextualRepresentation = smartStamps[0]["data"];
+    SmartStamp smartStamp(smartStampTextualRepresentation);
+    smartStamp.initFields();
+    const auto sealed_meta_data = smartStamp.getSealedMetaData();
+    if (sealed_meta_data == nullptr)
+    {
+      continue;
+    }
+    try
+    {
+      const auto content = json::parse(*sealed_meta_data->getData());
+      const string text  = content.at("manifest");
+      // the manifest is trusted only if it has the hash the files refer to
+      istringstream manifest_stream(text);
+      if (getHashAsHex(manifest_stream) == manifest_hash)
+      {
+        manifest = text;
+        return true;
+      }
+    }
+    catch (exception &)
+    {
+      // not a sealed manifest
+    }
+  }
+  return false;
+}
+
+json cealr::post_registration(request_body &body) const
+{
   stringstream url;
   url << *server << "/API/v5/register";
   string _url = url.str();
@@ -583,19 +1674,61 @@ json cealr::seal_file(const open_pgp *open_pgp_sign) const
   api_cred_str << "X-ApiKey: " << *api_key << " " << *api_credential;
   const string api_creds = api_cred_str.str();
   curl.addHeader(api_creds);
-  string *return_data = curl.post(json);
+  string *return_data = curl.post(body);
   auto ret_json = json::parse(*return_data);
 
   return ret_json;
 }
 
+void cealr::seal_files(const vector<string> &files)
+{
+  for (const string &file:files)
+  {
+    add2hashes(file, nullptr);
+  }
+  if (file_names.empty())
+  {
+    throw print_usage_msg(cmd_name, new string("There are no files to be sealed."));
+  }
+  seal = true;
+  init_server();
+  init_from_prop_if_null(&api_key, "apiKey");
+  init_from_prop_if_null(&api_credential, "apiCredential");
+  if (!api_key || api_key->empty() || !api_credential || api_credential->empty())
+  {
+    throw cealr_exception(__FILE__, __LINE__, "The account credentials are not configured.");
+  }
+  hash_files();
+  write_sealed_records(seal_file());
+}
+
+void cealr::verify_files(const vector<string> &files)
+{
+  for (const string &file:files)
+  {
+    add2hashes(file, nullptr);
+  }
+  if (file_names.empty())
+  {
+    throw print_usage_msg(cmd_name, new string("There are no files to be verified."));
+  }
+  init_server();
+  hash_files();
+  verify();
+}
+
 json cealr::verify_seal() const
+{
+  return verify_hashes(doc_names, hex_hashes);
+}
+
+json cealr::verify_hashes(const string &names, const string &hashes) const
 {
   json json;
-  json["name"] = doc_names;
-  json["lookupInfo"] = doc_names;
+  json["name"] = names;
+  json["lookupInfo"] = names;
   json["contentType"] = *new string("application/octet-stream");
-  json["retrievalDocHash"] = hex_hashes;
+  json["retrievalDocHash"] = hashes;
   json["provideRegistrarInfo"] = true;
   stringstream url;
   url << *server << "/API/v5/verify";
@@ -672,13 +1805,29 @@ string *cealr::read_password()
                        " - set the environment variable CEALR_PASSWORD\n"
                        " - add line password=<your password>\n"
                        "   in the file \"" + p_properties->getFile() + "\"\n";
-      password = get_password(question.str(), 8, 0, 0, 0, nttyErr);
+      password = get_password(question.str(), 8, 0, 0, 0);
+      if (!password)
+      {
+        throw cealr_exception(__FILE__, __LINE__, nttyErr);
+      }
     }
   }
 
   return password;
 }
 
+void cealr::init_server()
+{
+  if (!server)
+  {
+    server = p_properties->get("server", get_env_str("CEALR_SERVER"), false);
+    if (!server)
+    {
+      server = new string(DEFAULT_SERVER);
+    }
+  }
+}
+
 void cealr::init_from_prop_if_null(string **p_string, const string key)
 {
   if (*p_string == nullptr)
@@ -714,6 +1863,10 @@ cealr::~cealr()
     delete p_properties;
     p_properties = nullptr;
   }
+  delete bundle_file;
+  delete bundle;
+  delete manifest_file;
+  delete watch_dir;
 
 }
 
@@ -743,11 +1896,11 @@ print_usage_msg::print_usage_msg() : err_msg("")
 }
 
 //  --server https://devapi1.cryptowerk.com/platform --apiKey TskZZ8Zc2QzE3G/lxvUnWPKMk27Ucd1tm9K+YSPXWww= --api8888Credential vV+2buaDD5aAcCQxCtk4WRJs+yK/BewThR1qUXikdJo=
-int main(int argc, const char **argv)
+int run_cealr(int argc, const char **argv, bool interactive)
 {
   try
   {
-    cealr cealr(argc, argv);
+    cealr cealr(argc, argv, interactive);
     cealr.run();
   } catch (print_usage_msg &e)
   {
@@ -764,27 +1917,52 @@ int main(int argc, const char **argv)
   catch (pgp_exception &e)
   {
     cerr << e.what() << endl;
-    exit(1);
+    return 1;
   }
   catch (base64_exception &e)
   {
     cerr << e.what() << endl;
-    exit(1);
+    return 1;
+  }
+  catch (hex_exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  catch (dir_walker_exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  catch (dir_watcher_exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
   }
   catch (SmartStampError &e)
   {
     cerr << e.what() << endl;
-    exit(1);
+    return 1;
   }
   catch (file_exception &e)
   {
     cerr << e.what() << endl;
-    exit(1);
+    return 1;
+  }
+  catch (curl_exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  catch (cealr_exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
   }
   catch (exception &e)
   {
     cerr << e.what() << endl;
-    exit(1);
+    return 1;
   }
+  return 0;
 }
-
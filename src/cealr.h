@@ -18,16 +18,28 @@ static const char *const DEFAULT_SERVER = "https://devapi1.cryptowerk.com/platfo
 #else
 static const char *const DEFAULT_SERVER = "http://localhost:8080/platform";
 #endif // if CMAKE_BUILD_TYPE==DEBUG
+// name of the document a signed manifest is sealed as
+static const char *const MANIFEST_DOC_NAME = "signed manifest";
 
 #include <string>
 #include <exception>
 #include <cstdlib>
 #include "properties.h"
 #include "open_pgp.h"
+#include "open_pgp_pool.h"
 #include "smart_stamp.h"
+#include "merkle_tree.h"
+#include "manifest.h"
+#include "dir_walker.h"
+#include "dir_watcher.h"
+#include "curl_util.h"
 #include <nlohmann/json.hpp>
+#include <functional>
 #include <set>
 #include <regex>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 
 using json = nlohmann::json;
 
@@ -77,6 +89,23 @@ public:
 //    ~print_usage_msg()/* _NOEXCEPT override*/;
 };
 
+/*!
+@brief exception thrown if cealr cannot continue, e.g. because the account cannot be used yet
+*/
+class cealr_exception : public exception
+{
+private:
+  runtime_error _what;
+
+public:
+  cealr_exception(const string &file, const int line, const string &errStr) : _what(("" + file + ":" + to_string(line) + ": " + errStr).c_str()) {}
+
+  const char *what()
+  {
+    return _what.what();
+  }
+};
+
 /*!
 @brief main class of the tool
 
@@ -92,25 +121,243 @@ private:
   string *api_credential;
   string *email;
   bool verbose;
+  bool ndjson;                 //!< verification results are written as one JSON record per line (option --output)
   bool register_arg_found;
   bool reg_client;
+  bool interactive;            //!< false if the user cannot be asked (daemon), account credentials must be configured
   bool seal;
   bool sign;
+  bool sign_manifest;          //!< one manifest of all files is signed instead of each file (option --sign-manifest)
   vector<string> file_names;
+  vector<string> file_hashes;  //!< hexadecimal hash for each entry in file_names
+  vector<string> signed_names; //!< name each entry in file_names is signed under, relative to its --recursive root
   string hex_hashes;
   string doc_names;
+  string *bundle_file;         //!< file with the leaves of a local Merkle tree (option --bundle)
+  merkle_tree *bundle;
+  vector<long> bundle_leaves;  //!< leaf index in bundle for each entry in file_names
+  string *manifest_file;       //!< file with the files to be sealed or verified (option --manifest)
+  bool manifest_null;          //!< entries of the manifest are NUL terminated (option --null)
+  unordered_map<string, vector<size_t>> file_index;  //!< indexes in file_names of the files with each hash
+  vector<string> recursive_dirs;  //!< directories whose files are sealed or verified (option --recursive)
+  string *watch_dir;           //!< directory tree whose new files are sealed as they arrive (option --watch)
+  dir_walker walker;
   properties *p_properties;
+  mutex output_mutex;          //!< serializes the records written by concurrent verifications
+  function<void(const json &)> record_sink;  //!< receives the records instead of cout if set (see libcealr.h)
+  map<string, signed_manifest> manifests;    //!< manifests of the verified registrations by their hash and signature
+  map<string, json> manifest_verifications;  //!< result of the verification of each manifest in manifests
+  mutex manifests_mutex;
+
+  /*!
+  @brief files of a manifest that are processed together
+  */
+  struct file_batch
+  {
+    vector<string> file_names;
+    vector<string> file_hashes;
+    vector<string> signed_names;
+    string         hex_hashes;
+    string         doc_names;
+  };
 
   void init_from_prop_if_null(string **p_string, string key);
 
+  /*!
+  @brief takes the server from the properties or CEALR_SERVER if it has not been given, DEFAULT_SERVER otherwise
+  */
+  void init_server();
+
   string *read_password();
 
-  string hash_file(string file);
+  unsigned char *hash_file(const string &file, unsigned char *md) const;
+
+  /*!
+  @brief adds a file to file_names
+
+  @param signed_name name the signature of the file is recorded under, the name without path if nullptr
+  */
+  void add2hashes(const string &file_name, const string *version, const string *signed_name = nullptr);
+
+  /*!
+  @brief appends the name under which a file is registered to the comma separated doc_names
+  */
+  static void append_doc_name(string &doc_names, const string &file_name, const string *version);
+
+  /*!
+  @brief adds the files in the directory trees given with --recursive to file_names
+  */
+  void add_tree_files();
+
+  /*!
+  @brief hashes all files in file_names on all cores
+
+  Fills file_hashes and hex_hashes. When files are sealed in a bundle, the leaves of the bundle are set as well.
+  */
+  void hash_files();
+
+  /*!
+  @brief hashes the files in names on all cores
+
+  @param hashes hexadecimal hash for each file, files with a precomputed hash are not read. Empty entries are replaced
+         with the hash of the file.
+  @param leaves if not nullptr, the threads set the hash of each file as leaf with the same index (see
+         merkle_tree::reserve_leaves())
+  @return hashes of all files, SHA256_DIGEST_LENGTH bytes each
+  */
+  vector<unsigned char> hash_files(const vector<string> &names, vector<string> &hashes,
+                                   merkle_tree *leaves = nullptr) const;
+
+  /*!
+  @brief reads up to MANIFEST_BATCH_SIZE entries from the manifest and hashes them
+
+  Does not change the state of this object, so it can run while the previous batch is submitted.
+
+  @return false if the manifest has no more entries
+  */
+  bool read_batch(manifest_reader &reader, file_batch &batch) const;
+
+  /*!
+  @brief seals or verifies all files of the manifest
+
+  The manifest is processed in batches of MANIFEST_BATCH_SIZE files, the next batch is read and hashed while the
+  current one is submitted. Memory use is independent of the size of the manifest.
+  */
+  void run_manifest();
+
+  /*!
+  @brief writes a record with the retrieval id for each sealed file of the current batch (--output ndjson)
+  */
+  void write_sealed_records(const json &ret_json);
+
+  /*!
+  @brief seals the files completed in the directory tree given with --watch until it is removed
+
+  The files are collected by a dir_watcher and sealed in batches of up to WATCH_BATCH_SIZE files, a batch is submitted
+  WATCH_BATCH_DELAY milliseconds after its first file has arrived. Files completed while a batch is hashed and
+  submitted are queued by the kernel and go into the next batch.
+  */
+  void run_watch();
+
+  /*!
+  @brief bundles all files to be sealed into one local Merkle tree
 
-  void add2hashes(const string &file_name, const string *version);
+  Writes the leaves of the tree to the bundle file (in the format of sha256sum) and replaces the hashes to be submitted
+  with the root hash of the tree, so only one hash is registered for all files.
+  */
+  void write_bundle();
+
+  /*!
+  @brief reads the bundle file and locates the files to be verified in it
+
+  Replaces the hashes to be verified with the root hash of the bundle.
+  */
+  void read_bundle();
+
+  /*!
+  @brief returns the files that are covered by the signature in the sealed meta data
+  */
+  vector<string> signed_files() const;
+
+  /*!
+  @brief returns the name each of signed_files() is signed under
+
+  Files of the trees given with --recursive are identified by their path relative to the root, so files with the same
+  name in different directories do not share a signature.
+  */
+  vector<string> signed_file_names() const;
+
+  /*!
+  @brief signs one canonical manifest of the names and hashes of all files (see signed_manifest), seals it as a
+         document of its own and seals the files with the hash and the signature of the manifest as sealed meta data
+  */
+  void seal_signed_manifest();
+
+  /*!
+  @brief seals a signed manifest as a document with the hash of the manifest, the manifest is its sealed meta data
+  */
+  json seal_manifest(const string &manifest, const string &manifest_hash) const;
+
+  /*!
+  @brief looks up the document sealed by seal_manifest()
+
+  @param manifest set to the manifest stored in the sealed meta data of the document
+  @return false if there is no document with a manifest with this hash
+  */
+  bool fetch_manifest(const string &manifest_hash, string &manifest) const;
+
+  /*!
+  @brief verifies the signature of a signed manifest and checks if the files of a SmartStamp are listed in it
+
+  The manifest is looked up by the manifestHash in the meta data and accepted only if it has this hash. It is fetched
+  and its signature is verified once, the result is shared by all documents of the registration.
+  */
+  void verify_manifest_membership(SmartStamp &smartStamp, json &content, ostream &out, json &signatures);
+
+  /*!
+  @brief prints the signer of a valid signature and adds it to the record of the signature
+  */
+  void print_signer(const json &verification_js, const json &content, const string &key_id, ostream &out,
+                    json &signature_record) const;
+
+  /*!
+  @brief prints out the result of the verification of a SmartStamp
+
+  @return true if the SmartStamp has been issued for hash
+  */
+  bool print_verification_result(SmartStamp &smartStamp, const unsigned char *hash, ostream &out);
+
+  /*!
+  @brief verifies one document returned by the server and writes the results to out
+
+  Called for all documents at the same time, so it must only write to out (or write_record()) and not change the state
+  of this object. With --output ndjson a record is written for each verified file as soon as it is ready.
+
+  @param matched set to the indexes in file_names of the files the document has been matched with by its hash, all
+                 files with this hash (empty for a bundle, where the document applies to all files)
+  @return false if the document could not be assigned to files, so it may belong to any of them
+  */
+  bool verify_document(json &doc, ostream &out, vector<size_t> &matched);
+
+  /*!
+  @brief returns the names of the files that documents have been matched with, doc_names for a bundle or a single file
+
+  @param matched files of each document returned by verify_document()
+  */
+  string registered_names(const vector<vector<size_t>> &matched) const;
+
+  /*!
+  @brief reports the files none of the documents returned by the server has been matched with
+
+  @param matched files of each document returned by verify_document()
+  @param assigned result of verify_document() for each document
+  */
+  void report_unregistered(const vector<vector<size_t>> &matched, const vector<char> &assigned);
+
+  /*!
+  @brief writes record as one line to cout and flushes it, may be called from several threads
+  */
+  void write_record(const json &record);
 
 public:
-  cealr(int, const char **);
+  /*!
+  @brief constructor parsing the command line arguments
+
+  @param _interactive false if there is no user to answer questions, e.g. for the requests of the daemon
+  */
+  cealr(int, const char **, bool _interactive = true);
+
+  /*!
+  @brief constructor for embedding cealr (see libcealr.h), the user is never asked and the results are only passed
+         to the sink
+
+  @param _server         URL of the API, nullptr like without option --server
+  @param _api_key        API key, nullptr like without option --apiKey
+  @param _api_credential API credential, nullptr like without option --apiCredential
+  @param _sink           receives the record of each sealed or verified file (see option --output ndjson)
+  */
+  cealr(const string *_server, const string *_api_key, const string *_api_credential,
+        function<void(const json &)> _sink);
 
   virtual ~cealr();
 
@@ -155,15 +402,41 @@ public:
   This method is called to register the hash/signature of the file to be registered in the block chain that is
   assigned to the account.
 
-  @param open_pgp_sign contains the signature of the file if the file has been signed. In this case the signature
-          will be uploaded to the cryptowerk server to be registered as meta data of the file.
+  @param sealed_meta_data contains the signature(s) of the file(s) if the files have been signed. In this case the
+          signatures will be uploaded to the cryptowerk server to be registered as meta data of the files.
 
   @return parsed JSON response from server
   */
-  json seal_file(const open_pgp *open_pgp_sign = nullptr) const;
+  json seal_file(const json *sealed_meta_data = nullptr) const;
 
   json verify_seal() const;
 
+  /*!
+  @brief looks up the registrations of the given comma separated hexadecimal hashes
+
+  @return parsed JSON response from server
+  */
+  json verify_hashes(const string &names, const string &hashes) const;
+
+  /*!
+  @brief posts a registration request to the server
+
+  @return parsed JSON response from server
+  */
+  json post_registration(request_body &body) const;
+
+  /*!
+  @brief hashes files and seals them with one registration, a record is passed to the sink for each file
+
+  @throw cealr_exception if there are no account credentials
+  */
+  void seal_files(const vector<string> &files);
+
+  /*!
+  @brief hashes and verifies files, the records are passed to the sink
+  */
+  void verify_files(const vector<string> &files);
+
   /*!
   @brief Calling Cryptowerk API to retrieve seal a file and use the result to check the files authenticity
 
@@ -190,7 +463,29 @@ public:
   */
   void verify();
 
-  void verify_metadata(SmartStamp &smartStamp);
+  /*!
+  @brief imports the keys of the signatures in the sealed metadata of all documents of a verification at once
+
+  The key ids are read from the SmartStamps before the documents are verified, so the keys missing in the local
+  keyring are fetched from the key server together (see open_pgp::prefetch_keys()). gpgme is only initialized if
+  there are signatures to verify.
+  */
+  void prefetch_keys(const json &docs);
+
+  /*!
+  @brief verifies the sealed metadata of a SmartStamp and writes the results to out
+
+  @param record if not nullptr, receives the results as "metadata" and "signatures" arrays
+  */
+  void verify_metadata(SmartStamp &smartStamp, ostream &out, json *record = nullptr);
 };
 
+/*!
+@brief runs cealr with command line arguments and reports errors like main()
+
+@param interactive false if there is no user to answer questions (see cealr::interactive)
+@return exit code of the command
+*/
+int run_cealr(int argc, const char **argv, bool interactive = true);
+
 #endif //CEALR_H
@@ -0,0 +1,529 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "cealr_daemon.h"
+#include "cealr.h"
+#include "file_util.h"
+#include "properties.h"
+#include <cerrno>
+#include <csignal>
+#include <sstream>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static sockaddr_un socket_address(const string &file)
+{
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (file.size() >= sizeof(address.sun_path))
+  {
+    throw daemon_exception(__FILE__, __LINE__, "The name of the socket \"" + file + "\" is too long.");
+  }
+  strncpy(address.sun_path, file.c_str(), sizeof(address.sun_path) - 1);
+  return address;
+}
+
+// reads the next line (without '\n') from fd, buffer keeps what has been read beyond it
+static bool read_line(int fd, string &buffer, string &line)
+{
+  size_t end;
+  while ((end = buffer.find('\n')) == string::npos)
+  {
+    if (buffer.size() > DAEMON_MAX_REQUEST_SIZE)
+    {
+      return false;
+    }
+    char block[DAEMON_BUFFER_SIZE];
+    const ssize_t got = read(fd, block, sizeof(block));
+    if (got < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (got <= 0)
+    {
+      return false;
+    }
+    buffer.append(block, static_cast<size_t>(got));
+  }
+  line.assign(buffer, 0, end);
+  buffer.erase(0, end + 1);
+  return true;
+}
+
+static bool write_all(int fd, const string &data)
+{
+  size_t written = 0;
+  while (written < data.size())
+  {
+    const ssize_t count = write(fd, data.data() + written, data.size() - written);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count <= 0)
+    {
+      return false;
+    }
+    written += static_cast<size_t>(count);
+  }
+  return true;
+}
+
+// resolves a file name of a request against the working directory of the client, the daemon keeps its own
+static string resolve(const string &cwd, const string &file)
+{
+  return cwd.empty() || file.empty() || file[0] == '/' ? file : cwd + "/" + file;
+}
+
+// returns why args cannot be run by the daemon, an empty string if they can
+static string unsupported_arguments(const vector<string> &args)
+{
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    if (args[i] == "--watch" || (args[i] == "--manifest" && i + 1 < args.size() && args[i + 1] == "-"))
+    {
+      return "The options --watch and --manifest - cannot be used with --connect, the daemon can neither wait for "
+             "the files nor read the standard input of the client.";
+    }
+  }
+  return string();
+}
+
+// returns true if args only seal or verify files with --output ndjson, which the daemon serves concurrently
+static bool files_request(const vector<string> &args, bool &seal, vector<string> &files)
+{
+  bool ndjson = false;
+  seal        = false;
+  files.clear();
+  for (size_t i = 0; i < args.size(); i++)
+  {
+    const string &arg = args[i];
+    if (arg == "--output" && i + 1 < args.size())
+    {
+      ndjson = args[++i] == "ndjson";
+    }
+    else if (arg == "--seal" && i + 1 < args.size() && args[i + 1].compare(0, 2, "--") != 0)
+    {
+      seal = true;
+      files.push_back(args[++i]);
+    }
+    else if (arg.compare(0, 2, "--") == 0 || arg.find('@') != string::npos)
+    {
+      // other options and versions are only supported by the command line
+      return false;
+    }
+    else
+    {
+      files.push_back(arg);
+    }
+  }
+  return ndjson && !files.empty();
+}
+
+string cealr_daemon::default_socket()
+{
+  return xdg_dir("XDG_RUNTIME_DIR", xdg_dir("XDG_CACHE_HOME", "~/.cache")) + "/" + DEFAULT_SOCKET;
+}
+
+cealr_daemon::cealr_daemon(const string &socket_path)
+{
+  socket_file = properties::get_full_file_name(socket_path);
+  started     = time(nullptr);
+  requests    = 0;
+  sealing     = false;
+  string *dir = super_path(socket_file);
+  if (dir)
+  {
+    if (!dir_exists(*dir))
+    {
+      mkdirs(*dir);
+      set_file_permissions(*dir, S_IRUSR | S_IWUSR | S_IXUSR);
+    }
+    delete dir;
+  }
+  const sockaddr_un address = socket_address(socket_file);
+  // a socket file left by a daemon that has been killed is replaced, the socket of a running daemon is not
+  int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probe >= 0 && connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0)
+  {
+    close(probe);
+    throw daemon_exception(__FILE__, __LINE__, "A daemon is already listening on \"" + socket_file + "\".");
+  }
+  if (probe >= 0)
+  {
+    close(probe);
+  }
+  unlink(socket_file.c_str());
+  if ((listen_fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0)
+  {
+    throw daemon_exception(__FILE__, __LINE__, string("Cannot create socket: ") + strerror(errno));
+  }
+  // only the user may connect, the daemon seals with the credentials of the user
+  const mode_t mask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+  const int bound   = ::bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+  umask(mask);
+  if (bound != 0 || listen(listen_fd, SOMAXCONN) != 0)
+  {
+    const string error = strerror(errno);
+    close(listen_fd);
+    throw daemon_exception(__FILE__, __LINE__, "Cannot listen on \"" + socket_file + "\": " + error);
+  }
+  if (!(client = cealr_client_new(nullptr, nullptr, nullptr)))
+  {
+    close(listen_fd);
+    unlink(socket_file.c_str());
+    throw daemon_exception(__FILE__, __LINE__, "Cannot create the client of the daemon.");
+  }
+}
+
+cealr_daemon::~cealr_daemon()
+{
+  cealr_client_free(client);
+  close(listen_fd);
+  unlink(socket_file.c_str());
+}
+
+void cealr_daemon::run()
+{
+  signal(SIGPIPE, SIG_IGN);
+  // commands must not read from the terminal the daemon has been started from
+  const int null_fd = open("/dev/null", O_RDONLY);
+  if (null_fd >= 0)
+  {
+    dup2(null_fd, STDIN_FILENO);
+    close(null_fd);
+  }
+  cout << "cealr daemon listening on \"" << socket_file << "\"" << endl;
+  while (true)
+  {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0)
+    {
+      if (errno == EINTR || errno == ECONNABORTED)
+      {
+        continue;
+      }
+      throw daemon_exception(__FILE__, __LINE__, string("Cannot accept connection: ") + strerror(errno));
+    }
+    thread([this, fd]()
+    {
+      serve(fd);
+      close(fd);
+    }).detach();
+  }
+}
+
+void cealr_daemon::serve(int fd)
+{
+  string buffer;
+  string line;
+  while (read_line(fd, buffer, line))
+  {
+    string response;
+    try
+    {
+      response = handle(json::parse(line)).dump();
+    }
+    catch (exception &e)
+    {
+      response = json({{"error", e.what()}}).dump();
+    }
+    if (!write_all(fd, response + "\n"))
+    {
+      return;
+    }
+  }
+}
+
+json cealr_daemon::handle(const json &request)
+{
+  const string command = request.value("command", string());
+  if (command == "status")
+  {
+    return {{"pid",      getpid()},
+            {"socket",   socket_file},
+            {"uptime",   static_cast<long>(time(nullptr) - started)},
+            {"requests", requests.load()}};
+  }
+  const string cwd = request.value("cwd", string());
+  if (command == "seal" || command == "verify")
+  {
+    // the records name the files like the client has
+    vector<string>                files;
+    unordered_map<string, string> names;
+    if (request.count("files"))
+    {
+      for (const auto &file:request.at("files"))
+      {
+        files.push_back(resolve(cwd, file));
+        names[files.back()] = file;
+      }
+    }
+    requests++;
+    json   response = command == "seal" ? seal_files(files) : verify_files(files);
+    string output;
+    for (json &record:response["records"])
+    {
+      if (record.count("file") && names.count(record["file"]))
+      {
+        record["file"] = names[record["file"]];
+      }
+      output += record.dump() + "\n";
+    }
+    response.erase("records");
+    response["output"] = output;
+    return response;
+  }
+  if (command != "run")
+  {
+    return {{"error", "Unknown command \"" + command + "\"."}};
+  }
+  vector<string> args;
+  if (request.count("args"))
+  {
+    for (const auto &arg:request.at("args"))
+    {
+      args.push_back(arg);
+    }
+  }
+  const string unsupported = unsupported_arguments(args);
+  if (!unsupported.empty())
+  {
+    return {{"error", unsupported}};
+  }
+  requests++;
+  return run_command(cwd, args);
+}
+
+// result of a call of the library as response with the records still in an array
+static json library_response(int status, char *result, char *error)
+{
+  json response = {{"exitCode", status == CEALR_OK ? 0 : 1}, {"records", json::array()}, {"errors", ""}};
+  if (status == CEALR_OK)
+  {
+    response["records"] = json::parse(result);
+  }
+  else
+  {
+    response["errors"] = string(error ? error : "The command failed.") + "\n";
+  }
+  cealr_free(result);
+  cealr_free(error);
+  return response;
+}
+
+json cealr_daemon::seal_files(const vector<string> &files)
+{
+  pending_seal request{files, json::array(), string(), false};
+  unique_lock<mutex> lock(seal_mutex);
+  seal_queue.push_back(&request);
+  while (!request.done)
+  {
+    if (sealing)
+    {
+      seal_done.wait(lock);
+      continue;
+    }
+    // no registration is running, this request seals all requests waiting until now
+    vector<pending_seal *> batch;
+    batch.swap(seal_queue);
+    sealing = true;
+    lock.unlock();
+    seal_batch(batch);
+    lock.lock();
+    sealing = false;
+    seal_done.notify_all();
+  }
+  lock.unlock();
+  if (!request.error.empty())
+  {
+    return {{"exitCode", 1}, {"records", json::array()}, {"errors", request.error}};
+  }
+  return {{"exitCode", 0}, {"records", request.records}, {"errors", ""}};
+}
+
+void cealr_daemon::seal_batch(const vector<pending_seal *> &batch)
+{
+  vector<string> files;
+  for (const pending_seal *request:batch)
+  {
+    files.insert(files.end(), request->files.begin(), request->files.end());
+  }
+  const json response = register_files(files);
+  const json &records = response["records"];
+  if (response["exitCode"] == 0 && records.size() == files.size())
+  {
+    // one record per file in the order of the files
+    size_t next = 0;
+    for (pending_seal *request:batch)
+    {
+      for (size_t i = 0; i < request->files.size(); i++)
+      {
+        request->records.push_back(records[next++]);
+      }
+    }
+  }
+  else if (batch.size() > 1)
+  {
+    // a request that cannot be sealed (e.g. with a file that does not exist) does not fail the others
+    for (pending_seal *request:batch)
+    {
+      const json own   = register_files(request->files);
+      request->records = own["records"];
+      request->error   = own["errors"];
+    }
+  }
+  else
+  {
+    batch[0]->error = response["errors"];
+  }
+  lock_guard<mutex> lock(seal_mutex);
+  for (pending_seal *request:batch)
+  {
+    request->done = true;
+  }
+}
+
+json cealr_daemon::register_files(const vector<string> &files)
+{
+  vector<const char *> names;
+  for (const string &file:files)
+  {
+    names.push_back(file.c_str());
+  }
+  char *result = nullptr;
+  char *error  = nullptr;
+  const int status = cealr_seal(client, names.data(), names.size(), &result, &error);
+  return library_response(status, result, error);
+}
+
+json cealr_daemon::verify_files(const vector<string> &files)
+{
+  vector<const char *> names;
+  for (const string &file:files)
+  {
+    names.push_back(file.c_str());
+  }
+  char *result = nullptr;
+  char *error  = nullptr;
+  const int status = cealr_verify(client, names.data(), names.size(), &result, &error);
+  return library_response(status, result, error);
+}
+
+json cealr_daemon::run_command(const string &cwd, const vector<string> &args)
+{
+  lock_guard<mutex> lock(run_mutex);
+  ostringstream output;
+  ostringstream errors;
+  istringstream input;
+  streambuf *cout_buf = cout.rdbuf(output.rdbuf());
+  streambuf *cerr_buf = cerr.rdbuf(errors.rdbuf());
+  streambuf *cin_buf  = cin.rdbuf(input.rdbuf());
+  char *daemon_cwd    = getcwd(nullptr, 0);
+  int exit_code       = 1;
+  if (!cwd.empty() && chdir(cwd.c_str()) != 0)
+  {
+    errors << "Cannot change to directory \"" << cwd << "\": " << strerror(errno) << endl;
+  }
+  else
+  {
+    vector<const char *> argv{"cealr"};
+    for (const string &arg:args)
+    {
+      argv.push_back(arg.c_str());
+    }
+    try
+    {
+      exit_code = run_cealr(static_cast<int>(argv.size()), argv.data(), false);
+    }
+    catch (...)
+    {
+      errors << "The command failed." << endl;
+    }
+  }
+  if (daemon_cwd)
+  {
+    if (chdir(daemon_cwd) != 0)
+    {
+      errors << "Cannot change back to directory \"" << daemon_cwd << "\"" << endl;
+    }
+    free(daemon_cwd);
+  }
+  cout.flush();
+  cout.rdbuf(cout_buf);
+  cerr.rdbuf(cerr_buf);
+  cin.rdbuf(cin_buf);
+  cout.clear();
+  cerr.clear();
+  cin.clear();
+  return {{"exitCode", exit_code}, {"output", output.str()}, {"errors", errors.str()}};
+}
+
+int cealr_daemon::forward(const string &socket_path, const vector<string> &args)
+{
+  const string unsupported = unsupported_arguments(args);
+  if (!unsupported.empty())
+  {
+    throw daemon_exception(__FILE__, __LINE__, unsupported);
+  }
+  const string file         = properties::get_full_file_name(socket_path);
+  const sockaddr_un address = socket_address(file);
+  const int fd              = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0)
+  {
+    const string error = strerror(errno);
+    if (fd >= 0)
+    {
+      close(fd);
+    }
+    throw daemon_exception(__FILE__, __LINE__, "Cannot connect to the daemon on \"" + file + "\": " + error +
+                                               ". It is started with --daemon.");
+  }
+  signal(SIGPIPE, SIG_IGN);
+  char *cwd = getcwd(nullptr, 0);
+  json request = {{"cwd", cwd ? cwd : ""}};
+  free(cwd);
+  bool           seal;
+  vector<string> files;
+  if (files_request(args, seal, files))
+  {
+    request["command"] = seal ? "seal" : "verify";
+    request["files"]   = files;
+  }
+  else
+  {
+    request["command"] = "run";
+    request["args"]    = args;
+  }
+  string buffer;
+  string line;
+  const bool answered = write_all(fd, request.dump() + "\n") && read_line(fd, buffer, line);
+  close(fd);
+  if (!answered)
+  {
+    throw daemon_exception(__FILE__, __LINE__, "The daemon on \"" + file + "\" has closed the connection.");
+  }
+  const json response = json::parse(line);
+  if (response.count("error"))
+  {
+    throw daemon_exception(__FILE__, __LINE__, response["error"].get<string>());
+  }
+  cout << response["output"].get<string>() << flush;
+  cerr << response["errors"].get<string>() << flush;
+  return response["exitCode"];
+}
@@ -0,0 +1,182 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_DAEMON_H
+#define CEALR_DAEMON_H
+
+#include <atomic>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "libcealr.h"
+
+using json = nlohmann::json;
+
+using namespace std;
+
+// socket relative to $XDG_RUNTIME_DIR (or the XDG cache directory), ~/.cealr is not writable
+static const char *const DEFAULT_SOCKET = "cealr/daemon.sock";
+
+// maximum size of one request line
+#define DAEMON_MAX_REQUEST_SIZE 0x1000000
+// size of the blocks read from a connection
+#define DAEMON_BUFFER_SIZE 0x10000
+
+/*!
+@brief exception thrown if the socket of the daemon cannot be created or reached
+*/
+class daemon_exception : public exception
+{
+private:
+  runtime_error _what;
+
+public:
+  daemon_exception(const string &file, const int line, const string &errStr) : _what(("" + file + ":" + to_string(line) + ": " + errStr).c_str()) {}
+
+  const char *what()
+  {
+    return _what.what();
+  }
+};
+
+/*!
+@brief long running cealr process serving sealing and verification requests on a Unix domain socket
+
+A process per sealing or verification reads the properties, starts gpg and connects to the server each time. The
+daemon does this once and keeps the state between requests: gpgme, the public key caches (key_cache and the keys
+for in-process verification), the signing key and the connections to the server (see curl_util::init_global()).
+
+Each request and each response is one line of JSON:
+
+  {"command": "seal", "cwd": "<dir>", "files": ["<file>", ...]}
+  {"command": "verify", "cwd": "<dir>", "files": ["<file>", ...]}
+  {"command": "run", "cwd": "<dir>", "args": ["<argument>", ...]}
+  {"command": "status"}
+
+"seal" and "verify" run through the thread-safe library (see libcealr.h) with the output of each request collected
+on its own, so they are served concurrently. Seal requests arriving while a registration is running are merged into
+the next registration. Relative file names are resolved against "cwd". "output" of the response holds the records
+of the files, one line of JSON each (like --output ndjson).
+
+"run" takes the same arguments as the command line (used by --connect for everything except sealing and verifying
+files with --output ndjson). These commands use the standard streams and the working directory of the process, so
+they run one at a time.
+
+The response of a command is {"exitCode": <code>, "output": "<standard output>", "errors": "<standard error>"}, the
+response of "status" is {"pid": <pid>, "socket": "<file>", "uptime": <seconds>, "requests": <count>}.
+
+The daemon cannot ask questions, so the account has to be configured before (--register or --login) and keys are
+only imported if they are trusted already.
+*/
+class cealr_daemon
+{
+private:
+  /*!
+  @brief files of a seal request waiting to be registered together with other requests
+  */
+  struct pending_seal
+  {
+    vector<string> files;
+    json           records;  //!< record of each file
+    string         error;    //!< empty if the files have been sealed
+    bool           done;
+  };
+
+  string                 socket_file;
+  int                    listen_fd;
+  time_t                 started;
+  atomic<unsigned long>  requests;
+  cealr_client          *client;
+  mutex                  run_mutex;    //!< serializes the "run" commands
+  mutex                  seal_mutex;
+  condition_variable     seal_done;
+  vector<pending_seal *> seal_queue;   //!< seal requests for the next registration
+  bool                   sealing;      //!< true while a registration is running
+
+  /*!
+  @brief reads requests from a connection and writes the responses until the client closes it
+  */
+  void serve(int fd);
+
+  json handle(const json &request);
+
+  /*!
+  @brief runs cealr with the arguments of a request in the working directory of the client
+  */
+  json run_command(const string &cwd, const vector<string> &args);
+
+  /*!
+  @brief seals files with the next registration, together with the other requests waiting at that time
+
+  The request that finds no registration running seals all waiting requests at once, the others wait for it.
+  */
+  json seal_files(const vector<string> &files);
+
+  /*!
+  @brief seals the files of several requests with one registration and passes each request its records
+  */
+  void seal_batch(const vector<pending_seal *> &batch);
+
+  /*!
+  @brief seals files with one registration right away
+
+  @return response with the records of the files in "records"
+  */
+  json register_files(const vector<string> &files);
+
+  /*!
+  @brief verifies files, concurrently with the other requests
+
+  @return response with the records of the files in "records"
+  */
+  json verify_files(const vector<string> &files);
+
+public:
+  /*!
+  @brief constructor creating the socket
+
+  @param socket_path file of the socket ("~" is expanded), see default_socket()
+  @throw daemon_exception if the socket cannot be created or another daemon is listening on it
+  */
+  explicit cealr_daemon(const string &socket_path);
+
+  ~cealr_daemon();
+
+  cealr_daemon(const cealr_daemon &) = delete;
+
+  cealr_daemon &operator=(const cealr_daemon &) = delete;
+
+  /*!
+  @brief accepts and serves clients until the process is terminated
+  */
+  void run();
+
+  /*!
+  @brief returns DEFAULT_SOCKET in $XDG_RUNTIME_DIR, in the XDG cache directory if that is not set
+  */
+  static string default_socket();
+
+  /*!
+  @brief thin client: runs cealr with the given command line arguments in the daemon and prints its output
+
+  Sealing or verifying files with --output ndjson is sent as "seal" or "verify" request, everything else as "run".
+
+  @return exit code of the command
+  @throw daemon_exception if the daemon cannot be reached
+  */
+  static int forward(const string &socket_path, const vector<string> &args);
+};
+
+#endif //CEALR_DAEMON_H
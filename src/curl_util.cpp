@@ -10,6 +10,10 @@
  */
 
 #include "curl_util.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
 #include <utility>
 
 static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
@@ -19,19 +23,306 @@ static size_t WriteCallback(void *contents, size_t size, size_t nmemb, void *use
   return bytes;
 }
 
+static size_t ReadCallback(char *buffer, size_t size, size_t nitems, void *userp)
+{
+  return ((request_body *) userp)->read(buffer, size * nitems);
+}
+
+static int SeekCallback(void *userp, curl_off_t offset, int origin)
+{
+  if (origin != SEEK_SET || offset != 0)
+  {
+    return CURL_SEEKFUNC_CANTSEEK;
+  }
+  ((request_body *) userp)->rewind();
+  return CURL_SEEKFUNC_OK;
+}
+
+static void append_escaped(string &out, const char *data, size_t len)
+{
+  static const char *digits = "0123456789abcdef";
+  for (size_t i = 0; i < len; i++)
+  {
+    const auto c = (unsigned char) data[i];
+    if (c == '"' || c == '\\')
+    {
+      out.push_back('\\');
+      out.push_back((char) c);
+    }
+    else if (c < 0x20)
+    {
+      out.append("\\u00");
+      out.push_back(digits[c >> 4]);
+      out.push_back(digits[c & 0x0f]);
+    }
+    else
+    {
+      out.push_back((char) c);
+    }
+  }
+}
+
+json_stream_body::json_stream_body(const json &members)
+{
+  if (members.empty())
+  {
+    prefix = "{";
+  }
+  else
+  {
+    prefix = members.dump();
+    prefix.pop_back(); // closing brace
+  }
+  rewind();
+}
+
+void json_stream_body::add_string(const string &name, const string &value)
+{
+  members.push_back(member{name, &value, 0, nullptr, 0});
+}
+
+void json_stream_body::add_list(const string &name, size_t count, item_writer item, char separator)
+{
+  members.push_back(member{name, nullptr, count, std::move(item), separator});
+}
+
+void json_stream_body::rewind()
+{
+  current_stage  = OBJECT_START;
+  current_member = 0;
+  position       = 0;
+  pending.clear();
+  pending_offset = 0;
+}
+
+const char *json_stream_body::content_type() const
+{
+  return "application/json";
+}
+
+size_t json_stream_body::read(char *buffer, size_t size)
+{
+  size_t copied = 0;
+  while (copied < size)
+  {
+    if (pending_offset == pending.size())
+    {
+      pending.clear();
+      pending_offset = 0;
+      if (!produce())
+      {
+        break;
+      }
+      continue;
+    }
+    const size_t n = min(size - copied, pending.size() - pending_offset);
+    memcpy(buffer + copied, pending.data() + pending_offset, n);
+    pending_offset += n;
+    copied         += n;
+  }
+  return copied;
+}
+
+bool json_stream_body::produce()
+{
+  switch (current_stage)
+  {
+    case OBJECT_START:
+      pending       = prefix;
+      current_stage = MEMBER_START;
+      return true;
+    case MEMBER_START:
+      if (current_member == members.size())
+      {
+        current_stage = OBJECT_END;
+        return produce();
+      }
+      if (current_member || prefix.size() > 1)
+      {
+        pending.push_back(',');
+      }
+      pending.push_back('"');
+      append_escaped(pending, members[current_member].name.data(), members[current_member].name.size());
+      pending.append("\":\"");
+      position      = 0;
+      current_stage = MEMBER_VALUE;
+      return true;
+    case MEMBER_VALUE:
+    {
+      const member &m = members[current_member];
+      if (m.value)
+      {
+        const size_t n = min<size_t>(JSON_STREAM_CHUNK_SIZE, m.value->size() - position);
+        append_escaped(pending, m.value->data() + position, n);
+        position += n;
+        if (position == m.value->size())
+        {
+          current_stage = MEMBER_END;
+        }
+      }
+      else
+      {
+        while (position < m.count && pending.size() < JSON_STREAM_CHUNK_SIZE)
+        {
+          if (position)
+          {
+            pending.push_back(m.separator);
+          }
+          item_buffer.clear();
+          m.item(position++, item_buffer);
+          append_escaped(pending, item_buffer.data(), item_buffer.size());
+        }
+        if (position == m.count)
+        {
+          current_stage = MEMBER_END;
+        }
+      }
+      return true;
+    }
+    case MEMBER_END:
+      pending.push_back('"');
+      current_member++;
+      current_stage = MEMBER_START;
+      return true;
+    case OBJECT_END:
+      pending.push_back('}');
+      current_stage = DONE;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// data shared by the requests of all curl_util objects
+static CURLSH *share = nullptr;
+static mutex share_mutexes[CURL_LOCK_DATA_LAST];
+
+static void lock_share(CURL *, curl_lock_data data, curl_lock_access, void *)
+{
+  share_mutexes[data].lock();
+}
+
+static void unlock_share(CURL *, curl_lock_data data, void *)
+{
+  share_mutexes[data].unlock();
+}
+
+// easy handles kept with their open connections for later requests, each one is used by one request at a time
+static vector<CURL *> idle_handles;
+static mutex idle_mutex;
+// handles used by requests, cleanup_global() waits until they have been released
+static size_t busy_handles = 0;
+static condition_variable handle_released;
+static bool cleaned_up = false;
+
+static CURL *acquire_handle()
+{
+  CURL *handle = nullptr;
+  {
+    lock_guard<mutex> lock(idle_mutex);
+    if (cleaned_up)
+    {
+      return nullptr;
+    }
+    busy_handles++;
+    if (!idle_handles.empty())
+    {
+      handle = idle_handles.back();
+      idle_handles.pop_back();
+    }
+  }
+  if (handle)
+  {
+    // clears the options of the previous request, the connections stay open
+    curl_easy_reset(handle);
+    return handle;
+  }
+  handle = curl_easy_init();
+  if (!handle)
+  {
+    lock_guard<mutex> lock(idle_mutex);
+    busy_handles--;
+    handle_released.notify_all();
+  }
+  return handle;
+}
+
+static void release_handle(CURL *handle)
+{
+  if (!handle)
+  {
+    return;
+  }
+  {
+    lock_guard<mutex> lock(idle_mutex);
+    busy_handles--;
+    handle_released.notify_all();
+    if (!cleaned_up && idle_handles.size() < CURL_MAX_IDLE_HANDLES)
+    {
+      idle_handles.push_back(handle);
+      return;
+    }
+  }
+  curl_easy_cleanup(handle);
+}
+
+static void cleanup_global()
+{
+  unique_lock<mutex> lock(idle_mutex);
+  cleaned_up = true;
+  // libcurl must not be cleaned up while other threads use it, if their requests do not finish in time it is left to
+  // the operating system
+  if (!handle_released.wait_for(lock, chrono::seconds(CURL_CLEANUP_WAIT), []()
+  {
+    return busy_handles == 0;
+  }))
+  {
+    return;
+  }
+  for (CURL *handle:idle_handles)
+  {
+    curl_easy_cleanup(handle);
+  }
+  idle_handles.clear();
+  lock.unlock();
+  curl_share_cleanup(share);
+  curl_global_cleanup();
+}
+
+void curl_util::init_global()
+{
+  static once_flag initialized;
+  call_once(initialized, []()
+  {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lock_share);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlock_share);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    // the connection cache must not be shared by transfers running on several threads, connections are reused by
+    // keeping the easy handles instead (see acquire_handle())
+    atexit(cleanup_global);
+  });
+}
+
 curl_util::curl_util(string url, bool bVerbose)
 {
   setUrl(url);
   setVerbose(bVerbose);
   headers = nullptr;
+  body = nullptr;
   returnData = new string();
-  curl = curl_easy_init();
-  //todo curlUtilException
+  init_global();
+  curl = acquire_handle();
   if (!curl)
   {
-    cerr << "Cannot initialize curl." << endl;
-    exit(1);
+    delete returnData;
+    throw curl_exception(__FILE__, __LINE__, "Cannot initialize curl.");
   }
+  curl_easy_setopt(curl, CURLOPT_SHARE, share);
+  // requests run on several threads, so timeouts (e.g. of the name resolution) must not be implemented with signals
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
 
   curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
   curl_easy_setopt(curl, CURLOPT_WRITEDATA, returnData);
@@ -47,7 +338,7 @@ curl_util::~curl_util()
   {
     curl_slist_free_all(headers);
   }
-  curl_global_cleanup();
+  release_handle(curl);
   delete returnData;
 }
 
@@ -100,6 +391,31 @@ string *curl_util::post(const json &json)
   return post(sJson.str());
 }
 
+string *curl_util::post(request_body &_body)
+{
+  if (verbose)
+  {
+    char buffer[JSON_STREAM_CHUNK_SIZE];
+    cout << "URL:  " << sUrl << endl
+         << "Data: ";
+    for (size_t n; (n = _body.read(buffer, sizeof(buffer))) > 0;)
+    {
+      cout.write(buffer, n);
+    }
+    cout << endl;
+  }
+  body = &_body;
+  addHeader(string("Content-Type: ") + _body.content_type());
+  addHeader("Transfer-Encoding: chunked");
+  curl_easy_setopt(curl, CURLOPT_URL, sUrl.c_str());
+  curl_easy_setopt(curl, CURLOPT_POST, 1L);
+  curl_easy_setopt(curl, CURLOPT_READFUNCTION, ReadCallback);
+  curl_easy_setopt(curl, CURLOPT_READDATA, body);
+  curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, SeekCallback);
+  curl_easy_setopt(curl, CURLOPT_SEEKDATA, body);
+  return _request();
+}
+
 string *curl_util::post(const string &url, const json &json)
 {
   setUrl(url);
@@ -113,12 +429,17 @@ string *curl_util::_request()
   do
   {
     redirecting = false;
+    if (body)
+    {
+      body->rewind();
+    }
     returnCode = curl_easy_perform(curl);
     if (returnCode != CURLE_OK)
     {
-      //todo curlUtilException
-      cerr << "curl_easy_perform() failed: " << curl_easy_strerror(returnCode) << endl;
-//            exit(1);
+      const string error = curl_easy_strerror(returnCode);
+      curl_easy_cleanup(curl);
+      curl = nullptr;
+      throw curl_exception(__FILE__, __LINE__, "Cannot connect to server \"" + sUrl + "\": " + error);
     }
     if (verbose)
     {
@@ -152,12 +473,13 @@ string *curl_util::_request()
     }
     else
     {
-      //todo curlUtilException
-      cerr << "Unexpected response from server: " << *returnData << endl;
-      exit(1);
+      release_handle(curl);
+      curl = nullptr;
+      throw curl_exception(__FILE__, __LINE__, "Unexpected response from server: " + *returnData);
     }
   } while (redirecting);
-  curl_easy_cleanup(curl);
+  release_handle(curl);
+  curl = nullptr;
 
   return returnData;
 }
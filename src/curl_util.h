@@ -12,8 +12,10 @@
 #ifndef CEALR_CURLUTIL_H
 #define CEALR_CURLUTIL_H
 
+#include <functional>
 #include <iostream>
 #include <string>
+#include <vector>
 #include <curl/curl.h>
 //#include "json.h"
 #include <nlohmann/json.hpp>
@@ -23,6 +25,120 @@ using json = nlohmann::json;
 
 using namespace std;
 
+// number of bytes a json_stream_body prepares at a time
+#define JSON_STREAM_CHUNK_SIZE 0x4000
+// number of easy handles kept with their open connections for later requests
+#define CURL_MAX_IDLE_HANDLES  16
+// seconds the cleanup at exit waits for requests that are still running on other threads
+#define CURL_CLEANUP_WAIT      10
+
+/*!
+@brief exception thrown if a request cannot be made or the server responds with an error
+*/
+class curl_exception : public exception
+{
+private:
+  runtime_error _what;
+
+public:
+  curl_exception(const string &file, const int line, const string &errStr) : _what(("" + file + ":" + to_string(line) + ": " + errStr).c_str()) {}
+
+  const char *what()
+  {
+    return _what.what();
+  }
+};
+
+/*!
+@brief body of a request that is produced while it is sent
+*/
+class request_body
+{
+public:
+  virtual ~request_body() = default;
+
+  /*!
+  @brief copies the next bytes of the body into buffer
+
+  @return number of bytes copied, 0 at the end of the body
+  */
+  virtual size_t read(char *buffer, size_t size) = 0;
+
+  /*!
+  @brief restarts the body from the beginning, e.g. when the request is redirected
+  */
+  virtual void rewind() = 0;
+
+  virtual const char *content_type() const = 0;
+};
+
+/*!
+@brief JSON object that is serialized while it is sent
+
+Members with short values are given as json, members with long string values are added with add_string() or
+add_list() and are serialized (and escaped) piece by piece, so only JSON_STREAM_CHUNK_SIZE bytes of the body are held in
+memory at a time. Strings referenced by the body must outlive it.
+*/
+class json_stream_body : public request_body
+{
+public:
+  /*!
+  @brief appends the item with the given index to buffer
+  */
+  typedef function<void(size_t index, string &buffer)> item_writer;
+
+  explicit json_stream_body(const json &members);
+
+  /*!
+  @brief adds a member with a string value, which is not copied
+  */
+  void add_string(const string &name, const string &value);
+
+  /*!
+  @brief adds a member with a string value composed of count items separated by separator
+
+  @param item is called for each item while the body is sent
+  */
+  void add_list(const string &name, size_t count, item_writer item, char separator = ',');
+
+  size_t read(char *buffer, size_t size) override;
+
+  void rewind() override;
+
+  const char *content_type() const override;
+
+private:
+  struct member
+  {
+    string        name;
+    const string *value;  //!< value of a string member or nullptr for a list
+    size_t        count;
+    item_writer   item;
+    char          separator;
+  };
+
+  enum stage
+  {
+    OBJECT_START, MEMBER_START, MEMBER_VALUE, MEMBER_END, OBJECT_END, DONE
+  };
+
+  string         prefix;  //!< serialized json members without the closing brace
+  vector<member> members;
+  stage          current_stage;
+  size_t         current_member;
+  size_t         position;  //!< offset in the string value or index of the next item of the current member
+  string         pending;   //!< bytes prepared but not read yet
+  size_t         pending_offset;
+  string         item_buffer;
+
+  /*!
+  @brief prepares the next piece of the body in pending
+
+  @return false at the end of the body
+  */
+  bool produce();
+};
+
 /*!
 @brief CURL helper class
 
@@ -35,6 +151,7 @@ private:
   bool verbose;
   string sUrl;
   string *returnData;
+  request_body *body;  //!< body of a streamed request or nullptr
   CURLcode returnCode;
   struct curl_slist *headers;
 
@@ -65,6 +182,18 @@ public:
 
   ~curl_util();
 
+  /*!
+  @brief initializes libcurl (and the TLS library) once per process, when the first request is made
+
+  Called by the constructors. The global state is kept until the process exits instead of being cleaned up and
+  initialized again for every request. All requests share the DNS cache and the TLS sessions. The easy handles are kept
+  in a pool when a request has finished, so their open connections are reused by later requests (e.g. in the daemon
+  or libcealr) while each handle, and thus each connection, is only used by one thread at a time. At exit the global
+  state is only cleaned up after the requests still running on other threads (e.g. asynchronous calls of libcealr)
+  have finished, no new requests are started from then on.
+  */
+  static void init_global();
+
   /*!
   @brief Setter for URL
 
@@ -141,6 +270,18 @@ public:
   */
   string *post(const json &json);
 
+  /*!
+  @brief method for POST request with a streamed body
+
+  Performs a HTTP POST request to the URL and with the header that is specified in this object. The body is read from
+  parameter body while it is sent (with chunked transfer encoding), so it does not need to be held in memory.
+
+  @param body produces the body of the POST request.
+
+  @return the response from the server
+  */
+  string *post(request_body &body);
+
   /*!
   @brief method for GET request
 
@@ -0,0 +1,385 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "dir_walker.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <dirent.h>
+#include <exception>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+
+// layout of the records returned by getdents64
+struct linux_dirent64
+{
+  ino64_t        d_ino;
+  off64_t        d_off;
+  unsigned short d_reclen;
+  unsigned char  d_type;
+  char           d_name[];
+};
+#endif
+
+// directory waiting to be read
+struct pending_dir
+{
+  string path;
+  string rel_path;
+  size_t root_len;  //!< length of the root including the separator, path.substr(root_len) is relative to the root
+};
+
+// regular file found in a tree, device and inode identify hard links
+struct found_file
+{
+  dev_t  dev;
+  ino_t  ino;
+  string path;
+  size_t root_len;
+};
+
+// state shared by the threads of one walk
+struct walk_state
+{
+  mutex                     walk_mutex;
+  condition_variable        changed;
+  deque<pending_dir>        pending;
+  unsigned                  busy = 0;
+  bool                      failed = false;
+  exception_ptr             error;
+  set<pair<dev_t, ino_t>>   visited;  //!< directories that have been read
+  vector<vector<found_file>> found;   //!< files found by each thread
+};
+
+// joins a directory and the name of an entry
+static string join(const string &dir, const char *name)
+{
+  string ret;
+  ret.reserve(dir.size() + strlen(name) + 1);
+  ret.append(dir);
+  if (ret.empty() || ret.back() != '/')
+  {
+    ret.push_back('/');
+  }
+  ret.append(name);
+  return ret;
+}
+
+// calls entry for each entry of the open directory fd with its name, type (DT_*) and inode, closes fd
+static void read_entries(int fd, vector<char> &buffer, const function<void(const char *, unsigned char, ino_t)> &entry)
+{
+#ifdef __linux__
+  // getdents64 fills the whole buffer at once, readdir would copy each entry through a small buffer of the DIR stream
+  for (;;)
+  {
+    const long got = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+    if (got < 0)
+    {
+      const int err = errno;
+      close(fd);
+      throw dir_walker_exception(__FILE__, __LINE__, string("Cannot read directory: ") + strerror(err));
+    }
+    if (got == 0)
+    {
+      break;
+    }
+    for (long pos = 0; pos < got;)
+    {
+      auto *dirent = reinterpret_cast<linux_dirent64 *>(&buffer[pos]);
+      entry(dirent->d_name, dirent->d_type, static_cast<ino_t>(dirent->d_ino));
+      pos += dirent->d_reclen;
+    }
+  }
+  close(fd);
+#else
+  DIR *dir = fdopendir(fd);
+  if (!dir)
+  {
+    close(fd);
+    throw dir_walker_exception(__FILE__, __LINE__, string("Cannot read directory: ") + strerror(errno));
+  }
+  for (struct dirent *dirent; (dirent = readdir(dir));)
+  {
+    entry(dirent->d_name, dirent->d_type, dirent->d_ino);
+  }
+  closedir(dir);
+#endif
+}
+
+dir_walker::dir_walker(unsigned _max_threads)
+{
+  follow_symlinks = false;
+  max_threads     = _max_threads;
+}
+
+void dir_walker::include(const string &glob)
+{
+  includes.push_back(glob);
+}
+
+void dir_walker::exclude(const string &glob)
+{
+  excludes.push_back(glob);
+}
+
+void dir_walker::set_follow_symlinks(bool follow)
+{
+  follow_symlinks = follow;
+}
+
+bool dir_walker::matches(const vector<string> &patterns, const string &rel_path, const char *name)
+{
+  for (const string &pattern:patterns)
+  {
+    const bool with_path = pattern.find('/') != string::npos;
+    if (fnmatch(pattern.c_str(), with_path ? rel_path.c_str() : name, with_path ? FNM_PATHNAME : 0) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool dir_walker::selects(const string &rel_path, const char *name, bool is_dir) const
+{
+  if (matches(excludes, rel_path, name))
+  {
+    return false;
+  }
+  return is_dir || includes.empty() || matches(includes, rel_path, name);
+}
+
+vector<string> dir_walker::walk(const vector<string> &roots, vector<string> *rel_paths) const
+{
+  walk_state state;
+  for (const string &root:roots)
+  {
+    struct stat st{};
+    if (stat(root.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+      throw dir_walker_exception(__FILE__, __LINE__, "\"" + root + "\" is not a directory.");
+    }
+    state.pending.push_back({root, "", join(root, "").size()});
+  }
+  const unsigned threads = max_threads ? max_threads : default_thread_count();
+  state.found.resize(threads);
+
+  // reads one directory, files are collected in found, subdirectories are added to state.pending
+  auto read_dir = [this, &state](const pending_dir &dir, vector<found_file> &found, vector<char> &buffer)
+  {
+    const int fd = open(dir.path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    struct stat dir_st{};
+    if (fd < 0 || fstat(fd, &dir_st) != 0)
+    {
+      const int err = errno;
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+      throw dir_walker_exception(__FILE__, __LINE__, "Cannot open directory \"" + dir.path + "\": " + strerror(err));
+    }
+    {
+      lock_guard<mutex> lock(state.walk_mutex);
+      if (!state.visited.emplace(dir_st.st_dev, dir_st.st_ino).second)
+      {
+        // reached again by a symbolic link
+        close(fd);
+        return;
+      }
+    }
+    vector<pending_dir> subdirs;
+    read_entries(fd, buffer, [this, &dir, &dir_st, fd, &found, &subdirs](const char *name, unsigned char type,
+                                                                          ino_t ino)
+    {
+      if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+      {
+        return;
+      }
+      dev_t dev = dir_st.st_dev;
+      if (type == DT_UNKNOWN || (type == DT_LNK && follow_symlinks))
+      {
+        // file systems that do not provide the type, or the target of a link
+        struct stat st{};
+        if (fstatat(fd, name, &st, type == DT_LNK ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+        {
+          // dangling link or removed in the meantime
+          return;
+        }
+        type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : S_ISLNK(st.st_mode) ? DT_LNK : DT_UNKNOWN;
+        dev  = st.st_dev;
+        ino  = st.st_ino;
+      }
+      if (type != DT_DIR && type != DT_REG)
+      {
+        return;
+      }
+      // the relative path is only needed to match patterns
+      string rel_path;
+      if (!excludes.empty() || !includes.empty())
+      {
+        rel_path = dir.rel_path.empty() ? string(name) : join(dir.rel_path, name);
+      }
+      if (matches(excludes, rel_path, name))
+      {
+        return;
+      }
+      if (type == DT_DIR)
+      {
+        subdirs.push_back({join(dir.path, name), move(rel_path), dir.root_len});
+      }
+      else if (includes.empty() || matches(includes, rel_path, name))
+      {
+        found.push_back({dev, ino, join(dir.path, name), dir.root_len});
+      }
+    });
+    if (!subdirs.empty())
+    {
+      lock_guard<mutex> lock(state.walk_mutex);
+      for (pending_dir &subdir:subdirs)
+      {
+        state.pending.push_back(move(subdir));
+      }
+      state.changed.notify_all();
+    }
+  };
+
+  auto worker = [&state, &read_dir](unsigned t)
+  {
+    vector<char> buffer(DIR_WALKER_BUFFER_SIZE);
+    unique_lock<mutex> lock(state.walk_mutex);
+    for (;;)
+    {
+      // the walk is done when no directory is pending and no thread can add one
+      state.changed.wait(lock, [&state]()
+      {
+        return state.failed || !state.pending.empty() || !state.busy;
+      });
+      if (state.failed || state.pending.empty())
+      {
+        break;
+      }
+      pending_dir dir = move(state.pending.front());
+      state.pending.pop_front();
+      state.busy++;
+      lock.unlock();
+      try
+      {
+        read_dir(dir, state.found[t], buffer);
+      }
+      catch (...)
+      {
+        lock.lock();
+        if (!state.error)
+        {
+          state.error = current_exception();
+        }
+        state.failed = true;
+        lock.unlock();
+      }
+      lock.lock();
+      state.busy--;
+      if (state.failed || (!state.busy && state.pending.empty()))
+      {
+        state.changed.notify_all();
+      }
+    }
+  };
+
+  vector<thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned t = 1; t < threads; t++)
+  {
+    pool.emplace_back(worker, t);
+  }
+  worker(0);
+  for (thread &t:pool)
+  {
+    t.join();
+  }
+  if (state.error)
+  {
+    rethrow_exception(state.error);
+  }
+
+  size_t count = 0;
+  for (const vector<found_file> &found:state.found)
+  {
+    count += found.size();
+  }
+  vector<found_file> files;
+  files.reserve(count);
+  for (vector<found_file> &found:state.found)
+  {
+    move(found.begin(), found.end(), back_inserter(files));
+    vector<found_file>().swap(found);
+  }
+  // the paths are sorted once, of several links to the same file only the first path is kept
+  vector<string> paths;
+  paths.reserve(files.size());
+  for (found_file &file:files)
+  {
+    paths.push_back(move(file.path));
+  }
+  vector<size_t> order(paths.size());
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    order[i] = i;
+  }
+  // a file in nested roots is found under the same path more than once, it is taken as relative to the deepest root
+  sort(order.begin(), order.end(), [&paths, &files](size_t a, size_t b)
+  {
+    const int cmp = paths[a].compare(paths[b]);
+    return cmp != 0 ? cmp < 0 : files[a].root_len > files[b].root_len;
+  });
+  // the (stable) order of the links to a file is the order of their paths
+  vector<size_t> by_inode(order);
+  stable_sort(by_inode.begin(), by_inode.end(), [&files](size_t a, size_t b)
+  {
+    return files[a].dev != files[b].dev ? files[a].dev < files[b].dev : files[a].ino < files[b].ino;
+  });
+  vector<bool> duplicate(files.size(), false);
+  for (size_t i = 1; i < by_inode.size(); i++)
+  {
+    duplicate[by_inode[i]] = files[by_inode[i]].dev == files[by_inode[i - 1]].dev &&
+                             files[by_inode[i]].ino == files[by_inode[i - 1]].ino;
+  }
+  vector<string> sorted;
+  sorted.reserve(paths.size());
+  if (rel_paths)
+  {
+    rel_paths->clear();
+    rel_paths->reserve(paths.size());
+  }
+  for (size_t i:order)
+  {
+    if (!duplicate[i])
+    {
+      if (rel_paths)
+      {
+        rel_paths->push_back(paths[i].substr(files[i].root_len));
+      }
+      sorted.push_back(move(paths[i]));
+    }
+  }
+  return sorted;
+}
@@ -0,0 +1,103 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_DIR_WALKER_H
+#define CEALR_DIR_WALKER_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// size of the buffer the entries of a directory are read into
+#define DIR_WALKER_BUFFER_SIZE 0x10000
+
+class dir_walker_exception : public exception
+{
+private:
+  runtime_error _what;
+
+public:
+  dir_walker_exception(const string &file, const int line, const string &errStr) : _what(("" + file + ":" + to_string(line) + ": " + errStr).c_str()) {}
+
+  const char *what()
+  {
+    return _what.what();
+  }
+};
+
+/*!
+@brief lists the regular files of directory trees on multiple threads
+
+Directories are handed out to the threads from a shared queue, each thread reads the entries of a directory in large
+blocks (getdents64 on Linux) and uses the type in the entry, so regular files are not stat'ed. Files that are hard
+linked more than once are listed only once. Symbolic links are skipped unless they are followed, directories are
+visited once even if several links point to them.
+
+Patterns are shell globs (fnmatch). A pattern with a '/' is matched against the path relative to the root of the
+tree, otherwise against the name of the file or directory. Excluded directories are not read at all.
+*/
+class dir_walker
+{
+private:
+  vector<string> includes;
+  vector<string> excludes;
+  bool           follow_symlinks;
+  unsigned       max_threads;
+
+public:
+  /*!
+  @brief constructor
+
+  @param _max_threads maximum number of threads, 0 for default_thread_count()
+  */
+  explicit dir_walker(unsigned _max_threads = 0);
+
+  /*!
+  @brief only files matching one of the include patterns are listed, all files if there is none
+  */
+  void include(const string &glob);
+
+  /*!
+  @brief files and directories matching one of the exclude patterns are skipped
+  */
+  void exclude(const string &glob);
+
+  /*!
+  @brief symbolic links to files and directories are followed if true, skipped otherwise (default)
+  */
+  void set_follow_symlinks(bool follow);
+
+  /*!
+  @brief lists the files in the given directory trees
+
+  @param rel_paths receives the path of each file relative to the root it has been found in if not nullptr
+  @return paths of the files (root followed by the relative path), sorted
+  @throw dir_walker_exception if a directory cannot be read
+  */
+  vector<string> walk(const vector<string> &roots, vector<string> *rel_paths = nullptr) const;
+
+  /*!
+  @brief checks a file or directory against the include and exclude patterns like walk() does
+
+  @param rel_path path relative to the root of the tree
+  @param name     name of the file or directory
+  */
+  bool selects(const string &rel_path, const char *name, bool is_dir) const;
+
+  /*!
+  @brief checks a name and the path relative to the root against a list of patterns
+  */
+  static bool matches(const vector<string> &patterns, const string &rel_path, const char *name);
+};
+
+#endif //CEALR_DIR_WALKER_H
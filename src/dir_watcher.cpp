@@ -0,0 +1,276 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "dir_watcher.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <iostream>
+#include <unordered_set>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+
+static string join(const string &dir, const char *name)
+{
+  return dir.empty() ? string(name) : dir + "/" + name;
+}
+
+dir_watcher::dir_watcher(const string &root, const dir_walker &_filter) : filter(_filter),
+                                                                          buffer(DIR_WATCHER_BUFFER_SIZE)
+{
+  struct stat st{};
+  if (stat(root.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+  {
+    throw dir_watcher_exception(__FILE__, __LINE__, "\"" + root + "\" is not a directory.");
+  }
+  if ((inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) < 0)
+  {
+    throw dir_watcher_exception(__FILE__, __LINE__, string("Cannot watch directories: ") + strerror(errno));
+  }
+  root_path = root;
+  while (root_path.size() > 1 && root_path.back() == '/')
+  {
+    root_path.pop_back();
+  }
+  last_read = time(nullptr);
+  try
+  {
+    add_dir(root_path, "", DIR_WATCHER_NO_FILES);
+  }
+  catch (...)
+  {
+    close(inotify_fd);
+    throw;
+  }
+}
+
+dir_watcher::~dir_watcher()
+{
+  close(inotify_fd);
+}
+
+void dir_watcher::add_dir(const string &path, const string &rel_path, time_t changed_since)
+{
+  const int wd = inotify_add_watch(inotify_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+  if (wd < 0)
+  {
+    if (rel_path.empty())
+    {
+      throw dir_watcher_exception(__FILE__, __LINE__, "Cannot watch \"" + path + "\": " + strerror(errno));
+    }
+    // removed in the meantime
+    return;
+  }
+  // a directory moved within the tree keeps its watch descriptor, only the path changes
+  dirs[wd] = {path, rel_path};
+
+  // subdirectories and files created before the watch has been added would be missed otherwise
+  DIR *dir = opendir(path.c_str());
+  if (!dir)
+  {
+    return;
+  }
+  vector<pair<string, string>> subdirs;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != nullptr)
+  {
+    const char *name = entry->d_name;
+    if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+    {
+      continue;
+    }
+    unsigned char type = entry->d_type;
+    struct stat   st{};
+    // the time of the last change is only needed when some of the files are reported
+    if (type == DT_UNKNOWN || (type == DT_REG && changed_since > 0 && changed_since != DIR_WATCHER_NO_FILES))
+    {
+      if (fstatat(dirfd(dir), name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+      {
+        continue;
+      }
+      type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_UNKNOWN;
+    }
+    const string child_rel_path = join(rel_path, name);
+    if (type == DT_DIR && filter.selects(child_rel_path, name, true))
+    {
+      subdirs.emplace_back(path + "/" + name, child_rel_path);
+    }
+    else if (type == DT_REG && changed_since != DIR_WATCHER_NO_FILES &&
+             (!changed_since || st.st_ctime >= changed_since) && filter.selects(child_rel_path, name, false))
+    {
+      pending.push_back(path + "/" + name);
+    }
+  }
+  closedir(dir);
+  for (const auto &subdir:subdirs)
+  {
+    add_dir(subdir.first, subdir.second, changed_since);
+  }
+}
+
+void dir_watcher::read_events()
+{
+  // events dropped by the kernel have happened after the last read
+  const time_t since = last_read;
+  last_read          = time(nullptr);
+  const ssize_t len = read(inotify_fd, buffer.data(), buffer.size());
+  if (len < 0)
+  {
+    if (errno == EINTR || errno == EAGAIN)
+    {
+      return;
+    }
+    throw dir_watcher_exception(__FILE__, __LINE__, string("Cannot read events: ") + strerror(errno));
+  }
+  for (const char *p = buffer.data(); p < buffer.data() + len;)
+  {
+    const auto *event = reinterpret_cast<const inotify_event *>(p);
+    p += sizeof(inotify_event) + event->len;
+    if (event->mask & IN_Q_OVERFLOW)
+    {
+      cerr << "Warning: Files have been completed faster than they could be sealed, scanning \"" << root_path
+           << "\" for the files changed in the meantime." << endl;
+      try
+      {
+        // a second earlier, the time of the last change only has a resolution of seconds
+        add_dir(root_path, "", since - 1);
+      }
+      catch (dir_watcher_exception &)
+      {
+        // the root has been removed, reported by IN_IGNORED
+      }
+      continue;
+    }
+    if (event->mask & IN_IGNORED)
+    {
+      // the directory has been removed
+      dirs.erase(event->wd);
+      continue;
+    }
+    const auto dir = dirs.find(event->wd);
+    if (dir == dirs.end() || !event->len)
+    {
+      continue;
+    }
+    const char   *name     = event->name;
+    const string path      = dir->second.path + "/" + name;
+    const string rel_path  = join(dir->second.rel_path, name);
+    if (event->mask & IN_ISDIR)
+    {
+      if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && filter.selects(rel_path, name, true))
+      {
+        // files may have been written into a new directory before it has been watched
+        add_dir(path, rel_path, 0);
+      }
+    }
+    else if ((event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) && filter.selects(rel_path, name, false))
+    {
+      pending.push_back(path);
+    }
+  }
+}
+
+bool dir_watcher::next(vector<string> &files, size_t max_files, long max_delay)
+{
+  files.clear();
+  unordered_set<string> batch;
+  chrono::steady_clock::time_point deadline;
+  while (true)
+  {
+    while (!pending.empty() && files.size() < max_files)
+    {
+      string file = move(pending.front());
+      pending.pop_front();
+      struct stat st{};
+      // removed in the meantime or completed again in this batch
+      if (stat(file.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || !batch.insert(file).second)
+      {
+        continue;
+      }
+      if (files.empty())
+      {
+        deadline = chrono::steady_clock::now() + chrono::milliseconds(max_delay);
+      }
+      files.push_back(move(file));
+    }
+    if (files.size() >= max_files || dirs.empty())
+    {
+      break;
+    }
+    int timeout = -1;
+    if (!files.empty())
+    {
+      const auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+      if (left <= 0)
+      {
+        break;
+      }
+      timeout = static_cast<int>(left);
+    }
+    pollfd poll_fd{inotify_fd, POLLIN, 0};
+    const int ready = poll(&poll_fd, 1, timeout);
+    if (ready < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw dir_watcher_exception(__FILE__, __LINE__, string("Cannot wait for events: ") + strerror(errno));
+    }
+    if (ready == 0)
+    {
+      break;
+    }
+    read_events();
+  }
+  return !files.empty();
+}
+
+void dir_watcher::retry(const vector<string> &files)
+{
+  pending.insert(pending.begin(), files.begin(), files.end());
+}
+
+#else
+
+dir_watcher::dir_watcher(const string &root, const dir_walker &_filter) : filter(_filter)
+{
+  inotify_fd = -1;
+  throw dir_watcher_exception(__FILE__, __LINE__, "Watching \"" + root + "\" is only supported on Linux.");
+}
+
+dir_watcher::~dir_watcher() = default;
+
+void dir_watcher::add_dir(const string &, const string &, time_t)
+{
+}
+
+void dir_watcher::read_events()
+{
+}
+
+bool dir_watcher::next(vector<string> &files, size_t, long)
+{
+  files.clear();
+  return false;
+}
+
+void dir_watcher::retry(const vector<string> &)
+{
+}
+
+#endif
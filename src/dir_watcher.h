@@ -0,0 +1,123 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_DIR_WATCHER_H
+#define CEALR_DIR_WATCHER_H
+
+#include "dir_walker.h"
+#include <ctime>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// size of the buffer the events are read into
+#define DIR_WATCHER_BUFFER_SIZE 0x10000
+// maximum number of files sealed with one registration in watch mode
+#define WATCH_BATCH_SIZE        10000
+// milliseconds a batch waits for more files after the first one has arrived
+#define WATCH_BATCH_DELAY       2000
+// number of batches a file is sealed with before a failing registration is given up
+#define WATCH_SEAL_ATTEMPTS     3
+// value of changed_since for dir_watcher::add_dir() selecting no files
+#define DIR_WATCHER_NO_FILES    numeric_limits<time_t>::max()
+
+class dir_watcher_exception : public exception
+{
+private:
+  runtime_error _what;
+
+public:
+  dir_watcher_exception(const string &file, const int line, const string &errStr) : _what(("" + file + ":" + to_string(line) + ": " + errStr).c_str()) {}
+
+  const char *what()
+  {
+    return _what.what();
+  }
+};
+
+/*!
+@brief reports the files completed in a directory tree (inotify on Linux)
+
+A file is reported when the process writing it closes it (IN_CLOSE_WRITE) or when it is moved into the tree
+(IN_MOVED_TO), so files are neither reported while they are written nor found by scanning the tree again. New
+directories are watched as soon as they are created. The files already in a directory created or moved into the tree
+are reported as well, because there may be no event for them. A file still being written into a new directory is
+reported again when it is completed, if that happens in the same batch it is returned once. If the kernel drops events
+(IN_Q_OVERFLOW) the tree is scanned again for the files changed since the events were read the last time.
+
+The include and exclude patterns of a dir_walker select the files and directories like in dir_walker::walk().
+*/
+class dir_watcher
+{
+private:
+  struct watched_dir
+  {
+    string path;
+    string rel_path;  //!< path relative to the root, empty for the root
+  };
+
+  int                              inotify_fd;
+  string                           root_path;
+  time_t                           last_read;  //!< time the events have been read the last time
+  const dir_walker                &filter;
+  unordered_map<int, watched_dir>  dirs;     //!< watched directories by watch descriptor
+  deque<string>                    pending;  //!< files reported but not yet returned by next()
+  vector<char>                     buffer;
+
+  /*!
+  @brief watches a directory and its subdirectories
+
+  @param changed_since the files changed (ctime) at or after this time are added to pending, 0 for all files and
+  DIR_WATCHER_NO_FILES for none
+  */
+  void add_dir(const string &path, const string &rel_path, time_t changed_since);
+
+  /*!
+  @brief reads the available events and adds the completed files to pending
+  */
+  void read_events();
+
+public:
+  /*!
+  @brief constructor starting to watch the tree, files already in it are not reported
+
+  @throw dir_watcher_exception if root is not a directory or cannot be watched
+  */
+  dir_watcher(const string &root, const dir_walker &_filter);
+
+  ~dir_watcher();
+
+  dir_watcher(const dir_watcher &) = delete;
+
+  dir_watcher &operator=(const dir_watcher &) = delete;
+
+  /*!
+  @brief waits for the next batch of files
+
+  Blocks until a file has been completed, then collects files until max_files are ready or max_delay milliseconds
+  have passed since the first one. A file completed several times in that time is returned once.
+
+  @return false if the root of the tree has been removed and no files are left
+  */
+  bool next(vector<string> &files, size_t max_files, long max_delay);
+
+  /*!
+  @brief returns files to be included in the next batch again, e.g. because their registration has failed
+  */
+  void retry(const vector<string> &files);
+};
+
+#endif //CEALR_DIR_WATCHER_H
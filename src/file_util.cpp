@@ -10,6 +10,7 @@
  */
 
 #include "file_util.h"
+#include "hex.h"
 #include <openssl/sha.h>
 
 bool dir_exists(const string &path)
@@ -103,15 +104,22 @@ mode_t set_file_permissions(const string path, const mode_t attrs)
   return attr1;
 }
 
-string to_hex(const unsigned char *data, const size_t size)
+string xdg_dir(const char *variable, const string &fallback)
 {
-  stringstream buf;
-  for (int i = 0; i < size; i++)
+  const char *dir = getenv(variable);
+  if (dir && dir[0] == '/')
   {
-    buf << hex << setw(2) << setfill('0') << (int) data[i];
+    return dir;
   }
+  const char *home = getenv("HOME");
+  return !fallback.empty() && fallback[0] == '~' && home ? home + fallback.substr(1) : fallback;
+}
 
-  return buf.str();
+string to_hex(const unsigned char *data, const size_t size)
+{
+  string ret(2 * size, '\0');
+  hex_codec::encode(data, size, &ret[0]);
+  return ret;
 }
 
 char get_single_character_answer(const string &question, const set<char> valid_answers, const char default_answer)
@@ -177,7 +185,7 @@ string *get_string_matching(const string &question, regex regexp)
   return new string(input);
 }
 
-string *get_password(const string &question, int min_length, int min_digits, int min_small, int min_caps, string noTtyError)
+string *get_password(const string &question, int min_length, int min_digits, int min_small, int min_caps)
 {
   bool ok = false;
   string input;
@@ -190,8 +198,7 @@ string *get_password(const string &question, int min_length, int min_digits, int
     }
     else
     {
-      cerr << noTtyError;
-      exit(1);
+      return nullptr;
     }
     unsigned long length = input.length();
     if (length < min_length)
@@ -251,11 +258,15 @@ string *get_opt_str(const string &question)
 
 string format_time(time_t timestamp, string format)
 {
-  struct tm *time;
+  struct tm time{};
   char time_str[40];
   const time_t epoch = timestamp / 1000;
-  time = localtime(&epoch);
-  strftime(time_str, sizeof(time_str), format.c_str(), time);
+#ifdef WIN32
+  localtime_s(&time, &epoch);
+#else
+  localtime_r(&epoch, &time); // thread safe, documents are verified concurrently
+#endif
+  strftime(time_str, sizeof(time_str), format.c_str(), &time);
   return string(time_str);
 }
 
@@ -277,20 +288,18 @@ string trim(const string str)
 
 int hex_digit_val(const char ch)
 {
-  const auto l_ch = tolower(ch);
-  return isdigit(l_ch) ? l_ch - '0' : l_ch - 'a' + 10;
+  if (ch >= '0' && ch <= '9')
+  {
+    return ch - '0';
+  }
+  const auto l_ch = ch | 0x20;
+  return (l_ch >= 'a' && l_ch <= 'f') ? l_ch - 'a' + 10 : -1;
 }
 
 vector<char> from_hex(const string &hex)
 {
-  const auto len = hex.size() / 2;
-  vector<char> ret = vector<char>(len, 0);
-  for (int i = 0, j=0; i < len; i++)
-  {
-    const auto raw = hex_digit_val(hex[j++]) << 4;
-    ret[i] = (char) (raw | hex_digit_val(hex[j++]));
-  }
-
+  vector<char> ret = vector<char>(hex.size() / 2, 0);
+  hex_codec::decode(hex.data(), hex.size(), (unsigned char *) ret.data());
   return ret;
 }
 
@@ -186,6 +186,16 @@ mode_t get_file_permissions(string path);
 */
 mode_t set_file_permissions(string path, mode_t attrs);
 
+/*!
+@brief get a directory of the XDG base directory specification
+
+@param variable environment variable naming the directory, e.g. "XDG_CACHE_HOME"
+@param fallback directory used if the variable is not set or not an absolute path, a leading '~' is replaced by $HOME
+
+@return the directory, which may not exist yet
+*/
+string xdg_dir(const char *variable, const string &fallback);
+
 /*!
 @prompts user for password
 
@@ -196,12 +206,10 @@ This method is prompting the user for a password until the typed in password mat
 @param min_digits specifies the minimum number of digits for the password to be accepted.
 @param min_small  specifies the minimum number of small letters for the password to be accepted.
 @param min_caps   specifies the minimum number of capital letters for the password to be accepted.
-@param noTtyError error to be printed out, if the password input is not possible because it can not be hidden
-       nor protected (file as standard input stream)
-
-@return entered password
+@return entered password or nullptr if the password cannot be entered because the input can not be hidden nor
+        protected (file as standard input stream)
 */
-string *get_password(const string &question, int min_length, int min_digits, int min_small, int min_caps, string noTtyError);
+string *get_password(const string &question, int min_length, int min_digits, int min_small, int min_caps);
 
 /*!
 @brief input string that matches regex
@@ -263,7 +271,7 @@ integer value 0-15
 
 @param ch ASCII character may 0-9, a-f or A-F to be interpreted as a hexadecimal digit.
 
-@return value of the given digit (0-15).
+@return value of the given digit (0-15) or -1 if ch is not a hexadecimal digit.
 */
 int hex_digit_val(char ch);
 
@@ -286,6 +294,8 @@ vector.
 @param hex contains the string with hexadecimal ASCII characters
 
 @return vector with bytes that are matching the values of the string, converted from hexadecimal digits
+
+@throw hex_exception if the string has an odd length or contains characters that are not hexadecimal digits
 */
 vector<char> from_hex(const string &hex);
 
@@ -0,0 +1,200 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "hex.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HEX_X86_SIMD
+#include <immintrin.h>
+#endif
+
+static constexpr const char *hex_digits = "0123456789abcdef";
+
+static constexpr unsigned char hex_values[] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+// a vectorized kernel processes whole blocks and returns the number of bytes it has encoded/decoded
+typedef size_t (*encode_kernel)(const unsigned char *in, size_t len, char *out);
+typedef size_t (*decode_kernel)(const char *in, size_t len, unsigned char *out);
+
+static size_t encode_none(const unsigned char *, size_t, char *)
+{
+  return 0;
+}
+
+static size_t decode_none(const char *, size_t, unsigned char *)
+{
+  return 0;
+}
+
+#ifdef HEX_X86_SIMD
+
+__attribute__((target("ssse3")))
+static size_t encode_ssse3(const unsigned char *in, size_t len, char *out)
+{
+  const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16, out += 32)
+  {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i hi    = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+    const __m128i lo    = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, nibble));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+  return i;
+}
+
+// returns the values of 16 hexadecimal digits, sets invalid if one of them is not a hexadecimal digit
+__attribute__((target("ssse3")))
+static inline __m128i decode_digits_ssse3(__m128i chars, __m128i &invalid)
+{
+  const __m128i digit     = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  const __m128i is_digit  = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  const __m128i letter    = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  const __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+  invalid = _mm_or_si128(invalid, _mm_andnot_si128(_mm_or_si128(is_digit, is_letter), _mm_set1_epi8(-1)));
+  return _mm_or_si128(_mm_and_si128(is_digit, digit),
+                      _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const char *in, size_t len, unsigned char *out)
+{
+  // multiplies the value of the higher digit of each pair by 16 and adds the value of the lower digit
+  const __m128i weights = _mm_set1_epi16(0x0110);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16)
+  {
+    __m128i invalid = _mm_setzero_si128();
+    const __m128i first  = decode_digits_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i)), invalid);
+    const __m128i second = decode_digits_ssse3(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 2 * i + 16)),
+                                               invalid);
+    if (_mm_movemask_epi8(invalid))
+    {
+      break; // the scalar decoder reports the invalid character
+    }
+    const __m128i bytes = _mm_packus_epi16(_mm_maddubs_epi16(first, weights), _mm_maddubs_epi16(second, weights));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), bytes);
+  }
+  return i;
+}
+
+#endif //HEX_X86_SIMD
+
+static encode_kernel select_encode_kernel()
+{
+#ifdef HEX_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    return encode_ssse3;
+  }
+#endif
+  return encode_none;
+}
+
+static decode_kernel select_decode_kernel()
+{
+#ifdef HEX_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("ssse3"))
+  {
+    return decode_ssse3;
+  }
+#endif
+  return decode_none;
+}
+
+void hex_codec::encode(const void *data, size_t len, char *out)
+{
+  static const encode_kernel kernel = select_encode_kernel();
+  const auto *in = static_cast<const unsigned char *>(data);
+  size_t i = kernel(in, len, out);
+  for (; i < len; i++)
+  {
+    out[2 * i]     = hex_digits[in[i] >> 4];
+    out[2 * i + 1] = hex_digits[in[i] & 0x0f];
+  }
+}
+
+void hex_codec::decode(const char *in, size_t in_len, unsigned char *out)
+{
+  if (in_len & 1)
+  {
+    throw hex_exception(__FILE__, __LINE__, "Odd number of hexadecimal digits in \"" + string(in, in_len) + "\".");
+  }
+  static const decode_kernel kernel = select_decode_kernel();
+  const size_t len = in_len / 2;
+  size_t i = kernel(in, len, out);
+  for (; i < len; i++)
+  {
+    const unsigned char hi = hex_values[static_cast<unsigned char>(in[2 * i])];
+    const unsigned char lo = hex_values[static_cast<unsigned char>(in[2 * i + 1])];
+    if ((hi | lo) == 0xff)
+    {
+      throw hex_exception(__FILE__, __LINE__, "Illegal hexadecimal digit in \"" + string(in, in_len) + "\".");
+    }
+    out[i] = static_cast<unsigned char>((hi << 4) | lo);
+  }
+}
+
+void hex_codec::encode_batch(const unsigned char *digests, size_t count, size_t size, string *out)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i].resize(2 * size);
+    encode(digests + i * size, size, &out[i][0]);
+  }
+}
+
+string hex_codec::encode_list(const unsigned char *digests, size_t count, size_t size, char separator)
+{
+  if (!count)
+  {
+    return string();
+  }
+  string list(count * (2 * size + 1) - 1, separator);
+  for (size_t i = 0; i < count; i++)
+  {
+    encode(digests + i * size, size, &list[i * (2 * size + 1)]);
+  }
+  return list;
+}
+
+void hex_codec::decode_batch(const string *hex, size_t count, size_t size, unsigned char *out)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    if (hex[i].size() != 2 * size)
+    {
+      throw hex_exception(__FILE__, __LINE__, "Illegal length of hexadecimal digest \"" + hex[i] + "\".");
+    }
+    decode(hex[i].data(), hex[i].size(), out + i * size);
+  }
+}
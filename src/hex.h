@@ -0,0 +1,77 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_HEX_H
+#define CEALR_HEX_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+class hex_exception : public exception
+{
+private:
+  runtime_error _what;
+
+public:
+  hex_exception(const string &file, const int line, const string &errStr) : _what(("" + file + ":" + to_string(line) + ": " + errStr).c_str()) {}
+
+  const char *what()
+  {
+    return _what.what();
+  }
+};
+
+/*!
+@brief hexadecimal codec
+
+Bytes are encoded as lower case digits, decoding accepts upper and lower case digits and rejects everything else. Blocks
+of 16 bytes are encoded/decoded with SSSE3 if the CPU supports it (checked once at runtime), the remainder and all
+other CPUs use lookup tables.
+*/
+class hex_codec
+{
+public:
+  /*!
+  @brief encodes len bytes into 2 * len characters provided by the caller, no terminating null character is written
+  */
+  static void encode(const void *data, size_t len, char *out);
+
+  /*!
+  @brief decodes in_len hexadecimal digits into in_len / 2 bytes provided by the caller
+
+  @throw hex_exception if in_len is odd or the input contains a character that is not a hexadecimal digit
+  */
+  static void decode(const char *in, size_t in_len, unsigned char *out);
+
+  /*!
+  @brief encodes count digests of size bytes each, stored consecutively in digests
+
+  @param out array of count strings receiving the hexadecimal digests
+  */
+  static void encode_batch(const unsigned char *digests, size_t count, size_t size, string *out);
+
+  /*!
+  @brief encodes count digests of size bytes each into one string, separated by separator
+  */
+  static string encode_list(const unsigned char *digests, size_t count, size_t size, char separator);
+
+  /*!
+  @brief decodes count hexadecimal digests of size bytes each and stores them consecutively in out
+
+  @throw hex_exception if a digest does not have 2 * size hexadecimal digits
+  */
+  static void decode_batch(const string *hex, size_t count, size_t size, unsigned char *out);
+};
+
+#endif //CEALR_HEX_H
@@ -0,0 +1,193 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "key_cache.h"
+#include "file_util.h"
+#include "properties.h"
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <unistd.h>
+
+key_cache::key_cache(const string &_file)
+{
+  file    = properties::get_full_file_name(_file);
+  entries = json::object();
+  loaded  = false;
+  changed = false;
+}
+
+key_cache::~key_cache()
+{
+  if (changed)
+  {
+    try
+    {
+      save();
+    }
+    catch (...)
+    {
+      // the cache is only an optimization
+    }
+  }
+}
+
+key_cache &key_cache::instance()
+{
+  static key_cache cache(xdg_dir("XDG_CACHE_HOME", "~/.cache") + "/" + DEFAULT_KEY_CACHE);
+  return cache;
+}
+
+void key_cache::load()
+{
+  loaded = true;
+  ifstream ifs(file.c_str());
+  if (ifs.is_open())
+  {
+    try
+    {
+      ifs >> entries;
+    }
+    catch (exception &)
+    {
+      // a corrupted cache is rebuilt
+      entries = json::object();
+    }
+    if (!entries.is_object())
+    {
+      entries = json::object();
+    }
+  }
+}
+
+const json *key_cache::find(const string &fpr)
+{
+  if (!loaded)
+  {
+    load();
+  }
+  const auto entry = entries.find(fpr);
+  if (entry == entries.end() || !entry->is_object() || !entry->count("fetched") ||
+      !entry->at("fetched").is_number_integer() || (entry->count("keys") && !entry->at("keys").is_array()))
+  {
+    return nullptr;
+  }
+  const bool missing = entry->count("missing") != 0;
+  const long age     = time(nullptr) - entry->at("fetched").get<long>();
+  return age >= 0 && age < (missing ? KEY_CACHE_MISSING_TTL : KEY_CACHE_TTL) ? &*entry : nullptr;
+}
+
+bool key_cache::get_keys(const string &fpr, list<map<string, string>> &keys)
+{
+  lock_guard<mutex> lock(cache_mutex);
+  const json *entry = find(fpr);
+  if (!entry || !entry->count("keys"))
+  {
+    return false;
+  }
+  list<map<string, string>> cached;
+  for (const json &key:entry->at("keys"))
+  {
+    if (!key.is_object())
+    {
+      return false;
+    }
+    map<string, string> values;
+    for (auto value = key.begin(); value != key.end(); ++value)
+    {
+      if (!value.value().is_string())
+      {
+        return false;
+      }
+      values[value.key()] = value.value();
+    }
+    cached.push_back(values);
+  }
+  keys.swap(cached);
+  return true;
+}
+
+void key_cache::put_keys(const string &fpr, const list<map<string, string>> &keys)
+{
+  lock_guard<mutex> lock(cache_mutex);
+  if (!loaded)
+  {
+    load();
+  }
+  json key_list = json::array();
+  for (const auto &key:keys)
+  {
+    key_list.push_back(key);
+  }
+  entries[fpr] = {{"fetched", static_cast<long>(time(nullptr))}, {"keys", key_list}};
+  changed = true;
+}
+
+bool key_cache::is_missing(const string &fpr)
+{
+  lock_guard<mutex> lock(cache_mutex);
+  const json *entry = find(fpr);
+  return entry && entry->count("missing");
+}
+
+void key_cache::put_missing(const string &fpr)
+{
+  lock_guard<mutex> lock(cache_mutex);
+  if (!loaded)
+  {
+    load();
+  }
+  entries[fpr] = {{"fetched", static_cast<long>(time(nullptr))}, {"missing", true}};
+  changed = true;
+}
+
+void key_cache::remove(const string &fpr)
+{
+  lock_guard<mutex> lock(cache_mutex);
+  if (!loaded)
+  {
+    load();
+  }
+  changed = entries.erase(fpr) != 0 || changed;
+}
+
+void key_cache::save()
+{
+  lock_guard<mutex> lock(cache_mutex);
+  json valid = json::object();
+  for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+  {
+    if (find(entry.key()))
+    {
+      valid[entry.key()] = entry.value();
+    }
+  }
+  string *dir = super_path(file);
+  if (dir)
+  {
+    mkdirs(*dir);
+    delete dir;
+  }
+  // written to a temporary file first, so a concurrent invocation never reads a partial cache
+  const string tmp_file = file + "." + to_string(getpid()) + ".tmp";
+  ofstream ofs(tmp_file.c_str(), ofstream::out | ofstream::trunc);
+  if (ofs.fail())
+  {
+    throw file_exception(tmp_file);
+  }
+  ofs << valid.dump();
+  ofs.close();
+  if (ofs.fail() || rename(tmp_file.c_str(), file.c_str()) != 0)
+  {
+    throw file_exception(file);
+  }
+  changed = false;
+}
@@ -0,0 +1,104 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_KEY_CACHE_H
+#define CEALR_KEY_CACHE_H
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+using namespace std;
+
+// cache file relative to the XDG cache directory ($XDG_CACHE_HOME or ~/.cache), ~/.cealr is not writable
+static const char *const DEFAULT_KEY_CACHE = "cealr/keycache.json";
+
+// seconds the data of a public key is used before it is read from the keyring again
+#define KEY_CACHE_TTL 86400
+// seconds a key that has not been found on the key server is not looked up again
+#define KEY_CACHE_MISSING_TTL 3600
+
+/*!
+@brief cache of the public key data needed to verify signatures, by fingerprint
+
+Verifying many documents signed by the same few keys needs one keyring or key server lookup per key instead of one per
+signature. The entries are kept in memory and in DEFAULT_KEY_CACHE, so they are shared by later invocations until
+they expire. Keys that have not been found on the key server are cached as missing (with a shorter time to live).
+
+All methods may be called from several threads.
+*/
+class key_cache
+{
+private:
+  string file;
+  json   entries;  //!< fingerprint -> {"fetched": <time>, "keys": [...]} or {"fetched": <time>, "missing": true}
+  bool   loaded;
+  bool   changed;
+  mutex  cache_mutex;
+
+  void load();
+
+  /*!
+  @brief returns the entry for fpr if it has not expired, nullptr otherwise (cache_mutex must be locked)
+
+  Malformed entries (e.g. edited by hand) are treated like expired ones.
+  */
+  const json *find(const string &fpr);
+
+public:
+  explicit key_cache(const string &_file);
+
+  /*!
+  @brief destructor, saves the entries if they have changed
+  */
+  ~key_cache();
+
+  key_cache(const key_cache &) = delete;
+
+  key_cache &operator=(const key_cache &) = delete;
+
+  /*!
+  @brief the cache in DEFAULT_KEY_CACHE shared by all verifications
+  */
+  static key_cache &instance();
+
+  /*!
+  @brief gets the key data (as returned by open_pgp::list_public_keys()) of a fingerprint
+
+  @return false if there is no valid entry
+  */
+  bool get_keys(const string &fpr, list<map<string, string>> &keys);
+
+  void put_keys(const string &fpr, const list<map<string, string>> &keys);
+
+  /*!
+  @brief returns true if the key has recently not been found on the key server
+  */
+  bool is_missing(const string &fpr);
+
+  void put_missing(const string &fpr);
+
+  /*!
+  @brief removes the entry of a fingerprint, e.g. after the key has been imported or signed
+  */
+  void remove(const string &fpr);
+
+  /*!
+  @brief writes the entries that have not expired to the cache file
+  */
+  void save();
+};
+
+#endif //CEALR_KEY_CACHE_H
@@ -0,0 +1,262 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "libcealr.h"
+#include "cealr.h"
+#include "base64.h"
+#include "curl_util.h"
+#include "hex.h"
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+struct cealr_client
+{
+  string *server;
+  string *api_key;
+  string *api_credential;
+  mutex              pending_mutex;
+  condition_variable finished;
+  size_t             pending;  //!< asynchronous calls that have not finished yet
+};
+
+static char *copy_string(const string &str)
+{
+  auto *copy = static_cast<char *>(malloc(str.size() + 1));
+  if (copy)
+  {
+    memcpy(copy, str.c_str(), str.size() + 1);
+  }
+  return copy;
+}
+
+// the exceptions of cealr do not share a base class with a virtual what(), so each of them is caught on its own
+static int run_safely(const function<void()> &action, string &error)
+{
+  try
+  {
+    action();
+    return CEALR_OK;
+  }
+  catch (print_usage_msg &e)
+  {
+    error = e.what();
+  }
+  catch (pgp_exception &e)
+  {
+    error = e.what();
+  }
+  catch (base64_exception &e)
+  {
+    error = e.what();
+  }
+  catch (hex_exception &e)
+  {
+    error = e.what();
+  }
+  catch (SmartStampError &e)
+  {
+    error = e.what();
+  }
+  catch (file_exception &e)
+  {
+    error = e.what();
+  }
+  catch (curl_exception &e)
+  {
+    error = e.what();
+  }
+  catch (cealr_exception &e)
+  {
+    error = e.what();
+  }
+  catch (exception &e)
+  {
+    error = e.what();
+  }
+  catch (...)
+  {
+    error = "Unknown error.";
+  }
+  return CEALR_ERROR;
+}
+
+static int run_safely(const function<void()> &action, char **error)
+{
+  string message;
+  const int status = run_safely(action, message);
+  if (status != CEALR_OK && error)
+  {
+    *error = copy_string(message);
+  }
+  return status;
+}
+
+static vector<string> file_list(const char *const *files, size_t count)
+{
+  if (!files && count)
+  {
+    throw cealr_exception(__FILE__, __LINE__, "No file names have been given.");
+  }
+  return vector<string>(files, files + count);
+}
+
+// each call has its own cealr object, the state shared by all of them (keys, connections) is thread-safe
+static json run_files(const cealr_client *client, const vector<string> &files, bool seal)
+{
+  if (!client)
+  {
+    throw cealr_exception(__FILE__, __LINE__, "No client has been given.");
+  }
+  json records = json::array();
+  cealr engine(client->server, client->api_key, client->api_credential, [&records](const json &record)
+  {
+    records.push_back(record);
+  });
+  if (seal)
+  {
+    engine.seal_files(files);
+  }
+  else
+  {
+    engine.verify_files(files);
+  }
+  return records;
+}
+
+cealr_client *cealr_client_new(const char *server, const char *api_key, const char *api_credential)
+{
+  auto *client = new(nothrow) cealr_client;
+  if (client)
+  {
+    client->server         = server ? new string(server) : nullptr;
+    client->api_key        = api_key ? new string(api_key) : nullptr;
+    client->api_credential = api_credential ? new string(api_credential) : nullptr;
+    client->pending        = 0;
+  }
+  return client;
+}
+
+void cealr_client_free(cealr_client *client)
+{
+  if (!client)
+  {
+    return;
+  }
+  {
+    unique_lock<mutex> lock(client->pending_mutex);
+    client->finished.wait(lock, [client]()
+    {
+      return client->pending == 0;
+    });
+  }
+  delete client->server;
+  delete client->api_key;
+  delete client->api_credential;
+  delete client;
+}
+
+int cealr_hash_file(const char *file, char *hex_hash, char **error)
+{
+  return run_safely([file, hex_hash]()
+  {
+    ifstream ifs(file ? file : "", ifstream::binary);
+    if (!ifs.is_open())
+    {
+      throw file_exception(file ? file : "");
+    }
+    unsigned char md[SHA256_DIGEST_LENGTH];
+    getHash(ifs, md);
+    hex_codec::encode(md, SHA256_DIGEST_LENGTH, hex_hash);
+    hex_hash[2 * SHA256_DIGEST_LENGTH] = '\0';
+  }, error);
+}
+
+int cealr_seal(cealr_client *client, const char *const *files, size_t count, char **result, char **error)
+{
+  return run_safely([client, files, count, result]()
+  {
+    *result = copy_string(run_files(client, file_list(files, count), true).dump());
+  }, error);
+}
+
+int cealr_seal_async(cealr_client *client, const char *const *files, size_t count, cealr_callback callback,
+                     void *user_data)
+{
+  if (!client || !callback || (!files && count))
+  {
+    return CEALR_ERROR;
+  }
+  const vector<string> names(files, files + count);
+  {
+    lock_guard<mutex> lock(client->pending_mutex);
+    client->pending++;
+  }
+  try
+  {
+    thread([client, names, callback, user_data]()
+    {
+      string result;
+      string error;
+      const int status = run_safely([client, &names, &result]()
+      {
+        result = run_files(client, names, true).dump();
+      }, error);
+      callback(user_data, status, status == CEALR_OK ? result.c_str() : nullptr,
+               status == CEALR_OK ? nullptr : error.c_str());
+      lock_guard<mutex> lock(client->pending_mutex);
+      client->pending--;
+      client->finished.notify_all();
+    }).detach();
+  }
+  catch (system_error &)
+  {
+    lock_guard<mutex> lock(client->pending_mutex);
+    client->pending--;
+    client->finished.notify_all();
+    return CEALR_ERROR;
+  }
+  return CEALR_OK;
+}
+
+int cealr_verify(cealr_client *client, const char *const *files, size_t count, char **result, char **error)
+{
+  return run_safely([client, files, count, result]()
+  {
+    *result = copy_string(run_files(client, file_list(files, count), false).dump());
+  }, error);
+}
+
+int cealr_verify_smart_stamp(const char *smart_stamp, const char *hex_hash, char **result, char **error)
+{
+  return run_safely([smart_stamp, hex_hash, result]()
+  {
+    if (!smart_stamp || !hex_hash || strlen(hex_hash) != 2 * SHA256_DIGEST_LENGTH)
+    {
+      throw cealr_exception(__FILE__, __LINE__, "A SmartStamp and a SHA-256 hash of 64 hexadecimal digits are "
+                                                "required.");
+    }
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    hex_codec::decode(hex_hash, 2 * SHA256_DIGEST_LENGTH, hash);
+    SmartStamp smartStamp{string(smart_stamp)};
+    SmartStamp::VerificationResult *verification_result = smartStamp.verifyByHash(hash, nullptr, true);
+    const json result_js = verification_result->toJson();
+    delete verification_result;
+    *result = copy_string(result_js.dump());
+  }, error);
+}
+
+void cealr_free(char *str)
+{
+  free(str);
+}
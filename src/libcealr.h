@@ -0,0 +1,114 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_LIBCEALR_H
+#define CEALR_LIBCEALR_H
+
+/*
+ * C interface of libcealr for sealing and verifying files in process.
+ *
+ * All functions may be called from several threads at the same time, also with the same client. They never ask the
+ * user or terminate the process: errors are returned as CEALR_ERROR with a message in *error. Keys of signatures that
+ * are not trusted in the local keyring yet are not imported, signatures of such keys are reported as not verified.
+ *
+ * Results are JSON documents, an array with one record per file for seal and verify (the records of the command line
+ * option --output ndjson). Strings returned in *result and *error are released with cealr_free().
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// return values
+#define CEALR_OK             0
+#define CEALR_ERROR          (-1)
+// size of the buffer for a hexadecimal SHA-256 hash including the terminating null character
+#define CEALR_HEX_HASH_SIZE  65
+
+typedef struct cealr_client cealr_client;
+
+/*!
+@brief called with the result of an asynchronous call on the thread that has run it
+
+@param status CEALR_OK or CEALR_ERROR
+@param result JSON result if status is CEALR_OK, NULL otherwise, only valid during the call
+@param error  error message if status is CEALR_ERROR, NULL otherwise, only valid during the call
+*/
+typedef void (*cealr_callback)(void *user_data, int status, const char *result, const char *error);
+
+/*!
+@brief creates a client for an account
+
+@param server         URL of the API, NULL for the server in ~/.cealr/config.properties, CEALR_SERVER or the default
+@param api_key        API key, NULL for CEALR_APIKEY or the key in ~/.cealr/config.properties
+@param api_credential API credential, NULL for CEALR_APICREDENTIAL or the credential in ~/.cealr/config.properties
+@return the client or NULL if there is not enough memory
+*/
+cealr_client *cealr_client_new(const char *server, const char *api_key, const char *api_credential);
+
+/*!
+@brief releases a client, waits for its asynchronous calls to finish
+*/
+void cealr_client_free(cealr_client *client);
+
+/*!
+@brief hashes a file with SHA-256
+
+@param hex_hash receives the hash as CEALR_HEX_HASH_SIZE lower case hexadecimal digits including a terminating null
+*/
+int cealr_hash_file(const char *file, char *hex_hash, char **error);
+
+/*!
+@brief hashes files and seals them with one registration
+
+@param result receives [{"file", "hash", "sealed", "retrievalId"}, ...]
+*/
+int cealr_seal(cealr_client *client, const char *const *files, size_t count, char **result, char **error);
+
+/*!
+@brief like cealr_seal(), but returns at once and passes the result to callback
+
+The file names are copied before the function returns.
+
+@return CEALR_ERROR if the call could not be started, callback is not called then
+*/
+int cealr_seal_async(cealr_client *client, const char *const *files, size_t count, cealr_callback callback,
+                     void *user_data);
+
+/*!
+@brief hashes files and verifies their registrations, including the SmartStamps and the signatures in the sealed
+       metadata
+
+@param result receives one record per file and registration, {"file", "registered": false} for unregistered files
+*/
+int cealr_verify(cealr_client *client, const char *const *files, size_t count, char **result, char **error);
+
+/*!
+@brief verifies a SmartStamp returned by the API for a hash without contacting the server
+
+@param smart_stamp textual representation of the SmartStamp ("data" of an entry of "smartStamps")
+@param hex_hash    SHA-256 hash of the document as 64 hexadecimal digits
+@param result      receives {"verified", "sources", "additionalInfo", "instructions"}
+*/
+int cealr_verify_smart_stamp(const char *smart_stamp, const char *hex_hash, char **result, char **error);
+
+/*!
+@brief releases a string returned by libcealr, NULL is ignored
+*/
+void cealr_free(char *str);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //CEALR_LIBCEALR_H
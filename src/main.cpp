@@ -0,0 +1,67 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "cealr.h"
+#include "cealr_daemon.h"
+#include <iostream>
+
+int main(int argc, const char **argv)
+{
+  // --daemon and --connect are handled before the other options, which are run by the daemon
+  string socket_path = cealr_daemon::default_socket();
+  bool daemon_mode  = false;
+  bool connect_mode = false;
+  vector<const char *> args{argv[0]};
+  for (int i = 1; i < argc; i++)
+  {
+    const string arg = argv[i];
+    if (arg == "--daemon")
+    {
+      daemon_mode = true;
+    }
+    else if (arg == "--connect")
+    {
+      connect_mode = true;
+    }
+    else if (arg == "--socket" && i + 1 < argc)
+    {
+      socket_path = argv[++i];
+    }
+    else
+    {
+      args.push_back(argv[i]);
+    }
+  }
+  if (!daemon_mode && !connect_mode)
+  {
+    return run_cealr(static_cast<int>(args.size()), args.data());
+  }
+  try
+  {
+    if (daemon_mode)
+    {
+      cealr_daemon daemon(socket_path);
+      daemon.run();
+      return 0;
+    }
+    return cealr_daemon::forward(socket_path, vector<string>(args.begin() + 1, args.end()));
+  }
+  catch (daemon_exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
+  }
+  catch (exception &e)
+  {
+    cerr << e.what() << endl;
+    return 1;
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "manifest.h"
+#include "file_util.h"
+#include "properties.h"
+#include <algorithm>
+#include <openssl/sha.h>
+
+manifest_reader::manifest_reader(const string &file, char _delimiter)
+{
+  file_name = file;
+  delimiter = _delimiter;
+  if (file == "-")
+  {
+    in      = &cin;
+    owns_in = false;
+  }
+  else
+  {
+    auto ifs = new ifstream(file.c_str(), ifstream::in | ifstream::binary);
+    if (!ifs->is_open())
+    {
+      delete ifs;
+      throw file_exception(file);
+    }
+    in      = ifs;
+    owns_in = true;
+  }
+}
+
+manifest_reader::~manifest_reader()
+{
+  if (owns_in)
+  {
+    delete in;
+  }
+}
+
+// true if the entry starts with a hexadecimal SHA-256 hash followed by the separator of sha256sum
+static bool has_hash(const string &entry)
+{
+  const size_t len = 2 * SHA256_DIGEST_LENGTH;
+  if (entry.size() < len + 3 || entry[len] != ' ' || (entry[len + 1] != ' ' && entry[len + 1] != '*'))
+  {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++)
+  {
+    if (hex_digit_val(entry[i]) < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool manifest_reader::next(manifest_entry &result)
+{
+  while (getline(*in, entry, delimiter))
+  {
+    if (delimiter == '\n' && !entry.empty() && entry.back() == '\r')
+    {
+      entry.pop_back();
+    }
+    if (entry.empty())
+    {
+      continue;
+    }
+    size_t start = 0;
+    result.hash.clear();
+    if (has_hash(entry))
+    {
+      result.hash.assign(entry, 0, 2 * SHA256_DIGEST_LENGTH);
+      start = 2 * SHA256_DIGEST_LENGTH + 2;
+    }
+    // like on the command line the version follows the last '@'
+    const size_t ver_pos = entry.find_last_of('@');
+    if (ver_pos != string::npos && ver_pos >= start)
+    {
+      result.file.assign(entry, start, ver_pos - start);
+      result.version.assign(entry, ver_pos + 1, string::npos);
+    }
+    else
+    {
+      result.file.assign(entry, start, string::npos);
+      result.version.clear();
+    }
+    return true;
+  }
+  if (in->bad())
+  {
+    throw file_exception(file_name);
+  }
+  return false;
+}
+
+// line of a canonical manifest
+static string manifest_line(const string &name, const string &hash)
+{
+  string line(hash);
+  transform(line.begin(), line.end(), line.begin(), ::tolower);
+  return line.append("  ").append(name);
+}
+
+string signed_manifest::build(const vector<string> &names, const vector<string> &hashes)
+{
+  vector<string> lines;
+  lines.reserve(names.size());
+  for (size_t i = 0; i < names.size(); i++)
+  {
+    lines.push_back(manifest_line(names[i], hashes[i]));
+  }
+  sort(lines.begin(), lines.end());
+  string manifest;
+  for (const string &line:lines)
+  {
+    manifest.append(line).push_back('\n');
+  }
+  return manifest;
+}
+
+signed_manifest::signed_manifest(const string &manifest)
+{
+  size_t start = 0;
+  while (start < manifest.size())
+  {
+    size_t end = manifest.find('\n', start);
+    if (end == string::npos)
+    {
+      end = manifest.size();
+    }
+    entries.insert(manifest.substr(start, end - start));
+    start = end + 1;
+  }
+}
+
+bool signed_manifest::contains(const string &name, const string &hash) const
+{
+  return entries.count(manifest_line(name, hash)) != 0;
+}
+
+size_t signed_manifest::size() const
+{
+  return entries.size();
+}
@@ -0,0 +1,115 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_MANIFEST_H
+#define CEALR_MANIFEST_H
+
+#include <istream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+// number of manifest entries that are hashed and submitted together
+#define MANIFEST_BATCH_SIZE 10000
+
+/*!
+@brief entry of a manifest
+*/
+struct manifest_entry
+{
+  string file;
+  string hash;     //!< precomputed hexadecimal SHA-256 hash or empty
+  string version;  //!< empty if no version is given
+};
+
+/*!
+@brief reads the files to be sealed or verified from a manifest
+
+Each entry is one line (or one NUL terminated string, e.g. from find -print0) in the format
+"[<hash>  ]<file>[@<version>]". The optional hash is a hexadecimal SHA-256 hash, followed by two spaces (or a space and
+an asterisk) like in the output of sha256sum, so files that have been hashed before are not read again. Empty entries
+are skipped. Entries are read one at a time, so the manifest may be of any size.
+*/
+class manifest_reader
+{
+private:
+  string   file_name;
+  istream *in;
+  bool     owns_in;
+  char     delimiter;
+  string   entry;
+
+public:
+  /*!
+  @brief constructor opening a manifest file
+
+  @param file name of the manifest file or "-" for standard input
+  @param _delimiter '\n' for one entry per line or '\0' for NUL terminated entries
+  @throw file_exception if the file cannot be opened
+  */
+  manifest_reader(const string &file, char _delimiter);
+
+  ~manifest_reader();
+
+  manifest_reader(const manifest_reader &) = delete;
+
+  manifest_reader &operator=(const manifest_reader &) = delete;
+
+  /*!
+  @brief reads the next entry
+
+  @return false at the end of the manifest
+  @throw file_exception if the manifest cannot be read
+  */
+  bool next(manifest_entry &result);
+};
+
+/*!
+@brief canonical manifest of the names and hashes of many files, signed once instead of signing each file
+
+The manifest has one line "<hash>  <name>" per file (the format of sha256sum and of manifest_reader) with the lower case
+hexadecimal SHA-256 hash of the file and its name: the path relative to the root for files of a tree given with
+--recursive, the name without path otherwise. The lines are sorted, so the same files always give the same manifest,
+regardless of the order in which they have been given.
+*/
+class signed_manifest
+{
+private:
+  unordered_set<string> entries;
+
+public:
+  /*!
+  @brief builds the canonical manifest
+
+  @param names names of the files (see cealr::signed_file_names())
+  @param hashes hexadecimal SHA-256 hashes of the files, in the order of names
+  */
+  static string build(const vector<string> &names, const vector<string> &hashes);
+
+  /*!
+  @brief constructor reading the entries of a manifest built by build()
+  */
+  explicit signed_manifest(const string &manifest);
+
+  /*!
+  @brief returns true if the manifest lists a file with this name and hash
+  */
+  bool contains(const string &name, const string &hash) const;
+
+  /*!
+  @brief returns the number of files listed in the manifest
+  */
+  size_t size() const;
+};
+
+#endif //CEALR_MANIFEST_H
@@ -0,0 +1,252 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "merkle_tree.h"
+#include "parallel.h"
+
+// number of node pairs hashed by one thread at a time
+#define PAIRS_PER_CHUNK 4096
+
+merkle_tree::merkle_tree(BundleMethod _method, bool _keep_levels)
+{
+  if (_method != BundleMethod::BALANCED_MERKLE_TREE && _method != BundleMethod::BALANCED_CONCURRENT_MERKLE_TREE)
+  {
+    throw SmartStampError(__FILE__, __LINE__, "Bundle method " + to_string(_method) + " is not supported.");
+  }
+  method      = _method;
+  keep_levels = _keep_levels;
+  levels.resize(1);
+  built       = false;
+  indexed     = false;
+}
+
+void merkle_tree::add_leaf(const unsigned char *hash)
+{
+  levels.resize(1);
+  levels[0].insert(levels[0].end(), hash, hash + SHA256_DIGEST_LENGTH);
+  built = false;
+  if (indexed)
+  {
+    leaf_index.emplace(string(reinterpret_cast<const char *>(hash), SHA256_DIGEST_LENGTH), leaf_count() - 1);
+  }
+}
+
+void merkle_tree::add_leaf(const string &hex_hash)
+{
+  vector<char> hash = from_hex(hex_hash);
+  if (hash.size() != SHA256_DIGEST_LENGTH)
+  {
+    throw SmartStampError(__FILE__, __LINE__, "Illegal length of hash \"" + hex_hash + "\".");
+  }
+  add_leaf((unsigned char *) &hash[0]);
+}
+
+void merkle_tree::reserve_leaves(size_t count)
+{
+  levels.resize(1);
+  levels[0].resize(count * SHA256_DIGEST_LENGTH);
+  built   = false;
+  indexed = false;
+  leaf_index.clear();
+}
+
+void merkle_tree::set_leaf(size_t index, const unsigned char *hash)
+{
+  memcpy(&levels[0][index * SHA256_DIGEST_LENGTH], hash, SHA256_DIGEST_LENGTH);
+}
+
+size_t merkle_tree::leaf_count() const
+{
+  return levels[0].size() / SHA256_DIGEST_LENGTH;
+}
+
+const unsigned char *merkle_tree::leaf(size_t index) const
+{
+  return &levels[0][index * SHA256_DIGEST_LENGTH];
+}
+
+long merkle_tree::find_leaf(const unsigned char *hash) const
+{
+  if (!indexed)
+  {
+    const size_t count = leaf_count();
+    leaf_index.clear();
+    leaf_index.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+      // emplace keeps the first leaf of equal hashes
+      leaf_index.emplace(string(reinterpret_cast<const char *>(leaf(i)), SHA256_DIGEST_LENGTH), i);
+    }
+    indexed = true;
+  }
+  const auto found = leaf_index.find(string(reinterpret_cast<const char *>(hash), SHA256_DIGEST_LENGTH));
+  return found == leaf_index.end() ? -1 : static_cast<long>(found->second);
+}
+
+void merkle_tree::build()
+{
+  if (!leaf_count())
+  {
+    throw SmartStampError(__FILE__, __LINE__, "Cannot build a Merkle tree without leaves.");
+  }
+  levels.resize(1);
+  vector<unsigned char> current = hash_leaves(levels[0]); // in root only mode the last calculated level
+  const vector<unsigned char> *lower = &current;
+  if (keep_levels)
+  {
+    levels.push_back(std::move(current));
+    lower = &levels.back();
+  }
+  while (lower->size() > SHA256_DIGEST_LENGTH)
+  {
+    vector<unsigned char> upper = hash_level(*lower);
+    if (keep_levels)
+    {
+      levels.push_back(std::move(upper));
+      lower = &levels.back();
+    }
+    else
+    {
+      current = std::move(upper);
+      lower   = &current;
+    }
+  }
+  if (lower == &current)
+  {
+    levels.push_back(std::move(current));
+  }
+  built = true;
+}
+
+vector<unsigned char> merkle_tree::hash_leaves(const vector<unsigned char> &hashes) const
+{
+  const size_t count = hashes.size() / SHA256_DIGEST_LENGTH;
+  vector<unsigned char> leaves(hashes.size());
+  auto hash_leaf = [&hashes, &leaves](size_t i)
+  {
+    unsigned char prefixed[1 + SHA256_DIGEST_LENGTH];
+    prefixed[0] = MERKLE_LEAF_PREFIX;
+    memcpy(prefixed + 1, &hashes[i * SHA256_DIGEST_LENGTH], SHA256_DIGEST_LENGTH);
+    SHA256(prefixed, sizeof(prefixed), &leaves[i * SHA256_DIGEST_LENGTH]);
+  };
+  if (method == BundleMethod::BALANCED_CONCURRENT_MERKLE_TREE)
+  {
+    parallel_for(count, hash_leaf, 2 * PAIRS_PER_CHUNK);
+  }
+  else
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      hash_leaf(i);
+    }
+  }
+  return leaves;
+}
+
+vector<unsigned char> merkle_tree::hash_level(const vector<unsigned char> &lower) const
+{
+  const size_t nodes = lower.size() / SHA256_DIGEST_LENGTH;
+  vector<unsigned char> upper(((nodes + 1) / 2) * SHA256_DIGEST_LENGTH);
+  auto hash_pair = [&lower, &upper](size_t pair)
+  {
+    unsigned char prefixed[1 + 2 * SHA256_DIGEST_LENGTH];
+    prefixed[0] = MERKLE_NODE_PREFIX;
+    memcpy(prefixed + 1, &lower[2 * pair * SHA256_DIGEST_LENGTH], 2 * SHA256_DIGEST_LENGTH);
+    SHA256(prefixed, sizeof(prefixed), &upper[pair * SHA256_DIGEST_LENGTH]);
+  };
+  if (method == BundleMethod::BALANCED_CONCURRENT_MERKLE_TREE)
+  {
+    parallel_for(nodes / 2, hash_pair, PAIRS_PER_CHUNK);
+  }
+  else
+  {
+    for (size_t pair = 0; pair < nodes / 2; pair++)
+    {
+      hash_pair(pair);
+    }
+  }
+  if (nodes & 1)
+  {
+    // odd node is promoted without hashing
+    memcpy(&upper[(nodes / 2) * SHA256_DIGEST_LENGTH], &lower[(nodes - 1) * SHA256_DIGEST_LENGTH],
+           SHA256_DIGEST_LENGTH);
+  }
+  return upper;
+}
+
+const unsigned char *merkle_tree::root()
+{
+  if (!built)
+  {
+    build();
+  }
+  return &levels.back()[0];
+}
+
+vector<merkle_step> merkle_tree::path(size_t index)
+{
+  if (index >= leaf_count())
+  {
+    throw SmartStampError(__FILE__, __LINE__, "Leaf index " + to_string(index) + " is out of range.");
+  }
+  if (!built)
+  {
+    build();
+  }
+  if (!keep_levels)
+  {
+    throw SmartStampError(__FILE__, __LINE__, "The levels of the Merkle tree have not been kept.");
+  }
+  vector<merkle_step> steps;
+  for (size_t level = 1; level + 1 < levels.size(); level++, index >>= 1)
+  {
+    size_t sibling = index ^ 1;
+    if (sibling < levels[level].size() / SHA256_DIGEST_LENGTH)
+    {
+      merkle_step step{};
+      step.opcode = (index & 1) ? OPCODE_PREPEND_THEN_NODE_SHA256 : OPCODE_APPEND_THEN_NODE_SHA256;
+      memcpy(step.hash, &levels[level][sibling * SHA256_DIGEST_LENGTH], SHA256_DIGEST_LENGTH);
+      steps.push_back(step);
+    }
+  }
+  return steps;
+}
+
+vector<char> *merkle_tree::compose_stamp(SmartStamp &root_stamp, size_t index)
+{
+  const long doc_hash_offset = root_stamp.getDocHashOffset();
+  if (doc_hash_offset < 0)
+  {
+    throw SmartStampError(__FILE__, __LINE__, "The SmartStamp for the root of the bundle has no document hash.");
+  }
+  if (memcmp(root_stamp.getDocHash(), root(), SHA256_DIGEST_LENGTH) != 0)
+  {
+    throw SmartStampError(__FILE__, __LINE__, "The SmartStamp has not been issued for the root of this bundle.");
+  }
+  const vector<merkle_step> steps = path(index);
+  const vector<char> &raw         = *root_stamp.toRawData();
+  const auto offset               = static_cast<size_t>(doc_hash_offset);
+  const size_t op_size            = 1 + SHA256_DIGEST_LENGTH;
+
+  auto composed = new vector<char>();
+  composed->reserve(raw.size() + 1 + steps.size() * op_size);
+  composed->insert(composed->end(), raw.begin(), raw.begin() + offset);
+  composed->push_back(OPCODE_DOC_SHA256);
+  composed->insert(composed->end(), leaf(index), leaf(index) + SHA256_DIGEST_LENGTH);
+  composed->push_back(OPCODE_LEAF_SHA256);
+  for (const merkle_step &step:steps)
+  {
+    composed->push_back(step.opcode);
+    composed->insert(composed->end(), step.hash, step.hash + SHA256_DIGEST_LENGTH);
+  }
+  composed->insert(composed->end(), raw.begin() + offset + op_size, raw.end());
+  return composed;
+}
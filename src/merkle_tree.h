@@ -0,0 +1,145 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_MERKLE_TREE_H
+#define CEALR_MERKLE_TREE_H
+
+#include <unordered_map>
+#include <vector>
+#include "smart_stamp.h"
+
+using namespace std;
+
+/*!
+@brief one step on the path from a leaf to the root of a Merkle tree
+
+The opcode is either OPCODE_APPEND_THEN_NODE_SHA256 or OPCODE_PREPEND_THEN_NODE_SHA256 and is applied with the sibling
+hash exactly as the corresponding SmartStamp operation does.
+*/
+struct merkle_step
+{
+  char          opcode;
+  unsigned char hash[SHA256_DIGEST_LENGTH];
+};
+
+/*!
+@brief Merkle tree over SHA-256 document hashes
+
+Bundles many document hashes into one root hash, so that only the root needs to be registered with Cryptowerk. The
+SmartStamp of every single document is composed locally from its path in this tree and the SmartStamp the server
+returns for the root.
+
+The tree is balanced: each document hash is hashed as leaf (MERKLE_LEAF_PREFIX || hash), the nodes of each level are
+hashed pairwise (MERKLE_NODE_PREFIX || left || right) and an odd node at the end of a level is promoted unchanged to the
+next level. The prefixes keep an inner node from being passed off as a leaf. BALANCED_CONCURRENT_MERKLE_TREE builds
+exactly the same tree, but hashes the nodes of each level on all cores. Both produce the same paths.
+*/
+class merkle_tree
+{
+private:
+  BundleMethod method;
+  vector<vector<unsigned char>> levels; //!< levels[0] contains the document hashes, levels[1] the hashed leaves, the
+                                        //!< last level the root (32 bytes per node)
+  bool keep_levels;
+  bool built;
+  mutable unordered_map<string, size_t> leaf_index; //!< first leaf with each hash, built by find_leaf()
+  mutable bool indexed;
+
+  /*!
+  @brief hashes each document hash with the leaf prefix
+  */
+  vector<unsigned char> hash_leaves(const vector<unsigned char> &hashes) const;
+
+  /*!
+  @brief hashes the nodes of one level pairwise into the next level
+  */
+  vector<unsigned char> hash_level(const vector<unsigned char> &lower) const;
+
+public:
+  /*!
+  @brief constructor with bundle method
+
+  @param _method bundle method, BALANCED_MERKLE_TREE or BALANCED_CONCURRENT_MERKLE_TREE
+  @param _keep_levels if false, only the leaves and the root are kept after build() (root only mode, memory stays
+         proportional to the number of leaves), path() and compose_stamp() are not available in this case
+  */
+  explicit merkle_tree(BundleMethod _method = BundleMethod::BALANCED_MERKLE_TREE, bool _keep_levels = true);
+
+  /*!
+  @brief adds a document hash as next leaf of the tree
+
+  @param hash points to SHA256_DIGEST_LENGTH bytes
+  */
+  void add_leaf(const unsigned char *hash);
+
+  /*!
+  @brief adds a document hash in hexadecimal notation as next leaf of the tree
+  */
+  void add_leaf(const string &hex_hash);
+
+  /*!
+  @brief sets the number of leaves in advance, so they can be filled in any order with set_leaf()
+  */
+  void reserve_leaves(size_t count);
+
+  /*!
+  @brief sets the leaf with the given index
+
+  Leaves with different indexes may be set from different threads at the same time, e.g. directly from the threads
+  hashing the documents. Leaves set after find_leaf() has been called are not found by it until the next
+  reserve_leaves().
+  */
+  void set_leaf(size_t index, const unsigned char *hash);
+
+  size_t leaf_count() const;
+
+  const unsigned char *leaf(size_t index) const;
+
+  /*!
+  @brief finds the first leaf with the given hash
+
+  The first call indexes the leaves by their hash, so looking up all leaves of a large bundle stays linear. It must not
+  be called from several threads at the same time.
+
+  @return index of the leaf or -1, if the hash is not part of the tree
+  */
+  long find_leaf(const unsigned char *hash) const;
+
+  /*!
+  @brief calculates all levels of the tree up to the root
+  */
+  void build();
+
+  /*!
+  @brief returns the root hash of the tree (builds the tree if necessary)
+  */
+  const unsigned char *root();
+
+  /*!
+  @brief returns the Append/Prepend steps from the hashed leaf with the given index to the root
+  */
+  vector<merkle_step> path(size_t index);
+
+  /*!
+  @brief composes the SmartStamp for a leaf
+
+  The operations of the SmartStamp for the root are kept as they are, only its document hash is replaced by the hash
+  of the leaf followed by the leaf operation and the path from the leaf to the root.
+
+  @param root_stamp SmartStamp that has been returned by the server for the root hash of this tree
+  @param index index of the leaf
+
+  @return raw data of the SmartStamp for the leaf
+  */
+  vector<char> *compose_stamp(SmartStamp &root_stamp, size_t index);
+};
+
+#endif //CEALR_MERKLE_TREE_H
@@ -34,6 +34,7 @@ unsigned char *sha256_digest::digest()
 {
   auto *hash = new unsigned char[SHA256_DIGEST_LENGTH];
   SHA256_Final(hash, sha256_ctx);
+  SHA256_Init(sha256_ctx); // reset for the next digest
   return hash;
 }
 
@@ -12,6 +12,62 @@
 //#include <vector>
 //#include <sstream>
 #include "open_pgp.h"
+#include "key_cache.h"
+#include "parallel.h"
+#include <sys/stat.h>
+
+// files of the GPG home directory that change when keys or signatures are added or removed
+static const char *const KEYRING_FILES[] = {"pubring.kbx", "pubring.gpg", "secring.gpg", "private-keys-v1.d",
+                                            "trustdb.gpg"};
+
+/*!
+@brief keys looked up by open_pgp::prefetch_keys(), released when it returns or throws
+*/
+struct looked_up_keys
+{
+  vector<gpgme_key_t> keys;
+
+  explicit looked_up_keys(size_t count) : keys(count, nullptr)
+  {
+  }
+
+  ~looked_up_keys()
+  {
+    for (gpgme_key_t _key:keys)
+    {
+      if (_key)
+      {
+        gpgme_key_release(_key);
+      }
+    }
+  }
+
+  looked_up_keys(const looked_up_keys &) = delete;
+
+  looked_up_keys &operator=(const looked_up_keys &) = delete;
+};
+
+mutex open_pgp::interaction_mutex;
+map<string, open_pgp::native_key> open_pgp::native_keys;
+string open_pgp::native_keys_stamp;
+mutex open_pgp::native_keys_mutex;
+gpgme_error_t open_pgp::engine_error = 0;
+
+void open_pgp::init_engine()
+{
+  static once_flag initialized;
+  call_once(initialized, []()
+  {
+    gpgme_check_version (nullptr);
+    setlocale(LC_ALL, "");
+    gpgme_set_locale(nullptr, LC_CTYPE, setlocale(LC_CTYPE, nullptr));
+#ifndef WIN32
+    gpgme_set_locale(nullptr, LC_MESSAGES, setlocale(LC_MESSAGES, nullptr));
+#endif
+    // the version of gpg is checked once per process, not for every context
+    engine_error = gpgme_engine_check_version(GPGME_PROTOCOL_OpenPGP);
+  });
+}
 
 open_pgp::open_pgp(gpgme_sig_mode_t _sig_mode, properties *_properties, const string *email_addr)
 {
@@ -25,13 +81,9 @@ open_pgp::open_pgp(gpgme_sig_mode_t _sig_mode, properties *_properties, const st
   key_id = nullptr;
   key_name = nullptr;
   key_email = nullptr;
-  gpgme_check_version (nullptr);
-  setlocale(LC_ALL, "");
-  gpgme_set_locale(nullptr, LC_CTYPE, setlocale(LC_CTYPE, nullptr));
-#ifndef WIN32
-  gpgme_set_locale(nullptr, LC_MESSAGES, setlocale(LC_MESSAGES, nullptr));
-#endif
-  if ((err = gpgme_engine_check_version(GPGME_PROTOCOL_OpenPGP)))
+  interactive = true;
+  init_engine();
+  if ((err = engine_error))
   {
     throw pgp_exception(__FILE__, __LINE__, err);
   }
@@ -52,14 +104,18 @@ open_pgp::open_pgp(gpgme_sig_mode_t _sig_mode, properties *_properties, const st
   key_server = p_properties->get("keyServer", new string(OPENPGP_DEFAULT_KEYSERVER), false);
   if (key_server->find("://") == string::npos)
   {
-    string *old = key_server;
-    *key_server = "hkp://" + *key_server;
-    delete old;
+    // the value is owned by the properties, which are shared by all contexts
+    key_server = new string("hkp://" + *key_server);
   }
 }
 
 open_pgp::open_pgp(gpgme_sig_mode_t _sig_mode, properties *properties) : open_pgp(_sig_mode, properties, nullptr) {}
 
+void open_pgp::set_interactive(bool _interactive)
+{
+  interactive = _interactive;
+}
+
 open_pgp::~open_pgp()
 {
   if (in)
@@ -88,10 +144,21 @@ open_pgp::~open_pgp()
 //  delete key_server;
 }
 
-string open_pgp::sign(const string file_to_be_signed)
+string open_pgp::sign(const string file_to_be_signed, bool export_signing_key)
+{
+  return sign_source(file_to_be_signed, true, export_signing_key);
+}
+
+string open_pgp::sign_data(const string &data, bool export_signing_key)
+{
+  return sign_source(data, false, export_signing_key);
+}
+
+string open_pgp::sign_source(const string &source, bool is_file, bool export_signing_key)
 {
-  // Create a data object pointing to the input file
-  if ((err = gpgme_data_new_from_file(&in, file_to_be_signed.c_str(), 1)))
+  // Create a data object pointing to the input file or data
+  if ((err = is_file ? gpgme_data_new_from_file(&in, source.c_str(), 1)
+                     : gpgme_data_new_from_mem(&in, source.data(), source.size(), 0)))
   {
     throw pgp_exception(__FILE__, __LINE__, err);
   }
@@ -101,7 +168,10 @@ string open_pgp::sign(const string file_to_be_signed)
   {
     throw pgp_exception(__FILE__, __LINE__, err);
   }
-  select_best_signing_key();
+  if (!key)
+  {
+    select_best_signing_key();
+  }
   if (!key){
     stringstream s;
     s << "There is no private key to sign with installed with your GPG right now." << endl
@@ -138,18 +208,108 @@ string open_pgp::sign(const string file_to_be_signed)
   auto arr = new char[size + 1];
   copy(sig, &(sig[size]), arr);
   arr[size] = 0;
+  delete signature;
   signature = new string(arr);
   delete[] sig;
   delete[] arr;
 
-  // check if this->key is uploaded on the default key server and upload it, if not (maybe store the key ID as uploaded in the properties?).
-  export_key(key->fpr);
+  if (export_signing_key)
+  {
+    // check if this->key is uploaded on the default key server and upload it, if not (maybe store the key ID as uploaded in the properties?).
+    export_key(key->fpr);
+  }
 
   return *signature;
 }
 
+gpgme_key_t open_pgp::get_signing_key() const
+{
+  return key;
+}
+
+void open_pgp::set_signing_key(gpgme_key_t _key)
+{
+  gpgme_key_ref(_key);
+  if (key)
+  {
+    gpgme_key_release(key);
+  }
+  key = _key;
+  gpgme_signers_clear(ctx);
+  gpgme_signers_add(ctx, key);
+  delete key_id;
+  delete key_name;
+  delete key_email;
+  key_id    = new string(key->subkeys->keyid);
+  key_name  = key->uids && key->uids->name ? new string(key->uids->name) : nullptr;
+  key_email = key->uids && key->uids->email ? new string(key->uids->email) : nullptr;
+}
+
+string open_pgp::keyring_stamp()
+{
+  const char *home_dir = gpgme_get_dirinfo("homedir");
+  string home;
+  if (home_dir)
+  {
+    home = home_dir;
+  }
+  else if (getenv("GNUPGHOME"))
+  {
+    home = getenv("GNUPGHOME");
+  }
+  else if (getenv("HOME"))
+  {
+    home = string(getenv("HOME")) + "/.gnupg";
+  }
+  stringstream stamp;
+  for (const char *file:KEYRING_FILES)
+  {
+    struct stat st{};
+    if (stat((home + "/" + file).c_str(), &st) == 0)
+    {
+      stamp << file << ":" << st.st_mtime << ":" << st.st_size << ";";
+    }
+  }
+  return stamp.str();
+}
+
+bool open_pgp::select_cached_signing_key()
+{
+  string *fpr          = p_properties->get("signingKey");
+  string *key_for      = p_properties->get("signingKeyEmail");
+  string *keyring      = p_properties->get("signingKeyring");
+  const bool same_email = (key_for ? *key_for : "") == (email ? *email : "");
+  gpgme_key_t cached   = nullptr;
+  if (fpr && keyring && same_email && *keyring == keyring_stamp())
+  {
+    if (gpgme_get_key(ctx, fpr->c_str(), &cached, 1))
+    {
+      cached = nullptr;
+    }
+    else if (cached->invalid || cached->revoked || cached->expired || cached->disabled || !can_sign(cached))
+    {
+      gpgme_key_release(cached);
+      cached = nullptr;
+    }
+  }
+  delete fpr;
+  delete key_for;
+  delete keyring;
+  if (!cached)
+  {
+    return false;
+  }
+  set_signing_key(cached);
+  gpgme_key_release(cached);
+  return true;
+}
+
 void open_pgp::select_best_signing_key()
 {
+  if (select_cached_signing_key())
+  {
+    return;
+  }
   gpgme_set_keylist_mode(ctx, GPGME_KEYLIST_MODE_LOCAL);
   gpgme_key_t signing_key = nullptr;
   err = gpgme_op_keylist_start(ctx, nullptr, 1);
@@ -257,6 +417,9 @@ void open_pgp::select_best_signing_key()
       }
     }
     key = signing_key;
+    p_properties->put("signingKey",      signing_key->fpr ? signing_key->fpr : signing_key->subkeys->fpr);
+    p_properties->put("signingKeyEmail", email ? *email : "");
+    p_properties->put("signingKeyring",  keyring_stamp());
   }
   else
   {
@@ -354,6 +517,17 @@ list<map<string, string>> open_pgp::list_public_keys(const string *opt_pattern)
   return list_keys(opt_pattern, 0);
 }
 
+list<map<string, string>> open_pgp::cached_public_keys(const string &fpr)
+{
+  list<map<string, string>> keys;
+  if (!key_cache::instance().get_keys(fpr, keys))
+  {
+    keys = list_public_keys(&fpr);
+    key_cache::instance().put_keys(fpr, keys);
+  }
+  return keys;
+}
+
 // listing installed private keys
 // implement listing, installed public keys
 list<map<string, string>> open_pgp::list_private_keys(const string *opt_pattern)
@@ -387,22 +561,42 @@ json open_pgp::toJson() const
   }
   if (signature)
   {
-    size_t start = strlen(BEGIN_PGP_SIGNATURE);
-    size_t end = strlen(END_PGP_SIGNATURE);
-    unsigned long size = signature->size();
-    string sig = signature->substr(start, size - start - end);
-    replace(sig.begin(), sig.end(), '\n', ' ');
-    json["signature"] = sig;
+    json["signature"] = compact_signature(*signature);
   }
   return json;
 }
 
+string open_pgp::compact_signature(const string &sig)
+{
+  size_t start = strlen(BEGIN_PGP_SIGNATURE);
+  size_t end = strlen(END_PGP_SIGNATURE);
+  unsigned long size = sig.size();
+  string ret = sig.substr(start, size - start - end);
+  replace(ret.begin(), ret.end(), '\n', ' ');
+  return ret;
+}
+
 //todo implement generating key pair
 
 // verify signature
 json open_pgp::verify(const string &file_to_be_verified, string *_signature)
 {
-  gpgme_verify_result_t verResult = verify_file_signature(file_to_be_verified, _signature);
+  return verify_source(file_to_be_verified, true, _signature);
+}
+
+json open_pgp::verify_data(const string &data, string *_signature)
+{
+  return verify_source(data, false, _signature);
+}
+
+json open_pgp::verify_source(const string &source, bool is_file, string *_signature)
+{
+  json native_result;
+  if (verify_natively(source, is_file, _signature ? _signature : signature, native_result))
+  {
+    return native_result;
+  }
+  gpgme_verify_result_t verResult = verify_file_signature(source, is_file, _signature);
   gpgme_sigsum_t  sig_sum       = verResult->signatures->summary;
   string          fpr           = verResult->signatures->fpr;
   bool            isKeyMissing  = (sig_sum & GPGME_SIGSUM_KEY_MISSING)!= 0;
@@ -410,8 +604,17 @@ json open_pgp::verify(const string &file_to_be_verified, string *_signature)
   bool            retry         = false;
   if (!isValid)
   {
+    // looking up, importing and trusting keys may ask the user, one verification at a time
+    lock_guard<mutex> lock(interaction_mutex);
     if (isKeyMissing)
     {
+      // prefetch_keys() caches missing keys by key id, the last 16 digits of the fingerprint
+      if (key_cache::instance().is_missing(fpr) ||
+          (fpr.size() > 16 && key_cache::instance().is_missing(fpr.substr(fpr.size() - 16))))
+      {
+        // not looked up on the key server again for every signature
+        throw pgp_exception(__FILE__, __LINE__, "The key with fingerprint "+fpr+" has not been found");
+      }
       retry = find_and_import_key(fpr);
     }
     else if (verResult->signatures->validity == GPGME_VALIDITY_UNKNOWN)
@@ -429,6 +632,7 @@ json open_pgp::verify(const string &file_to_be_verified, string *_signature)
           {
             throw pgp_exception(__FILE__, __LINE__, err);
           }
+          key_cache::instance().remove(fpr);
         }
         gpgme_key_release(_key);
       }
@@ -436,7 +640,7 @@ json open_pgp::verify(const string &file_to_be_verified, string *_signature)
   }
   if (retry)
   {
-    verResult     = verify_file_signature(file_to_be_verified, _signature);
+    verResult     = verify_file_signature(source, is_file, _signature);
     sig_sum       = verResult->signatures->summary;
     isKeyMissing  = (sig_sum & GPGME_SIGSUM_KEY_MISSING);
     isValid       = (sig_sum & GPGME_SIGSUM_VALID) != 0;
@@ -459,7 +663,7 @@ json open_pgp::verify(const string &file_to_be_verified, string *_signature)
   json["timestamp"]       = verResult->signatures->timestamp;
   json["sigValidity"]     = get_trust_level(verResult->signatures->validity);
   // get key from fpr and add email and other key information
-  const list<map<string, string>> &public_keys = list_public_keys(&fpr);
+  const list<map<string, string>> &public_keys = cached_public_keys(fpr);
   for (const auto &e : public_keys)
   {
     for (const auto &p : e)
@@ -471,15 +675,141 @@ json open_pgp::verify(const string &file_to_be_verified, string *_signature)
   return json;
 }
 
-gpgme_verify_result_t open_pgp::verify_file_signature(const string &file_to_be_verified, string *_signature)
+open_pgp::native_key open_pgp::get_native_key(const string &key_id)
+{
+  lock_guard<mutex> lock(native_keys_mutex);
+  // keys revoked, disabled or with changed trust in the keyring must not be used by a long running process (daemon)
+  const string stamp = keyring_stamp();
+  if (stamp != native_keys_stamp)
+  {
+    native_keys.clear();
+    native_keys_stamp = stamp;
+  }
+  const time_t now = time(nullptr);
+  const auto found = native_keys.find(key_id);
+  if (found != native_keys.end() && found->second.expires > now)
+  {
+    return found->second;
+  }
+  native_key entry;
+  entry.validity = GPGME_VALIDITY_UNKNOWN;
+  entry.expires  = now + KEY_CACHE_TTL;
+  gpgme_key_t _key = nullptr;
+  if (!gpgme_get_key(ctx, key_id.c_str(), &_key, 0) && _key)
+  {
+    gpgme_subkey_t sub_key = _key->subkeys;
+    while (sub_key && (!sub_key->keyid || key_id != sub_key->keyid))
+    {
+      sub_key = sub_key->next;
+    }
+    const bool usable = sub_key && sub_key->fpr && !sub_key->revoked && !sub_key->expired && !sub_key->disabled &&
+                        !sub_key->invalid && !_key->revoked && !_key->expired && !_key->disabled && !_key->invalid &&
+                        _key->uids && _key->uids->validity >= GPGME_VALIDITY_FULL;
+    gpgme_data_t exported = nullptr;
+    if (usable && !gpgme_data_new(&exported) && !gpgme_op_export(ctx, _key->subkeys->fpr, 0, exported))
+    {
+      size_t size;
+      char *data = gpgme_data_release_and_get_mem(exported, &size);
+      exported = nullptr;
+      for (pgp_public_key *public_key:pgp_public_key::parse_armored(string(data, size)))
+      {
+        if (public_key->key_id == key_id)
+        {
+          entry.key.reset(public_key);
+        }
+        else
+        {
+          delete public_key;
+        }
+      }
+      gpgme_free(data);
+      entry.fpr      = sub_key->fpr;
+      entry.validity = _key->uids->validity;
+      // keys expire without a change of the keyring
+      for (const long expires:{sub_key->expires, _key->subkeys->expires})
+      {
+        if (expires > 0 && expires < entry.expires)
+        {
+          entry.expires = expires;
+        }
+      }
+    }
+    if (exported)
+    {
+      gpgme_data_release(exported);
+    }
+    gpgme_key_release(_key);
+  }
+  native_keys[key_id] = entry;
+  return entry;
+}
+
+bool open_pgp::verify_natively(const string &source, bool is_file, string *sig, json &result)
+{
+  if (!sig)
+  {
+    return false;
+  }
+  expand_sig_if_necessary(sig);
+  pgp_signature *parsed = pgp_signature::parse(*sig);
+  if (!parsed)
+  {
+    return false;
+  }
+  const native_key key = get_native_key(parsed->issuer);
+  bool verified = false;
+  if (key.key && is_file)
+  {
+    verified = key.key->verify(*parsed, source);
+  }
+  else if (key.key)
+  {
+    istringstream data(source);
+    verified = key.key->verify(*parsed, data);
+  }
+  const long created   = parsed->created;
+  delete parsed;
+  if (!verified)
+  {
+    // gpg reports the details of invalid signatures
+    return false;
+  }
+  result["isValid"]        = true;
+  result["isSigGood"]      = true;
+  result["isSigBad"]       = false;
+  result["isKeyRevoked"]   = false;
+  result["isKeyExpired"]   = false;
+  result["isSigExpired"]   = false;
+  result["isKeyNotFound"]  = false;
+  result["isCrlMissing"]   = false;
+  result["isCrlTooOld"]    = false;
+  result["isBadPolicy"]    = false;
+  result["isSysError"]     = false;
+  result["isTofuConflict"] = false;
+  result["isDeVS"]         = false;
+  result["fingerprint"]    = key.fpr;
+  result["timestamp"]      = created;
+  result["sigValidity"]    = get_trust_level(key.validity);
+  for (const auto &e : cached_public_keys(key.fpr))
+  {
+    for (const auto &p : e)
+    {
+      result[p.first] = p.second;
+    }
+  }
+  return true;
+}
+
+gpgme_verify_result_t open_pgp::verify_file_signature(const string &source, bool is_file, string *_signature)
 {
   auto *sig = _signature ? _signature : signature;
   if (!sig)
   {
     throw pgp_exception(__FILE__, __LINE__, "No signature set.");
   }
-  // Create a data object pointing to the input file
-  if ((err = gpgme_data_new_from_file(&in, file_to_be_verified.c_str(), 1)))
+  // Create a data object pointing to the input file or data
+  if ((err = is_file ? gpgme_data_new_from_file(&in, source.c_str(), 1)
+                     : gpgme_data_new_from_mem(&in, source.data(), source.size(), 0)))
   {
     throw pgp_exception(__FILE__, __LINE__, err);
   }
@@ -519,6 +849,7 @@ bool open_pgp::find_and_import_key(const string &fpr)
   _keys[0] = find_key(fpr, GPGME_KEYLIST_MODE_EXTERN);
   if (_keys[0] == nullptr)
   {
+    key_cache::instance().put_missing(fpr);
     throw pgp_exception(__FILE__, __LINE__, "The key with fingerprint "+fpr+" has not been found");
   }
   bool success;
@@ -534,6 +865,7 @@ bool open_pgp::find_and_import_key(const string &fpr)
       gpgme_import_result_t result = gpgme_op_import_result(ctx);
       success = result->imported != 0;
     }
+    key_cache::instance().remove(fpr);
     // trust key: sign it; GPGME seems to have no way to manipulate the trust level of a key
     if ((err = gpgme_op_keysign(ctx, _keys[0], nullptr, 0, GPGME_KEYSIGN_LOCAL)))
     {
@@ -545,11 +877,101 @@ bool open_pgp::find_and_import_key(const string &fpr)
   return success;
 }
 
+void open_pgp::prefetch_keys(const set<string> &key_ids)
+{
+  vector<string> missing;
+  for (const string &id:key_ids)
+  {
+    gpgme_key_t _key = nullptr;
+    if (!gpgme_get_key(ctx, id.c_str(), &_key, 0) && _key)
+    {
+      gpgme_key_release(_key);
+    }
+    else if (!key_cache::instance().is_missing(id))
+    {
+      missing.push_back(id);
+    }
+  }
+  if (missing.empty())
+  {
+    return;
+  }
+  gpgme_set_global_flag("auto-key-locate", key_server->c_str());
+  // each lookup waits for the key server in its own context
+  looked_up_keys lookups(missing.size());
+  vector<gpgme_key_t> &found = lookups.keys;
+  // a key is only known to be missing if the key server has been asked successfully, not after network errors
+  vector<char> completed(missing.size(), 0);
+  parallel_for(missing.size(), [&missing, &found, &completed](size_t i)
+  {
+    gpgme_ctx_t lookup_ctx;
+    if (gpgme_new(&lookup_ctx))
+    {
+      return;
+    }
+    gpgme_set_protocol(lookup_ctx, GPGME_PROTOCOL_OpenPGP);
+    gpgme_set_keylist_mode(lookup_ctx, GPGME_KEYLIST_MODE_EXTERN);
+    gpgme_error_t lookup_err = gpgme_op_keylist_start(lookup_ctx, missing[i].c_str(), 0);
+    while (!lookup_err)
+    {
+      gpgme_key_t _key;
+      lookup_err = gpgme_op_keylist_next(lookup_ctx, &_key);
+      if (!lookup_err && (_key->invalid || found[i]))
+      {
+        gpgme_key_release(_key);
+      }
+      else if (!lookup_err)
+      {
+        found[i] = _key;
+      }
+    }
+    completed[i] = gpg_err_code(lookup_err) == GPG_ERR_EOF;
+    gpgme_op_keylist_end(lookup_ctx);
+    gpgme_release(lookup_ctx);
+  }, 1, OPEN_PGP_MAX_KEY_LOOKUPS);
+
+  lock_guard<mutex> lock(interaction_mutex);
+  vector<gpgme_key_t> trusted;
+  for (size_t i = 0; i < missing.size(); i++)
+  {
+    if (!found[i] && completed[i])
+    {
+      key_cache::instance().put_missing(missing[i]);
+    }
+    else if (found[i] && check_trust(found[i]))
+    {
+      trusted.push_back(found[i]);
+    }
+  }
+  if (!trusted.empty())
+  {
+    trusted.push_back(nullptr);
+    if ((err = gpgme_op_import_keys(ctx, trusted.data())))
+    {
+      throw pgp_exception(__FILE__, __LINE__, err);
+    }
+    trusted.pop_back();
+    // trust key: sign it; GPGME seems to have no way to manipulate the trust level of a key
+    for (gpgme_key_t _key:trusted)
+    {
+      key_cache::instance().remove(_key->fpr);
+      if ((err = gpgme_op_keysign(ctx, _key, nullptr, 0, GPGME_KEYSIGN_LOCAL)))
+      {
+        throw pgp_exception(__FILE__, __LINE__, err);
+      }
+    }
+  }
+}
+
 bool open_pgp::check_trust(gpgme_key_t &_key)
 {
   //todo check against known list of trusted key fingerprints to trust key automatically
   //todo check against individual trust path
   //todo check against trust path of keys in trusted key fingerprints
+  if (!interactive)
+  {
+    return false;
+  }
   cout << "Import PGP key " << _key->fpr << "?" << endl;
   cout << " owner name:  \"" << _key->uids->name << "\"" << endl;
   string *ownersEmail = _key->uids->email ? new string(_key->uids->email) : nullptr;
@@ -568,7 +990,7 @@ bool open_pgp::check_trust(gpgme_key_t &_key)
   {
     cout << " this key is disabled" << endl;
   }
-  bool trust = get_single_character_answer("Do you trust this key? [y/N] ", {'Y', 'N'}, 'N');
+  bool trust = get_single_character_answer("Do you trust this key? [y/N] ", {'Y', 'N'}, 'N') == 'Y';
 
   return trust;
 }
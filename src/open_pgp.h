@@ -17,8 +17,12 @@
 //#include <clocale>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include "properties.h"
 #include "file_util.h"
+#include "pgp_verify.h"
 
 #include <gpgme.h>
 #include <nlohmann/json.hpp>
@@ -29,6 +33,8 @@ using namespace std;
 
 #define BEGIN_PGP_SIGNATURE "-----BEGIN PGP SIGNATURE-----\n"
 #define END_PGP_SIGNATURE   "-----END PGP SIGNATURE-----\n"
+// maximum number of keys that are looked up on the key server at the same time by prefetch_keys()
+#define OPEN_PGP_MAX_KEY_LOOKUPS 8
 
 static const char *const OPENPGP_DEFAULT_KEYSERVER = "hkp://pgp.mit.edu";
 
@@ -87,17 +93,64 @@ private:
   gpgme_data_t in, out;
   gpgme_sig_mode_t sig_mode;
   gpgme_key_t key;
+  bool interactive;  //!< false if the user cannot be asked, keys that are not trusted yet are not imported
 
   /*!
   @brief Verifying if a signature is valid for a file
-  this method is verifying if the signature in param _signature matches the file in param file_to_be_verified.
+  this method is verifying if the signature in param _signature matches the file or data in param source.
 
-  @param file_to_be_verified file to verify the signature with
+  @param source file or data to verify the signature with
+  @param is_file true if source is the name of a file, false if it is the signed data itself
   @param _signature to be verified
 
   @return gpgme_verify_result_t structure from gpgme
   */
-  gpgme_verify_result_t verify_file_signature(const string &file_to_be_verified, string *_signature);
+  gpgme_verify_result_t verify_file_signature(const string &source, bool is_file, string *_signature);
+
+  /*!
+  @brief signs a file (is_file true) or data in memory, see sign()
+  */
+  string sign_source(const string &source, bool is_file, bool export_signing_key);
+
+  /*!
+  @brief verifies the signature of a file (is_file true) or data in memory, see verify()
+  */
+  json verify_source(const string &source, bool is_file, string *_signature);
+
+  /*!
+  @brief public key used for in-process verifications
+  */
+  struct native_key
+  {
+    shared_ptr<pgp_public_key> key;  //!< nullptr if signatures of this key are verified by gpg
+    string                     fpr;  //!< fingerprint of the (sub)key as reported by gpg
+    gpgme_validity_t           validity;
+    time_t                     expires;  //!< the entry is looked up again after the key or KEY_CACHE_TTL expires
+  };
+
+  static map<string, native_key> native_keys;  //!< by key id, dropped when the keyring changes (keyring_stamp())
+  static string native_keys_stamp;             //!< keyring_stamp() when native_keys have been looked up
+  static mutex native_keys_mutex;
+  static gpgme_error_t engine_error;  //!< result of the check of the gpg version by init_engine()
+
+  /*!
+  @brief returns the key with the given id for in-process verifications
+
+  Only keys gpg considers fully valid (not expired, revoked or disabled, validity full or ultimate) are used, so a
+  signature verified in process has the same result as with gpg.
+
+  @return the key or an entry without key if it cannot be used
+  */
+  native_key get_native_key(const string &key_id);
+
+  /*!
+  @brief verifies a detached v4 RSA or EdDSA signature with OpenSSL instead of gpg
+
+  @param result set to the same data verify() returns if the signature is valid
+  @return true if the signature has been verified, false if gpg has to verify it (unsupported format or key, invalid
+          signature, key not known or not fully valid)
+  */
+  bool verify_natively(const string &source, bool is_file, string *sig, json &result);
 
   /*!
   @brief list keys that are matching a pattern in local gpg keyring
@@ -116,7 +169,36 @@ private:
 
 //  gpgme_key_t *list_keys_for_import(const string &fpr, int is_private);
 
+  static mutex interaction_mutex; //!< serializes the import and trust dialogs of concurrent verifications
+
+  /*!
+  @brief returns the modification times and sizes of the files of the local GPG keyring
+
+  The signing key selected for an email address stays valid until one of these changes.
+  */
+  static string keyring_stamp();
+
+  /*!
+  @brief uses the signing key stored in the properties by a previous selection
+
+  The key is used if it was selected for the same email address, the keyring has not changed since and the key can
+  still sign.
+
+  @return true if the cached key is used, false if the key has to be selected
+  */
+  bool select_cached_signing_key();
+
 public:
+  /*!
+  @brief initializes gpgme (version check, locale and check of the gpg engine) once per process
+
+  Nothing is initialized before the first open_pgp object is needed, so runs without signatures never start gpg.
+
+  Called by the constructor. If contexts are created in multiple threads, it has to be called by the main thread
+  before the threads are started.
+  */
+  static void init_engine();
+
   /*!
   @brief constructor with sig mode and properties
 
@@ -142,20 +224,51 @@ public:
 
   virtual ~open_pgp();
 
+  /*!
+  @brief the user is asked if unknown keys are trusted if true (default), such keys are not imported otherwise
+  */
+  void set_interactive(bool _interactive);
+
   /*!
   @brief signing file with best matching local private key and exporting public part of signing key
   This method is trying to find the best key for the signature and signs the file referenced by
   parameter file_to_be_signed with this key. Additionally it tries to export the signing key to a key server.
 
+  The signing key is selected with the first signature and used for all further signatures of this object.
+
   @param file_to_be_signed File to be signed
+  @param export_signing_key if false, the signing key is not exported (e.g. because it is exported once for many
+         signatures)
 
   @return the signature of the file
   */
-  string sign(string file_to_be_signed);
+  string sign(string file_to_be_signed, bool export_signing_key = true);
+
+  /*!
+  @brief signs data in memory like sign() signs a file, e.g. a manifest of many files
+
+  @return the signature of the data
+  */
+  string sign_data(const string &data, bool export_signing_key = true);
+
+  /*!
+  @brief returns the key selected for signing or nullptr if none has been selected yet
+  */
+  gpgme_key_t get_signing_key() const;
+
+  /*!
+  @brief uses the given key for all signatures of this object instead of selecting one
+
+  @param _key key selected by another open_pgp object, a reference is acquired
+  */
+  void set_signing_key(gpgme_key_t _key);
 
   /*!
   @brief verifying signature
 
+  Valid signatures of fully valid keys in the local keyring are verified in process (see verify_natively()), gpg is
+  only called for everything else.
+
   This method tries to find signing key from the signature in the local keyring. If it  cannot be found there it is
   tried to be imported from a public key server. If the key was found the signature will be verified and the result of
   the verification is returned along with the data from the signing key.
@@ -167,6 +280,23 @@ public:
   */
   json verify(const string &file_to_be_verified, string *_signature = nullptr);
 
+  /*!
+  @brief verifies the signature of data in memory like verify() verifies the signature of a file
+  */
+  json verify_data(const string &data, string *_signature);
+
+  /*!
+  @brief imports the keys of many signatures before the signatures are verified
+
+  The keys that are neither in the local keyring nor known to be missing (see key_cache) are looked up on the key
+  server concurrently, up to OPEN_PGP_MAX_KEY_LOOKUPS at a time, instead of one after the other while the signatures
+  are verified. The keys the user trusts (see check_trust()) are imported in one batch and signed locally like in
+  find_and_import_key(). Keys that are not found are cached as missing.
+
+  @param key_ids ids (or fingerprints) of the signing keys
+  */
+  void prefetch_keys(const set<string> &key_ids);
+
   /*!
   @brief list public keys that are matching a pattern in local gpg keyring
 
@@ -193,6 +323,13 @@ public:
   */
   list<map<string, string>> list_private_keys(const string *opt_pattern);
 
+  /*!
+  @brief returns the data of the public key with the given fingerprint like list_public_keys()
+
+  The data is read from the keyring only once per key and day, see key_cache.
+  */
+  list<map<string, string>> cached_public_keys(const string &fpr);
+
   /*!
   @brief Find best possible key for signing
   This method tries to find the best possible key for signing a file for cryptowerks sealing purposes in the local
@@ -200,6 +337,9 @@ public:
 
   It prioritizes keys that have the same email address that was used to register the account with cryptowerk because
   it will be verified by cryptowerk.
+
+  The fingerprint of the selected key is stored in the properties ("signingKey"), so later invocations skip the scan of
+  the keyring as long as it does not change (see select_cached_signing_key()).
   */
   void select_best_signing_key();
 
@@ -231,6 +371,11 @@ public:
   */
   json toJson() const;
 
+  /*!
+  @brief removes the ASCII armor of a signature and replaces line breaks with spaces (format used in the JSON)
+  */
+  static string compact_signature(const string &sig);
+
   /*!
   @brief converting signature from proprietary JSON to open PGP format
 
@@ -270,7 +415,7 @@ public:
 
   @param _key public key to check if it can be trusted
 
-  @return true, if key is trusted, otherwise false
+  @return true, if key is trusted, otherwise false (always if the user cannot be asked)
   */
   bool check_trust(gpgme_key_t &_key);
 
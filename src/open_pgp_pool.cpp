@@ -0,0 +1,100 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "open_pgp_pool.h"
+#include "parallel.h"
+#include <algorithm>
+
+open_pgp_pool::open_pgp_pool(gpgme_sig_mode_t sig_mode, properties *p_properties, const string *email_addr,
+                             size_t files)
+{
+  size_t max_contexts = OPEN_PGP_MAX_CONTEXTS;
+  string *configured  = p_properties->get("gpgContexts");
+  if (configured)
+  {
+    max_contexts = max(1, atoi(configured->c_str()));
+    delete configured;
+  }
+  const size_t size = max<size_t>(1, min<size_t>({files, max_contexts, default_thread_count()}));
+  // gpgme is initialized here in the calling thread, before any context is used by another thread
+  for (size_t i = 0; i < size; i++)
+  {
+    contexts.push_back(new open_pgp(sig_mode, p_properties, email_addr));
+  }
+  idle = contexts;
+}
+
+open_pgp_pool::~open_pgp_pool()
+{
+  for (open_pgp *context:contexts)
+  {
+    delete context;
+  }
+}
+
+const vector<string> &open_pgp_pool::sign(const vector<string> &files)
+{
+  signatures.assign(files.size(), string());
+  if (files.empty())
+  {
+    return signatures;
+  }
+  // the first signature selects the key, which is then shared by all contexts
+  open_pgp *first = contexts.front();
+  signatures[0] = first->sign(files[0], false);
+  for (open_pgp *context:contexts)
+  {
+    if (context != first)
+    {
+      context->set_signing_key(first->get_signing_key());
+    }
+  }
+  // one thread per context, so there is always an idle context for a thread
+  parallel_for(files.size() - 1, [this, &files](size_t i)
+  {
+    open_pgp *context;
+    {
+      lock_guard<mutex> lock(idle_mutex);
+      context = idle.back();
+      idle.pop_back();
+    }
+    try
+    {
+      signatures[i + 1] = context->sign(files[i + 1], false);
+    }
+    catch (...)
+    {
+      lock_guard<mutex> lock(idle_mutex);
+      idle.push_back(context);
+      throw;
+    }
+    lock_guard<mutex> lock(idle_mutex);
+    idle.push_back(context);
+  }, 1, static_cast<unsigned>(contexts.size()));
+  first->export_key(first->get_signing_key()->fpr);
+  return signatures;
+}
+
+json open_pgp_pool::toJson(const vector<string> &names) const
+{
+  json meta_data = contexts.front()->toJson();
+  if (signatures.size() > 1)
+  {
+    meta_data.erase("signature");
+    meta_data["signatures"] = json::array();
+    for (size_t i = 0; i < signatures.size(); i++)
+    {
+      meta_data["signatures"].push_back({{"name",      names[i]},
+                                         {"signature", open_pgp::compact_signature(signatures[i])}});
+    }
+  }
+  return meta_data;
+}
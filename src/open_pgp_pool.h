@@ -0,0 +1,68 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_OPEN_PGP_POOL_H
+#define CEALR_OPEN_PGP_POOL_H
+
+#include "open_pgp.h"
+#include <vector>
+
+// maximum number of gpgme contexts signing at the same time, each one runs its own gpg process talking to gpg-agent
+#define OPEN_PGP_MAX_CONTEXTS 8
+
+/*!
+@brief pool of gpgme contexts signing files concurrently
+
+The signing key is selected once by the first context and shared by all others, the key is exported once after all
+files have been signed. The number of contexts is limited by the number of cores and OPEN_PGP_MAX_CONTEXTS (the
+property "gpgContexts" overrides the latter), so gpg-agent is not flooded with requests.
+*/
+class open_pgp_pool
+{
+private:
+  vector<open_pgp *> contexts;
+  vector<open_pgp *> idle;        //!< contexts not used by a thread right now
+  mutex              idle_mutex;
+  vector<string>     signatures;  //!< signature for each file passed to sign()
+
+public:
+  /*!
+  @brief constructor creating the contexts in the calling thread
+
+  @param files number of files to be signed, no more contexts than files are created
+  */
+  open_pgp_pool(gpgme_sig_mode_t sig_mode, properties *p_properties, const string *email_addr, size_t files);
+
+  ~open_pgp_pool();
+
+  open_pgp_pool(const open_pgp_pool &) = delete;
+
+  open_pgp_pool &operator=(const open_pgp_pool &) = delete;
+
+  /*!
+  @brief signs the files on all contexts
+
+  @return signature for each file, in the order of files
+  @throw pgp_exception if a file cannot be signed (the first error is thrown after all running signatures are done)
+  */
+  const vector<string> &sign(const vector<string> &files);
+
+  /*!
+  @brief returns the metadata to be sealed with the signed files
+
+  One signature is stored like open_pgp::toJson() does, several ones as list "signatures" with the name of each file.
+
+  @param names name of each signed file as it is registered
+  */
+  json toJson(const vector<string> &names) const;
+};
+
+#endif //CEALR_OPEN_PGP_POOL_H
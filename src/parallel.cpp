@@ -0,0 +1,87 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned default_thread_count()
+{
+  unsigned cores = thread::hardware_concurrency();
+  return cores ? cores : 1;
+}
+
+void parallel_for(size_t count, const function<void(size_t)> &task, size_t chunk_size, unsigned max_threads)
+{
+  if (!chunk_size)
+  {
+    chunk_size = 1;
+  }
+  const size_t chunks = (count + chunk_size - 1) / chunk_size;
+  const unsigned threads = static_cast<unsigned>(min<size_t>(chunks, max_threads ? max_threads : default_thread_count()));
+  if (threads <= 1)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  atomic<size_t> next_chunk(0);
+  atomic<bool> failed(false);
+  exception_ptr error;
+  mutex error_mutex;
+
+  auto worker = [&]()
+  {
+    for (size_t chunk; !failed && (chunk = next_chunk++) < chunks;)
+    {
+      const size_t end = min(count, (chunk + 1) * chunk_size);
+      try
+      {
+        for (size_t i = chunk * chunk_size; i < end; i++)
+        {
+          task(i);
+        }
+      }
+      catch (...)
+      {
+        lock_guard<mutex> lock(error_mutex);
+        if (!error)
+        {
+          error = current_exception();
+        }
+        failed = true;
+      }
+    }
+  };
+
+  vector<thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned t = 1; t < threads; t++)
+  {
+    pool.emplace_back(worker);
+  }
+  worker();
+  for (thread &t:pool)
+  {
+    t.join();
+  }
+  if (error)
+  {
+    rethrow_exception(error);
+  }
+}
@@ -0,0 +1,44 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_PARALLEL_H
+#define CEALR_PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+using namespace std;
+
+/*!
+@brief returns the number of worker threads to be used by default
+
+@return number of available cores, at least 1
+*/
+unsigned default_thread_count();
+
+/*!
+@brief runs a task for all indexes from 0 to count-1 on multiple threads
+
+Work is handed out in chunks of chunk_size indexes from a shared counter, so threads that are done with their chunk
+pick up the remaining work of busy ones. The calling thread takes part in the work. If there is only one chunk, the
+task is run in the calling thread only.
+
+The first exception thrown by a task is rethrown in the calling thread after all threads have finished, remaining
+chunks are skipped in that case.
+
+@param count number of indexes
+@param task called with each index exactly once
+@param chunk_size number of consecutive indexes handed out at once
+@param max_threads maximum number of threads, 0 for default_thread_count()
+*/
+void parallel_for(size_t count, const function<void(size_t)> &task, size_t chunk_size = 1, unsigned max_threads = 0);
+
+#endif //CEALR_PARALLEL_H
@@ -0,0 +1,616 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "pgp_verify.h"
+#include "base64.h"
+#include "hex.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <openssl/bn.h>
+#include <openssl/rsa.h>
+#include <openssl/sha.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#include <openssl/core_names.h>
+#include <openssl/param_build.h>
+#endif
+
+// OID of the curve Ed25519 in EdDSA keys
+static const unsigned char ED25519_OID[] = {0x2B, 0x06, 0x01, 0x04, 0x01, 0xDA, 0x47, 0x0F, 0x01};
+
+// key ids and fingerprints are written in upper case like gpg does
+static string to_upper_hex(const unsigned char *data, size_t len)
+{
+  string ret(2 * len, '\0');
+  hex_codec::encode(data, len, &ret[0]);
+  transform(ret.begin(), ret.end(), ret.begin(), ::toupper);
+  return ret;
+}
+
+// packet of an OpenPGP message
+struct pgp_packet
+{
+  int                  tag;
+  const unsigned char *body;
+  size_t               len;
+};
+
+// returns the base 64 data of the first ASCII armored block in text, empty if there is none
+static vector<char> *dearmor(const string &text)
+{
+  size_t begin = text.find("-----BEGIN PGP ");
+  begin = begin == string::npos ? string::npos : text.find('\n', begin);
+  const size_t end = begin == string::npos ? string::npos : text.find("-----END PGP ", begin);
+  if (end == string::npos)
+  {
+    return nullptr;
+  }
+  // armor headers ("Version: ...") are separated from the data by an empty line
+  size_t data = begin + 1;
+  const size_t empty_line = text.find("\n\n", begin);
+  if (empty_line != string::npos && empty_line < end && text.find(':', data) < empty_line)
+  {
+    data = empty_line + 2;
+  }
+  string base64_data;
+  for (size_t line = data; line < end;)
+  {
+    size_t next = min(text.find('\n', line), end);
+    // the checksum line starts with '=', which cannot start a line of data
+    if (text[line] == '=')
+    {
+      break;
+    }
+    base64_data.append(text, line, next - line);
+    line = next + 1;
+  }
+  try
+  {
+    return base64::decode(base64_data);
+  }
+  catch (base64_exception &)
+  {
+    return nullptr;
+  }
+}
+
+// splits an OpenPGP message into packets, returns false if it is malformed or uses partial body lengths
+static bool read_packets(const unsigned char *data, size_t len, vector<pgp_packet> &packets)
+{
+  for (size_t pos = 0; pos < len;)
+  {
+    const unsigned char header = data[pos++];
+    if (!(header & 0x80))
+    {
+      return false;
+    }
+    int tag;
+    size_t body_len;
+    if (header & 0x40)
+    {
+      // new format
+      tag = header & 0x3f;
+      if (pos >= len)
+      {
+        return false;
+      }
+      const unsigned char first = data[pos++];
+      if (first < 192)
+      {
+        body_len = first;
+      }
+      else if (first < 224)
+      {
+        if (pos >= len)
+        {
+          return false;
+        }
+        body_len = ((first - 192) << 8) + data[pos++] + 192;
+      }
+      else if (first == 255)
+      {
+        if (pos + 4 > len)
+        {
+          return false;
+        }
+        body_len = (size_t(data[pos]) << 24) | (size_t(data[pos + 1]) << 16) | (size_t(data[pos + 2]) << 8) |
+                   data[pos + 3];
+        pos += 4;
+      }
+      else
+      {
+        return false;
+      }
+    }
+    else
+    {
+      // old format
+      tag = (header >> 2) & 0x0f;
+      const int length_type = header & 3;
+      if (length_type == 3)
+      {
+        body_len = len - pos;
+      }
+      else
+      {
+        const size_t bytes = size_t(1) << length_type;
+        if (pos + bytes > len)
+        {
+          return false;
+        }
+        body_len = 0;
+        for (size_t i = 0; i < bytes; i++)
+        {
+          body_len = (body_len << 8) | data[pos++];
+        }
+      }
+    }
+    if (body_len > len - pos)
+    {
+      return false;
+    }
+    packets.push_back({tag, data + pos, body_len});
+    pos += body_len;
+  }
+  return true;
+}
+
+// reads a multiprecision integer, returns false if it exceeds the packet
+static bool read_mpi(const unsigned char *data, size_t len, size_t &pos, vector<unsigned char> &mpi)
+{
+  if (pos + 2 > len)
+  {
+    return false;
+  }
+  const size_t bytes = ((size_t(data[pos]) << 8 | data[pos + 1]) + 7) / 8;
+  pos += 2;
+  if (pos + bytes > len)
+  {
+    return false;
+  }
+  mpi.assign(data + pos, data + pos + bytes);
+  pos += bytes;
+  return true;
+}
+
+// returns the value left padded with zeros to size bytes
+static vector<unsigned char> left_pad(const vector<unsigned char> &value, size_t size)
+{
+  vector<unsigned char> ret(size > value.size() ? size - value.size() : 0, 0);
+  ret.insert(ret.end(), value.begin(), value.end());
+  return ret;
+}
+
+static const EVP_MD *hash_md(int hash_algo)
+{
+  switch (hash_algo)
+  {
+    case 2:
+      return EVP_sha1();
+    case 8:
+      return EVP_sha256();
+    case 9:
+      return EVP_sha384();
+    case 10:
+      return EVP_sha512();
+    case 11:
+      return EVP_sha224();
+    default:
+      return nullptr;
+  }
+}
+
+// four byte time in seconds since the epoch
+static long read_time(const unsigned char *data)
+{
+  return (long(data[0]) << 24) | (long(data[1]) << 16) | (long(data[2]) << 8) | data[3];
+}
+
+// sets issuer from an issuer (16) or issuer fingerprint (33) subpacket
+static void read_issuer(int sub_type, const unsigned char *sub, size_t sub_data_len, string &issuer)
+{
+  if (sub_type == 16 && sub_data_len == 8)
+  {
+    issuer = to_upper_hex(sub, 8);
+  }
+  else if (sub_type == 33 && sub_data_len == 21 && sub[0] == 4)
+  {
+    // the key id is the end of the v4 fingerprint
+    issuer = to_upper_hex(sub + 13, 8);
+  }
+}
+
+/*
+ * passes the subpackets of the hashed and the unhashed area of a v4 signature packet to visit(type, critical,
+ * in_hashed, data, data_len), sets end to the offset after the unhashed area
+ *
+ * returns false if the areas are malformed or visit returns false
+ */
+static bool read_subpackets(const unsigned char *body, size_t len, size_t &end,
+                            const function<bool(int, bool, bool, const unsigned char *, size_t)> &visit)
+{
+  if (len < 6)
+  {
+    return false;
+  }
+  const size_t hashed_len = size_t(body[4]) << 8 | body[5];
+  if (6 + hashed_len + 2 > len)
+  {
+    return false;
+  }
+  const size_t unhashed_len = size_t(body[6 + hashed_len]) << 8 | body[7 + hashed_len];
+  end = 8 + hashed_len + unhashed_len;
+  if (end > len)
+  {
+    return false;
+  }
+  for (size_t pos = 6; pos < end;)
+  {
+    if (pos == 6 + hashed_len)
+    {
+      pos += 2;
+      continue;
+    }
+    const bool in_hashed = pos < 6 + hashed_len;
+    const size_t area_end = in_hashed ? 6 + hashed_len : end;
+    size_t sub_len = body[pos++];
+    if (sub_len >= 192 && sub_len < 255 && pos < area_end)
+    {
+      sub_len = ((sub_len - 192) << 8) + body[pos++] + 192;
+    }
+    else if (sub_len == 255 && pos + 4 <= area_end)
+    {
+      sub_len = (size_t(body[pos]) << 24) | (size_t(body[pos + 1]) << 16) | (size_t(body[pos + 2]) << 8) |
+                body[pos + 3];
+      pos += 4;
+    }
+    if (!sub_len || sub_len > area_end - pos)
+    {
+      return false;
+    }
+    if (!visit(body[pos] & 0x7f, (body[pos] & 0x80) != 0, in_hashed, body + pos + 1, sub_len - 1))
+    {
+      return false;
+    }
+    pos += sub_len;
+  }
+  return true;
+}
+
+pgp_signature *pgp_signature::parse(const string &armored)
+{
+  vector<char> *raw = dearmor(armored);
+  if (!raw)
+  {
+    return nullptr;
+  }
+  vector<pgp_packet> packets;
+  const auto *data = reinterpret_cast<const unsigned char *>(raw->data());
+  const unsigned char *body = nullptr;
+  size_t len = 0;
+  if (read_packets(data, raw->size(), packets) && packets.size() == 1 && packets[0].tag == 2)
+  {
+    body = packets[0].body;
+    len  = packets[0].len;
+  }
+  // version 4 signature of a binary or text document with a supported algorithm
+  if (!body || len < 6 || body[0] != 4 || body[1] > 1 || !hash_md(body[3]) ||
+      (body[2] != PGP_ALGO_RSA && body[2] != PGP_ALGO_RSA_SIGN && body[2] != PGP_ALGO_EDDSA))
+  {
+    delete raw;
+    return nullptr;
+  }
+  auto sig = new pgp_signature();
+  sig->type        = body[1];
+  sig->pubkey_algo = body[2];
+  sig->hash_algo   = body[3];
+  sig->created     = -1;
+  const size_t hashed_len = size_t(body[4]) << 8 | body[5];
+  size_t end = 0;
+  bool supported = 6 + hashed_len + 2 <= len;
+  if (supported)
+  {
+    sig->hashed.assign(body, body + 6 + hashed_len);
+    supported = read_subpackets(body, len, end, [sig](int sub_type, bool critical, bool in_hashed,
+                                                      const unsigned char *sub, size_t sub_data_len)
+    {
+      if (sub_type == 2 && sub_data_len == 4 && in_hashed)
+      {
+        sig->created = read_time(sub);
+      }
+      else if (sub_type == 16 || sub_type == 33)
+      {
+        read_issuer(sub_type, sub, sub_data_len, sig->issuer);
+      }
+      else if (sub_type == 3 || (critical && in_hashed))
+      {
+        // signature expiration and critical subpackets that are not understood are left to gpg
+        return false;
+      }
+      return true;
+    }) && end + 2 <= len;
+    if (supported)
+    {
+      sig->left16[0] = body[end];
+      sig->left16[1] = body[end + 1];
+      size_t pos = end + 2;
+      const int count = sig->pubkey_algo == PGP_ALGO_EDDSA ? 2 : 1;
+      sig->mpis.resize(count);
+      for (int i = 0; supported && i < count; i++)
+      {
+        supported = read_mpi(body, len, pos, sig->mpis[i]);
+      }
+      supported = supported && pos == len && sig->created >= 0 && !sig->issuer.empty();
+    }
+  }
+  delete raw;
+  if (!supported)
+  {
+    delete sig;
+    return nullptr;
+  }
+  return sig;
+}
+
+pgp_public_key::pgp_public_key(EVP_PKEY *_pkey, int _algo, const unsigned char *packet, size_t len)
+{
+  pkey = _pkey;
+  algo = _algo;
+  // v4 fingerprint: SHA-1 over 0x99, the two byte length and the body of the key packet
+  unsigned char prefix[] = {0x99, static_cast<unsigned char>(len >> 8), static_cast<unsigned char>(len)};
+  unsigned char fpr[SHA_DIGEST_LENGTH];
+  EVP_MD_CTX *sha = EVP_MD_CTX_new();
+  EVP_DigestInit_ex(sha, EVP_sha1(), nullptr);
+  EVP_DigestUpdate(sha, prefix, sizeof(prefix));
+  EVP_DigestUpdate(sha, packet, len);
+  EVP_DigestFinal_ex(sha, fpr, nullptr);
+  EVP_MD_CTX_free(sha);
+  fingerprint = to_upper_hex(fpr, SHA_DIGEST_LENGTH);
+  key_id      = fingerprint.substr(2 * SHA_DIGEST_LENGTH - 16);
+  created     = read_time(packet + 1);
+  can_sign    = false;
+}
+
+pgp_public_key::~pgp_public_key()
+{
+  EVP_PKEY_free(pkey);
+}
+
+// creates the OpenSSL key of a v4 key packet, nullptr if the algorithm is not supported
+static EVP_PKEY *read_key(const unsigned char *body, size_t len, int &algo)
+{
+  if (len < 6 || body[0] != 4)
+  {
+    return nullptr;
+  }
+  algo = body[5];
+  size_t pos = 6;
+  EVP_PKEY *pkey = nullptr;
+  if (algo == PGP_ALGO_RSA || algo == PGP_ALGO_RSA_SIGN)
+  {
+    vector<unsigned char> n, e;
+    if (!read_mpi(body, len, pos, n) || !read_mpi(body, len, pos, e))
+    {
+      return nullptr;
+    }
+    BIGNUM *bn_n = BN_bin2bn(n.data(), static_cast<int>(n.size()), nullptr);
+    BIGNUM *bn_e = BN_bin2bn(e.data(), static_cast<int>(e.size()), nullptr);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM_BLD *bld = OSSL_PARAM_BLD_new();
+    OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_RSA_N, bn_n);
+    OSSL_PARAM_BLD_push_BN(bld, OSSL_PKEY_PARAM_RSA_E, bn_e);
+    OSSL_PARAM *params = OSSL_PARAM_BLD_to_param(bld);
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(nullptr, "RSA", nullptr);
+    if (!params || !ctx || EVP_PKEY_fromdata_init(ctx) <= 0 ||
+        EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) <= 0)
+    {
+      pkey = nullptr;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    OSSL_PARAM_free(params);
+    OSSL_PARAM_BLD_free(bld);
+    BN_free(bn_n);
+    BN_free(bn_e);
+#else
+    RSA *rsa = RSA_new();
+    RSA_set0_key(rsa, bn_n, bn_e, nullptr);
+    pkey = EVP_PKEY_new();
+    EVP_PKEY_assign_RSA(pkey, rsa);
+#endif
+  }
+  else if (algo == PGP_ALGO_EDDSA)
+  {
+    // curve OID, then the point with prefix 0x40 (native encoding)
+    vector<unsigned char> point;
+    if (pos >= len || body[pos] != sizeof(ED25519_OID) || pos + 1 + sizeof(ED25519_OID) > len ||
+        memcmp(body + pos + 1, ED25519_OID, sizeof(ED25519_OID)) != 0)
+    {
+      return nullptr;
+    }
+    pos += 1 + sizeof(ED25519_OID);
+    if (!read_mpi(body, len, pos, point) || point.size() != 33 || point[0] != 0x40)
+    {
+      return nullptr;
+    }
+    pkey = EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, point.data() + 1, 32);
+  }
+  return pkey;
+}
+
+/*
+ * reads the creation time and the key flags of a v4 self-signature issued by primary_key_id, returns false if the
+ * packet is no such signature or has no key flags in its hashed area
+ */
+static bool read_self_signature(const pgp_packet &packet, const string &primary_key_id, long &created, int &flags)
+{
+  const unsigned char *body = packet.body;
+  // certifications of a user id (0x10 - 0x13), subkey binding (0x18) and direct key (0x1f) signatures
+  if (packet.len < 6 || body[0] != 4 || !((body[1] >= 0x10 && body[1] <= 0x13) || body[1] == 0x18 || body[1] == 0x1f))
+  {
+    return false;
+  }
+  string issuer;
+  size_t end;
+  created = -1;
+  flags   = -1;
+  // the key flags are only bound to the key in the hashed area
+  return read_subpackets(body, packet.len, end, [&](int sub_type, bool, bool in_hashed, const unsigned char *sub,
+                                                    size_t sub_data_len)
+  {
+    if (sub_type == 2 && sub_data_len == 4 && in_hashed)
+    {
+      created = read_time(sub);
+    }
+    else if (sub_type == 27 && sub_data_len >= 1 && in_hashed)
+    {
+      flags = sub[0];
+    }
+    else if (sub_type == 16 || sub_type == 33)
+    {
+      read_issuer(sub_type, sub, sub_data_len, issuer);
+    }
+    return true;
+  }) && created >= 0 && flags >= 0 && issuer == primary_key_id;
+}
+
+vector<pgp_public_key *> pgp_public_key::parse_armored(const string &armored)
+{
+  vector<pgp_public_key *> keys;
+  vector<char> *raw = dearmor(armored);
+  if (!raw)
+  {
+    return keys;
+  }
+  vector<pgp_packet> packets;
+  if (read_packets(reinterpret_cast<const unsigned char *>(raw->data()), raw->size(), packets))
+  {
+    // the signatures following a key packet belong to that key, the newest self-signature sets its key flags
+    string primary_key_id;
+    pgp_public_key *current = nullptr;
+    long newest = -1;
+    for (const pgp_packet &packet:packets)
+    {
+      // public key and public subkey
+      if (packet.tag == 6 || packet.tag == 14)
+      {
+        int algo;
+        EVP_PKEY *pkey = read_key(packet.body, packet.len, algo);
+        current = pkey ? new pgp_public_key(pkey, algo, packet.body, packet.len) : nullptr;
+        newest  = -1;
+        if (current)
+        {
+          current->can_sign = packet.tag == 6;
+          keys.push_back(current);
+        }
+        if (packet.tag == 6)
+        {
+          primary_key_id = current ? current->key_id : string();
+        }
+      }
+      else if (packet.tag == 2 && current)
+      {
+        long created;
+        int flags;
+        if (read_self_signature(packet, primary_key_id, created, flags) && created >= newest)
+        {
+          current->can_sign = (flags & PGP_KEY_FLAG_SIGN) != 0;
+          newest            = created;
+        }
+      }
+    }
+  }
+  delete raw;
+  return keys;
+}
+
+bool pgp_public_key::verify(const pgp_signature &signature, const string &file) const
+{
+  ifstream ifs(file.c_str(), ifstream::binary);
+  return ifs.is_open() && verify(signature, ifs);
+}
+
+bool pgp_public_key::verify(const pgp_signature &signature, istream &ifs) const
+{
+  const bool rsa = algo == PGP_ALGO_RSA || algo == PGP_ALGO_RSA_SIGN;
+  if (signature.issuer != key_id || rsa != (signature.pubkey_algo != PGP_ALGO_EDDSA) || !can_sign ||
+      signature.created < created)
+  {
+    return false;
+  }
+  const EVP_MD *md = hash_md(signature.hash_algo);
+  EVP_MD_CTX *md_ctx = EVP_MD_CTX_new();
+  EVP_DigestInit_ex(md_ctx, md, nullptr);
+  vector<char> buffer(PGP_HASH_BUFFER_SIZE);
+  string canonical;
+  char last = 0;
+  while (ifs)
+  {
+    ifs.read(buffer.data(), buffer.size());
+    const size_t got = static_cast<size_t>(ifs.gcount());
+    if (signature.type == 0x00)
+    {
+      EVP_DigestUpdate(md_ctx, buffer.data(), got);
+      continue;
+    }
+    // canonical text: line feeds are hashed as CR LF, like gpg does when signing in text mode
+    canonical.clear();
+    for (size_t i = 0; i < got; i++)
+    {
+      const char c = buffer[i];
+      if (c == '\n' && last != '\r')
+      {
+        canonical.push_back('\r');
+      }
+      canonical.push_back(c);
+      last = c;
+    }
+    EVP_DigestUpdate(md_ctx, canonical.data(), canonical.size());
+  }
+  // hashed part of the signature packet and trailer
+  const size_t hashed_len = signature.hashed.size();
+  const unsigned char trailer[] = {4, 0xff, static_cast<unsigned char>(hashed_len >> 24),
+                                   static_cast<unsigned char>(hashed_len >> 16),
+                                   static_cast<unsigned char>(hashed_len >> 8), static_cast<unsigned char>(hashed_len)};
+  EVP_DigestUpdate(md_ctx, signature.hashed.data(), hashed_len);
+  EVP_DigestUpdate(md_ctx, trailer, sizeof(trailer));
+  unsigned char digest[EVP_MAX_MD_SIZE];
+  unsigned int digest_len = 0;
+  EVP_DigestFinal_ex(md_ctx, digest, &digest_len);
+  EVP_MD_CTX_free(md_ctx);
+  if (digest[0] != signature.left16[0] || digest[1] != signature.left16[1])
+  {
+    return false;
+  }
+  bool verified;
+  if (rsa)
+  {
+    const vector<unsigned char> sig = left_pad(signature.mpis[0], static_cast<size_t>(EVP_PKEY_size(pkey)));
+    EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new(pkey, nullptr);
+    verified = ctx && EVP_PKEY_verify_init(ctx) > 0 && EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) > 0 &&
+               EVP_PKEY_CTX_set_signature_md(ctx, md) > 0 &&
+               EVP_PKEY_verify(ctx, sig.data(), sig.size(), digest, digest_len) == 1;
+    EVP_PKEY_CTX_free(ctx);
+  }
+  else
+  {
+    // EdDSA signs the digest, the signature is R || S
+    vector<unsigned char> sig = left_pad(signature.mpis[0], 32);
+    const vector<unsigned char> s = left_pad(signature.mpis[1], 32);
+    sig.insert(sig.end(), s.begin(), s.end());
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    verified = sig.size() == 64 && EVP_DigestVerifyInit(ctx, nullptr, nullptr, nullptr, pkey) > 0 &&
+               EVP_DigestVerify(ctx, sig.data(), sig.size(), digest, digest_len) == 1;
+    EVP_MD_CTX_free(ctx);
+  }
+  return verified;
+}
@@ -0,0 +1,104 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_PGP_VERIFY_H
+#define CEALR_PGP_VERIFY_H
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <openssl/evp.h>
+
+using namespace std;
+
+// OpenPGP public key algorithms (RFC 4880 9.1, EdDSA from RFC 4880bis)
+#define PGP_ALGO_RSA          1
+#define PGP_ALGO_RSA_SIGN     3
+#define PGP_ALGO_EDDSA        22
+// key flag of keys that may sign data (RFC 4880 5.2.3.21)
+#define PGP_KEY_FLAG_SIGN     0x02
+// size of the blocks a file is hashed in
+#define PGP_HASH_BUFFER_SIZE  0x10000
+
+/*!
+@brief version 4 signature packet of a detached OpenPGP signature
+
+Only what is needed to verify the signature in process is kept, see pgp_public_key::verify().
+*/
+class pgp_signature
+{
+public:
+  int                   type;          //!< 0x00 binary document, 0x01 canonical text document
+  int                   pubkey_algo;
+  int                   hash_algo;
+  long                  created;       //!< signature creation time, seconds since the epoch
+  string                issuer;        //!< key id of the signing key, 16 upper case hexadecimal digits
+  vector<unsigned char> hashed;        //!< version, type, algorithms and hashed subpackets, hashed after the data
+  unsigned char         left16[2];     //!< first two bytes of the hash
+  vector<vector<unsigned char>> mpis;  //!< RSA: m^d mod n, EdDSA: R and S
+
+  /*!
+  @brief parses an ASCII armored signature
+
+  @return the signature or nullptr if it is not a version 4 signature of a document with a supported algorithm or uses
+          features the in-process verification does not handle (e.g. critical unknown subpackets, expiration)
+  */
+  static pgp_signature *parse(const string &armored);
+};
+
+/*!
+@brief version 4 RSA or Ed25519 public (sub)key held as OpenSSL key
+*/
+class pgp_public_key
+{
+private:
+  EVP_PKEY *pkey;
+  int       algo;
+
+  pgp_public_key(EVP_PKEY *_pkey, int _algo, const unsigned char *packet, size_t len);
+
+public:
+  string key_id;       //!< 16 upper case hexadecimal digits
+  string fingerprint;  //!< 40 upper case hexadecimal digits
+  long   created;      //!< key creation time, seconds since the epoch
+  bool   can_sign;     //!< key flags of the newest self-signature allow signing data
+
+  ~pgp_public_key();
+
+  pgp_public_key(const pgp_public_key &) = delete;
+
+  pgp_public_key &operator=(const pgp_public_key &) = delete;
+
+  /*!
+  @brief parses the primary key and the subkeys of an ASCII armored public key block (e.g. from gpg --export --armor)
+
+  The key flags are taken from the self-signatures without verifying them, so the block must come from a keyring gpg
+  has checked. A primary key without key flags is taken as signing key, a subkey without them is not.
+
+  @return keys with supported algorithms, to be deleted by the caller
+  */
+  static vector<pgp_public_key *> parse_armored(const string &armored);
+
+  /*!
+  @brief verifies a detached signature of a file with this key
+
+  @return true if the signature is valid, false if it is not, the file cannot be read, the key may not sign data or
+          the signature claims to be older than the key (left to gpg then)
+  */
+  bool verify(const pgp_signature &signature, const string &file) const;
+
+  /*!
+  @brief verifies a detached signature of the data read from a stream with this key
+  */
+  bool verify(const pgp_signature &signature, istream &ifs) const;
+};
+
+#endif //CEALR_PGP_VERIFY_H
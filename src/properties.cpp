@@ -22,14 +22,16 @@ const char *file_exception::what()
 properties::properties(const string &fileName)
 {
   set_file(fileName);
-  read_from_file();
+  saved     = true;
+  loaded    = false;
+  read_only = false;
 }
 
 properties::properties() : properties(DEFAULT_PROPERTIES) {};
 
 properties::~properties()
 {
-  if (!saved)
+  if (loaded && !saved && !read_only)
   {
     save();
   }
@@ -55,8 +57,20 @@ const string properties::get_full_file_name(const string &file_name)
   return full_name;
 }
 
+void properties::load() const
+{
+  call_once(load_once, [this]()
+  {
+    if (!loaded)
+    {
+      const_cast<properties *>(this)->read_from_file();
+    }
+  });
+}
+
 void properties::read_from_file()
 {
+  loaded = true;
   ifstream ifs(file.c_str());
   if (ifs.is_open())
   {
@@ -83,8 +97,19 @@ void properties::read_from_file()
   }
 }
 
+void properties::set_read_only()
+{
+  read_only = true;
+}
+
 void properties::save()
 {
+  if (read_only)
+  {
+    return;
+  }
+  // entries that have not been read would be lost
+  load();
   string *pth = super_path(file);
   if (pth != nullptr)
   {
@@ -114,6 +139,8 @@ void properties::save()
 
 bool properties::operator==(const properties &properties) const
 {
+  load();
+  properties.load();
   return static_cast<const map<string, string> &>(*this) == static_cast<const map<string, string> &>(properties) &&
          file == properties.file;
 }
@@ -130,6 +157,7 @@ const string &properties::getFile() const
 
 ostream &operator<<(ostream &os, const properties &properties)
 {
+  properties.load();
   os << "Properties file: " << properties.file << endl;
   for (const auto &p : properties)
   {
@@ -140,6 +168,7 @@ ostream &operator<<(ostream &os, const properties &properties)
 
 string *properties::get(const string &key, string *default_val, const bool cloneValue)
 {
+  load();
   if (count(key))
   {
     return new string((*this)[key]);
@@ -159,12 +188,14 @@ string *properties::get(const string &key, string *default_val, const bool clone
 
 void properties::put(const string &key, const string &val)
 {
+  load();
   (*this)[key] = val;
   saved = false;
 }
 
 void properties::remove(const string &key)
 {
+  load();
   erase(key);
   saved = false;
 }
@@ -19,6 +19,7 @@ static const char *const DEFAULT_PROPERTIES = "~/.cealr/config.properties";
 #include <string>
 #include <exception>
 #include <map>
+#include <mutex>
 
 using namespace std;
 
@@ -43,9 +44,22 @@ class properties : private map<string, string>
 private:
   string file;  //!< physical file containing properties in form <key> = <value>
   bool saved;   //!< is true when properties have changed, otherwise false
+  bool loaded;  //!< is true when the file has been read
+  bool read_only;  //!< is true when changes are only kept in memory (see set_read_only())
+  mutable once_flag load_once;  //!< the first access may come from several threads (e.g. concurrent verifications)
+
+  /*!
+  @brief reads the file on the first access, so runs that do not need the properties never open it
+
+  Thread-safe, concurrent readers wait until the file has been read.
+  */
+  void load() const;
 public:
   /*!
   @brief constructor with file name
+
+  The file is read when the properties are accessed for the first time.
+
   @param file_name is the name of the property file
   */
   explicit properties(const string &);
@@ -83,7 +97,8 @@ public:
   /*!
   @brief dumps properties into output stream
 
-  This override serves the purpose of getting output for debugging.
+  This override serves the purpose of getting output for debugging. The output contains the credentials stored in
+  the properties, so it must not be written to logs.
   */
   friend ostream &operator<<(ostream &, const properties &);
 
@@ -128,6 +143,14 @@ public:
   */
   void save();
 
+  /*!
+  @brief changes are kept in memory and the file is never written, neither by save() nor by the destructor
+
+  Used for embedding cealr (see libcealr.h), where each call has its own properties and several calls may run at the
+  same time.
+  */
+  void set_read_only();
+
   /*!
   @brief getter for saved
   @return true if the properties need to be saved, otherwise false (have been changed since reading/last save)
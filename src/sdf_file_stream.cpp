@@ -0,0 +1,198 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#include "sdf_file_stream.h"
+
+#ifndef WIN32
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int open_for_reading(const string &file_name)
+{
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw io_error(__FILE__, __LINE__, "Cannot open \"" + file_name + "\": " + strerror(errno));
+  }
+  return fd;
+}
+
+fd_istream::fd_istream(int _fd, size_t _buffer_size)
+{
+  fd          = _fd;
+  owns_fd     = false;
+  at_eof      = false;
+  buffer_size = max<size_t>(_buffer_size, 8);
+  input_left  = -1;
+  struct stat st{};
+  const off_t offset = lseek(fd, 0, SEEK_CUR);
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && offset >= 0)
+  {
+    input_left = max<off_t>(st.st_size - offset, 0);
+  }
+  buffer.resize(buffer_size);
+  setg(&buffer[0], &buffer[0], &buffer[0]);
+}
+
+fd_istream::fd_istream(const string &file_name, size_t _buffer_size) : fd_istream(open_for_reading(file_name),
+                                                                                  _buffer_size)
+{
+  owns_fd = true;
+}
+
+fd_istream::~fd_istream()
+{
+  if (owns_fd)
+  {
+    close(fd);
+  }
+}
+
+bool fd_istream::fill(size_t min_bytes)
+{
+  size_t available = remaining();
+  if (available >= min_bytes)
+  {
+    return true;
+  }
+  if (at_eof || min_bytes > SDF_MAX_FIELD_SIZE || !may_contain(min_bytes))
+  {
+    return false;
+  }
+  consumed += gptr() - eback();
+  const size_t wanted = max(buffer_size, min_bytes);
+  if (buffer.size() != wanted)
+  {
+    // grown for a large field, or back to the block size after one
+    vector<char> resized(wanted);
+    memcpy(&resized[0], gptr(), available);
+    buffer.swap(resized);
+  }
+  else
+  {
+    // move the unread bytes to the front of the buffer
+    memmove(&buffer[0], gptr(), available);
+  }
+  while (available < min_bytes && !at_eof)
+  {
+    ssize_t got = read(fd, &buffer[available], buffer.size() - available);
+    if (got < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw io_error(__FILE__, __LINE__, string("Cannot read input: ") + strerror(errno));
+    }
+    at_eof     = got == 0;
+    available += got;
+  }
+  setg(&buffer[0], &buffer[0], &buffer[0] + available);
+  return available >= min_bytes;
+}
+
+bool fd_istream::may_contain(size_t length)
+{
+  return input_left < 0 || remaining() >= length || static_cast<off_t>(length) <= input_left - position();
+}
+
+mmap_istream::mmap_istream(int _fd, off_t offset, size_t length, size_t _window_size)
+{
+  fd            = _fd;
+  owns_fd       = false;
+  region_start  = offset;
+  region_end    = offset + static_cast<off_t>(length);
+  window_start  = offset;
+  window        = nullptr;
+  window_length = 0;
+  window_size   = max<size_t>(_window_size, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+  setg(nullptr, nullptr, nullptr);
+  consumed      = 0;
+}
+
+mmap_istream::mmap_istream(const string &file_name, size_t _window_size) : mmap_istream(open_for_reading(file_name), 0, 0,
+                                                                                         _window_size)
+{
+  owns_fd = true;
+  struct stat st{};
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    throw io_error(__FILE__, __LINE__, "Cannot stat \"" + file_name + "\": " + strerror(errno));
+  }
+  region_end = st.st_size;
+}
+
+mmap_istream::~mmap_istream()
+{
+  unmap();
+  if (owns_fd)
+  {
+    close(fd);
+  }
+}
+
+void mmap_istream::unmap()
+{
+  if (window)
+  {
+    munmap(window, window_length);
+    window = nullptr;
+  }
+}
+
+/*!
+@brief returns the file offset of the next byte to be read
+*/
+off_t mmap_istream::next_offset()
+{
+  return window ? window_start + (gptr() - window) : region_start + consumed;
+}
+
+bool mmap_istream::may_contain(size_t length)
+{
+  return static_cast<off_t>(length) <= region_end - next_offset();
+}
+
+bool mmap_istream::fill(size_t min_bytes)
+{
+  const off_t next = next_offset();
+  if (!may_contain(min_bytes) || min_bytes > SDF_MAX_FIELD_SIZE)
+  {
+    return false;
+  }
+  const off_t page_size  = sysconf(_SC_PAGESIZE);
+  const off_t map_start  = next - next % page_size;
+  const size_t length    = static_cast<size_t>(min<off_t>(region_end - map_start,
+                                                           static_cast<off_t>(max(window_size, min_bytes)) +
+                                                           (next - map_start)));
+  void *mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, map_start);
+  if (mapped == MAP_FAILED)
+  {
+    throw io_error(__FILE__, __LINE__, string("Cannot map input: ") + strerror(errno));
+  }
+  madvise(mapped, length, MADV_SEQUENTIAL);
+  unmap();
+  window        = static_cast<char *>(mapped);
+  window_start  = map_start;
+  window_length = length;
+  char *first   = window + (next - map_start);
+  setg(first, first, window + length);
+  consumed      = next - region_start;
+  return true;
+}
+
+#endif //WIN32
@@ -0,0 +1,119 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+#ifndef CEALR_SDF_FILE_STREAM_H
+#define CEALR_SDF_FILE_STREAM_H
+
+#ifndef WIN32
+
+#include <sys/types.h>
+#include "serialized_data_format.hpp"
+
+// initial size of the buffer of a fd_istream
+#define FD_ISTREAM_BUFFER_SIZE 0x10000
+// size of the window of a file mapped by a mmap_istream
+#define MMAP_ISTREAM_WINDOW_SIZE 0x4000000
+// largest single field (string or byte block) the file streams make available at once
+#define SDF_MAX_FIELD_SIZE 0x10000000
+
+/*!
+@brief int_istream reading from a file descriptor
+
+The data is read in blocks into a buffer, which is refilled when it is exhausted. Memory stays constant independent of
+the size of the input, the buffer only grows while a single field is larger than the buffer (up to SDF_MAX_FIELD_SIZE)
+and shrinks back with the next refill. Works with pipes and sockets as well as with files.
+*/
+class fd_istream : public int_istream
+{
+private:
+  int          fd;
+  bool         owns_fd;
+  bool         at_eof;
+  size_t       buffer_size;  //!< size of the blocks read from fd
+  off_t        input_left;   //!< bytes left in a regular file when the stream was created, -1 for pipes and sockets
+  vector<char> buffer;
+
+protected:
+  bool fill(size_t min_bytes) override;
+
+public:
+  /*!
+  @brief constructor with an open file descriptor, which is not closed by this stream
+  */
+  explicit fd_istream(int _fd, size_t _buffer_size = FD_ISTREAM_BUFFER_SIZE);
+
+  /*!
+  @brief constructor opening a file, which is closed by the destructor
+  */
+  explicit fd_istream(const string &file_name, size_t _buffer_size = FD_ISTREAM_BUFFER_SIZE);
+
+  ~fd_istream() override;
+
+  bool may_contain(size_t length) override;
+
+  fd_istream(const fd_istream &) = delete;
+
+  fd_istream &operator=(const fd_istream &) = delete;
+};
+
+/*!
+@brief int_istream reading from a memory mapped file
+
+Only a window of the file is mapped at a time, when the window has been read the next one is mapped. Data is not
+copied, spans returned by read_span() point into the mapping (and are valid until the next window is mapped).
+*/
+class mmap_istream : public int_istream
+{
+private:
+  int    fd;
+  bool   owns_fd;
+  off_t  region_start;  //!< offset of the region to be read in the file
+  off_t  region_end;    //!< end of the region to be read in the file
+  off_t  window_start;  //!< file offset of the current mapping (page aligned)
+  char  *window;        //!< current mapping or nullptr
+  size_t window_length;
+  size_t window_size;   //!< default size of the mapped windows
+
+  void unmap();
+
+  off_t next_offset();
+
+protected:
+  bool fill(size_t min_bytes) override;
+
+public:
+  /*!
+  @brief constructor mapping a region of an open file, the file descriptor is not closed by this stream
+
+  @param _fd file descriptor of a file opened for reading
+  @param offset start of the region in the file
+  @param length length of the region
+  @param _window_size size of the mapped windows
+  */
+  mmap_istream(int _fd, off_t offset, size_t length, size_t _window_size = MMAP_ISTREAM_WINDOW_SIZE);
+
+  /*!
+  @brief constructor mapping a whole file, which is closed by the destructor
+  */
+  explicit mmap_istream(const string &file_name, size_t _window_size = MMAP_ISTREAM_WINDOW_SIZE);
+
+  ~mmap_istream() override;
+
+  bool may_contain(size_t length) override;
+
+  mmap_istream(const mmap_istream &) = delete;
+
+  mmap_istream &operator=(const mmap_istream &) = delete;
+};
+
+#endif //WIN32
+
+#endif //CEALR_SDF_FILE_STREAM_H
@@ -18,25 +18,21 @@
 #include <vector>
 #include <sstream>
 #include <map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 using namespace std;
 
 #define currentVersion 20
 
-//class sdf_ostream;
-
-//class Writable
-//{
-//public:
-//  virtual void write(ostream &os) = 0;
-//};
-
-// class template for reader (ideally replace with polymorphic lambdas in C++ 14 and above)
-template <class T>
-class Reader {
-public:
-  virtual T read() = 0;
-};
+// size at which a buffered sdf_ostream flushes to its output stream
+#define SDF_OSTREAM_BUFFER_SIZE 0x4000
+// number of elements reserved in advance by sdf_istream::readList() and readPairs(), further elements grow the vector
+#define SDF_LIST_RESERVE_CHUNK 0x1000
 
 class io_error : public exception
 {
@@ -54,8 +50,66 @@ public:
 };
 
 
+/*!
+@brief view of a range of bytes inside the buffer of an int_istream
+
+The view does not own the data, it is only valid as long as the buffer it has been read from.
+*/
+struct byte_span
+{
+  const char *data;
+  size_t      size;
+
+  const char *begin() const
+  {
+    return data;
+  }
+
+  const char *end() const
+  {
+    return data + size;
+  }
+
+  string str() const
+  {
+    return string(data, size);
+  }
+
+  vector<char> to_vector() const
+  {
+    return vector<char>(data, data + size);
+  }
+};
+
+/*!
+@brief byte input for sdf_istream
+
+Reads from a vector in memory. Subclasses reading from files (see sdf_file_stream.h) refill the get area on demand by
+overriding fill() and tell whether their input is long enough by overriding may_contain(), views returned by read_span()
+are only valid until the next read in that case.
+*/
 class int_istream : public streambuf
 {
+protected:
+  streamsize consumed = 0; //!< number of bytes that have been dropped from the get area by fill()
+
+  int_istream() : streambuf() {}
+
+  /*!
+  @brief makes at least the given number of bytes available in the get area, the vector in memory cannot be refilled
+
+  @return false, if the input ends before that many bytes are available
+  */
+  virtual bool fill(size_t)
+  {
+    return false;
+  }
+
+  int_type underflow() override
+  {
+    return fill(1) ? traits_type::to_int_type(*gptr()) : traits_type::eof();
+  }
+
 public:
   explicit int_istream(vector<char> *data) : streambuf()
   {
@@ -63,6 +117,27 @@ public:
     setg(gbeg, gbeg, data->end().base());
   }
 
+  /*!
+  @brief returns true, if at least length bytes can be read from the get area (refilling it if necessary)
+
+  All length bytes are buffered at once, so this is meant for single fields, use may_contain() for lengths of whole
+  lists or larger blocks.
+  */
+  bool ensure(size_t length)
+  {
+    return remaining() >= length || fill(length);
+  }
+
+  /*!
+  @brief returns false, if the input is known to end before another length bytes, without buffering them
+
+  The vector in memory knows its end. Subclasses of unknown length (pipes) return true and fail when the data is read.
+  */
+  virtual bool may_contain(size_t length)
+  {
+    return remaining() >= length;
+  }
+
   streamsize read_int8buf(void *buff, size_t offset, streamsize length)
   {
     return xsgetn(((char *) buff) + offset, length);
@@ -73,6 +148,48 @@ public:
     return sbumpc();
   }
 
+  /*!
+  @brief returns the number of bytes that have been read so far
+  */
+  streamsize position()
+  {
+    return consumed + (gptr() - eback());
+  }
+
+  /*!
+  @brief returns the number of bytes that have not been read yet
+  */
+  size_t remaining()
+  {
+    return static_cast<size_t>(egptr() - gptr());
+  }
+
+  /*!
+  @brief returns a pointer to the next byte without reading it, valid if remaining() is not 0 (see ensure())
+  */
+  const char *peek()
+  {
+    return gptr();
+  }
+
+  /*!
+  @brief skips a few bytes, length must not exceed remaining()
+  */
+  void skip(int length)
+  {
+    gbump(length);
+  }
+
+  /*!
+  @brief returns a view of the next length bytes and skips them, length must not exceed remaining()
+  */
+  byte_span read_span(size_t length)
+  {
+    byte_span span{gptr(), length};
+    setg(eback(), gptr() + length, egptr());
+    return span;
+  }
+
   short read_int16()
   {
     const auto c_h = sbumpc();
@@ -95,12 +212,126 @@ typedef enum compatibility
   Default, SuppressReadingOfHeader, PermitPre5Header
 } _compatibility;
 
+/*!
+@brief encodings of integers in the different versions of the serialized data format
+*/
+enum sdf_int_encoding
+{
+  FIXED_INT32,    //!< before version 5: 4 bytes big endian
+  VARINT,         //!< version 5 to 12: 7 bits per byte, high bit set if more bytes follow
+  SIGNED_VARINT   //!< version 13 and above: like VARINT, but the first byte has only 6 bits and the sign in bit 6
+};
+
 class sdf_istream
 {
 
 private:
   int_istream *inBase;
+  bool ownsBase;
   int storedVersion;
+  long (sdf_istream::*intDecoder)(); //!< decoder of the integer encoding of storedVersion, set by setStoredVersion()
+
+  /*!
+  @brief sets the version of the input and binds the matching integer decoder once, so readInt() does not check the
+         encoding for every integer
+  */
+  void setStoredVersion(int version)
+  {
+    storedVersion = version;
+    intDecoder    = version >= 13 ? &sdf_istream::readIntEncoded<SIGNED_VARINT> :
+                    version >= 5  ? &sdf_istream::readIntEncoded<VARINT> :
+                                    &sdf_istream::readIntEncoded<FIXED_INT32>;
+  }
+
+  /*!
+  @brief decodes an integer in the given encoding
+
+  Instantiated once per encoding, so the checks of the encoding are resolved at compile time. Single byte integers
+  are returned right away, longer variable length integers of up to 8 bytes are decoded without branches from a
+  single 64 bit load, if enough input is buffered.
+  */
+  template <sdf_int_encoding encoding>
+  long readIntEncoded()
+  {
+    if (encoding == FIXED_INT32)
+    {
+      const byte_span raw = readRawSpan(4);
+      const auto *b       = reinterpret_cast<const unsigned char *>(raw.data);
+      return static_cast<int32_t>((uint32_t) b[0] << 24 | (uint32_t) b[1] << 16 | (uint32_t) b[2] << 8 | b[3]);
+    }
+    const int firstBits = encoding == SIGNED_VARINT ? 6 : 7;
+    if (inBase->ensure(1) && (*inBase->peek() & 0x80) == 0)
+    {
+      // most integers (lengths, counts, small values) fit into one byte
+      const auto b = static_cast<unsigned char>(*inBase->peek());
+      inBase->skip(1);
+      const long v = b & ((1 << firstBits) - 1);
+      return encoding == SIGNED_VARINT && (b & 0x40) ? -v : v;
+    }
+    // only bytes that are buffered already, refilling the input for 8 bytes could wait for data that never comes
+    if (inBase->remaining() >= 8)
+    {
+      const uint64_t word = load_le64(inBase->peek());
+      const uint64_t ends = ~word & 0x8080808080808080ULL; // high bit of every byte that ends the integer
+      if (ends)
+      {
+        const unsigned length = (count_trailing_zeros64(ends) >> 3) + 1;
+        const uint64_t x      = (length == 8 ? word : word & ((1ULL << (length * 8)) - 1)) & 0x7F7F7F7F7F7F7F7FULL;
+        // compact the 7 bit groups: pairs of bytes to 14 bits, then to 28 bits, then to 56 bits
+        uint64_t v = ((x & 0x7F007F007F007F00ULL) >> 1) | (x & 0x007F007F007F007FULL);
+        v          = ((v & 0x3FFF00003FFF0000ULL) >> 2) | (v & 0x00003FFF00003FFFULL);
+        v          = ((v & 0x0FFFFFFF00000000ULL) >> 4) | (v & 0x000000000FFFFFFFULL);
+        if (firstBits == 6)
+        {
+          // the first byte only contributes 6 bits, bit 6 is the sign
+          v = (v & 0x3F) | ((v >> 7) << 6);
+        }
+        inBase->skip(length);
+        if (encoding == SIGNED_VARINT)
+        {
+          const uint64_t negative = (x >> 6) & 1;
+          return static_cast<long>((v ^ (0 - negative)) + negative);
+        }
+        return static_cast<long>(v);
+      }
+    }
+
+    // slow path near the end of the buffered input or for integers longer than 8 bytes
+    int b = readByteForInt();
+    const bool isNegative = encoding == SIGNED_VARINT && (b & (1 << 6)) != 0;
+    uint64_t v = (uint64_t) (b & ((1 << firstBits) - 1));
+    for (int shift = firstBits; (b & 0x80) != 0; shift += 7)
+    {
+      if (shift > 63)
+      {
+        throw io_error(__FILE__, __LINE__, "Integer exceeds 64 bits.");
+      }
+      b = readByteForInt();
+      v |= ((uint64_t) (b & 0x7F)) << shift;
+    }
+    return isNegative ? -static_cast<long>(v) : static_cast<long>(v);
+  }
+
+  static uint64_t load_le64(const char *p)
+  {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+  }
+
+  static unsigned count_trailing_zeros64(uint64_t v)
+  {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+  }
 
   int readByteForInt()
   {
@@ -115,78 +346,56 @@ private:
 public:
   explicit sdf_istream(int_istream *_inBase, _compatibility compatibility)
   {
-    inBase = _inBase;
+    inBase   = _inBase;
+    ownsBase = false;
     if (compatibility != _compatibility::SuppressReadingOfHeader)
     {
       readHeader(compatibility == _compatibility::PermitPre5Header);
     }
     else
     {
-      storedVersion = 1;
+      setStoredVersion(1);
     }
   }
 
   explicit sdf_istream(vector<char> *in, _compatibility compatibility)
   {
-    inBase = new int_istream(in);
-    if (compatibility != _compatibility::SuppressReadingOfHeader)
-    {
-      readHeader(compatibility == _compatibility::PermitPre5Header);
-    }
-    else
+    inBase   = new int_istream(in);
+    ownsBase = true;
+    try
     {
-      storedVersion = 1;
-    }
-  }
-
-  long readInt()
-  {
-    long v = 0;
-    if (supports(13))
-    {
-      int shift = 0;
-      int b = readByteForInt();
-
-      bool isNegative = (b & (1 << 6)) != 0;
-      v |= ((long) (b & 0x3F)) << shift;
-      shift += 6;
-
-      for (;; shift += 7)
+      if (compatibility != _compatibility::SuppressReadingOfHeader)
       {
-        if ((b & 0x80) == 0)
-        {
-          break;
-        }
-        b = readByteForInt();
-        v |= ((long) (b & 0x7F)) << shift;
+        readHeader(compatibility == _compatibility::PermitPre5Header);
       }
-
-      if (isNegative)
+      else
       {
-        v = -v;
+        setStoredVersion(1);
       }
     }
-    else if (supports(5))
+    catch (...)
     {
-      for (int shift = 0;; shift += 7)
-      {
-        int b = readByteForInt();
-        v |= ((long) (b & 0x7F)) << shift;
-        if ((b & 0x80) == 0)
-        {
-          break;
-        }
-      }
+      // the destructor is not called if the header cannot be read
+      delete inBase;
+      throw;
     }
-    else
+  }
+
+  ~sdf_istream()
+  {
+    if (ownsBase)
     {
-      vector<char> buf(4, 0);
-      readRaw(&buf[0], 4);
-      int_istream bis(&buf);
-      v = bis.read_int32();
+      delete inBase;
     }
+  }
 
-    return v;
+  sdf_istream(const sdf_istream &) = delete;
+
+  sdf_istream &operator=(const sdf_istream &) = delete;
+
+  long readInt()
+  {
+    return (this->*intDecoder)();
   }
 
   bool supports(int minVersion)
@@ -200,8 +409,9 @@ public:
 
   void readHeader(bool permitPre5Header)
   {
-    storedVersion = 5; // make subsequent read_int32() use the new input format
-    storedVersion = (int) readInt();
+    setStoredVersion(5); // make subsequent readInt() use the new input format
+    const auto version = (int) readInt();
+    setStoredVersion(version);
 
     if (permitPre5Header)
     {
@@ -217,7 +427,7 @@ public:
           str << "Old style version prefix has only been supported up to version 4 but is " << oldStyleVersion;
           throw io_error(__FILE__, __LINE__, str.str());
         }
-        storedVersion = oldStyleVersion;
+        setStoredVersion(oldStyleVersion);
       }
     }
 
@@ -236,20 +446,69 @@ public:
 
   void readRaw(void *b, size_t offset, int length)
   {
-    for (int numRead = 0; numRead < length;)
+    // copied in the blocks the input provides, a refilling input does not need to buffer all of it
+    if (length < 0 || !inBase->may_contain(static_cast<size_t>(length)) ||
+        inBase->read_int8buf(b, offset, length) != length)
     {
-      streamsize got = inBase->read_int8buf(b, (size_t) (offset + numRead), (streamsize) length - numRead);
-      if (got < 0)
-      {
-        stringstream m;
-        m << "Cannot fully read a byte array, expected " << length << " bytes but only could read " << numRead << ".";
-        throw io_error(__FILE__, __LINE__, m.str());
-      }
-      else if (got > 0)
-      {
-        numRead += got;
-      }
+      stringstream m;
+      m << "Cannot fully read a byte array, expected " << length << " bytes but the input ends before.";
+      throw io_error(__FILE__, __LINE__, m.str());
+    }
+  }
+
+  /*!
+  @brief reads length bytes without copying them
+
+  @return view into the buffer of the underlying int_istream
+  */
+  byte_span readRawSpan(size_t length)
+  {
+    if (!inBase->ensure(length))
+    {
+      stringstream m;
+      m << "Cannot fully read a byte array, expected " << length << " bytes but only " << inBase->remaining()
+        << " are left.";
+      throw io_error(__FILE__, __LINE__, m.str());
+    }
+    return inBase->read_span(length);
+  }
+
+  /*!
+  @brief reads the length of a string or byte block and checks it against the remaining input
+
+  @return length, which is guaranteed to be available in the input
+  */
+  size_t readLength()
+  {
+    const long length = readInt();
+    if (length < 0 || !inBase->ensure(static_cast<size_t>(length)))
+    {
+      stringstream m;
+      m << "Illegal length " << length << " of a string or byte block, only " << inBase->remaining()
+        << " bytes are left.";
+      throw io_error(__FILE__, __LINE__, m.str());
     }
+    return static_cast<size_t>(length);
+  }
+
+  /*!
+  @brief reads a string without copying it
+
+  @return view into the buffer of the underlying int_istream
+  */
+  byte_span readStringSpan()
+  {
+    return inBase->read_span(readLength());
+  }
+
+  /*!
+  @brief reads a byte block without copying it
+
+  @return view into the buffer of the underlying int_istream
+  */
+  byte_span readByteBlockSpan()
+  {
+    return inBase->read_span(readLength());
   }
 
   // todo implement read_char_vector(int len) and replace hashes by vector<unsigned char>
@@ -269,11 +528,7 @@ public:
 
   string *readString()
   {
-    auto length= static_cast<int>(readInt());
-    char textRaw[length+1];
-    readRaw(textRaw, length);
-    textRaw[length] = '\0';
-    return new string(textRaw);
+    return new string(readStringSpan().str());
   }
 
   bool readBoolean()
@@ -295,39 +550,85 @@ public:
   char readByte()
   {
     int b = inBase->read_int8();
+    if (b < 0)
+    {
+      throw io_error(__FILE__, __LINE__, "Premature end of data while reading a byte.");
+    }
 
     return static_cast<char>(b);
   }
 
-  template <class T>
-  list<T> *readList(Reader<T> reader)
+  /*!
+  @brief reads the number of elements of a list or map
+
+  Every element takes at least one byte, so a count exceeding the remaining input is rejected before anything is
+  allocated for it. The elements are not buffered for this check, a refilling input keeps reading them in blocks.
+  */
+  size_t readCount()
   {
-    auto lst = new list<T>();
-    long length = readInt();
-    for (long i=0;i<length;i++)
+    const long count = readInt();
+    if (count < 0 || !inBase->may_contain(static_cast<size_t>(count)))
     {
-      lst->push_back(reader.read());
+      stringstream m;
+      m << "Illegal number of elements " << count << ", the input ends before.";
+      throw io_error(__FILE__, __LINE__, m.str());
+    }
+    return static_cast<size_t>(count);
+  }
+
+  /*!
+  @brief reads a list into a vector, which is allocated once with the encoded number of elements (at most
+  SDF_LIST_RESERVE_CHUNK in advance, an input of unknown length cannot confirm larger counts before they are read)
+
+  @param readElement callable reading one element from this stream, e.g. [&in]() { return in.readInt(); }
+  */
+  template <class ElementReader>
+  auto readList(ElementReader readElement) -> vector<decltype(readElement())> *
+  {
+    const size_t count = readCount();
+    auto lst           = new vector<decltype(readElement())>();
+    try
+    {
+      lst->reserve(min<size_t>(count, SDF_LIST_RESERVE_CHUNK));
+      for (size_t i = 0; i < count; i++)
+      {
+        lst->push_back(readElement());
+      }
+    }
+    catch (...)
+    {
+      delete lst;
+      throw;
     }
     return lst;
   }
 
-  template <class T>
-  list<T> *readOptList(Reader<T> &reader)
+  template <class ElementReader>
+  auto readOptList(ElementReader readElement) -> vector<decltype(readElement())> *
   {
-      return readBoolean()? readList(reader):nullptr;
+      return readBoolean()? readList(readElement):nullptr;
+  }
+
+  /*!
+  @brief reads a list of byte blocks
+  */
+  vector<vector<char>> *readByteBlockList()
+  {
+    return readList([this]()
+                    {
+                      return readByteBlockSpan().to_vector();
+                    });
   }
 
   vector<char> *readByteBlock()
   {
-    auto length = static_cast<unsigned long>(readInt());
-    char buf[length];
-    readRaw(buf, static_cast<int>(length));
-    return new vector<char>(buf, buf+length);
+    const byte_span block = readByteBlockSpan();
+    return new vector<char>(block.begin(), block.end());
   }
 
   string *readOptString()
   {
-      return readBoolean()? new string(*readString()):nullptr;
+      return readBoolean()? readString():nullptr;
   }
 
   long readDate()
@@ -340,10 +641,10 @@ public:
       return readBoolean()?new int(readDate()):nullptr;
   }
 
-  template <class T>
-  T readOpt(Reader<T> &reader)
+  template <class ElementReader>
+  auto readOpt(ElementReader readElement) -> decltype(readElement())
   {
-    return readBoolean()? reader.read():nullptr;
+    return readBoolean()? readElement():nullptr;
   }
 
   vector<char> *readOptByteBlock()
@@ -351,17 +652,34 @@ public:
     return readBoolean() ? readByteBlock() : nullptr;
   }
 
+  /*!
+  @brief reads a map into a vector of key value pairs in the order they are stored
+
+  @param readKey callable reading a key from this stream
+  @param readValue callable reading a value from this stream
+  */
+  template <class KeyReader, class ValueReader>
+  auto readPairs(KeyReader readKey, ValueReader readValue) -> vector<pair<decltype(readKey()), decltype(readValue())>>
+  {
+    const size_t count = readCount();
+    vector<pair<decltype(readKey()), decltype(readValue())>> pairs;
+    pairs.reserve(min<size_t>(count, SDF_LIST_RESERVE_CHUNK));
+    for (size_t i = 0; i < count; i++)
+    {
+      auto key = readKey(); // the key is stored first
+      pairs.emplace_back(std::move(key), readValue());
+    }
+    return pairs;
+  }
+
   map<string, vector<char>> *readMap()
   {
-    auto map = new ::map<string, vector<char>>();
-    long length = readInt();
-    for (long i = 0; i < length; i++)
+    auto pairs = readPairs([this]() { return readStringSpan().str(); },
+                           [this]() { return readByteBlockSpan().to_vector(); });
+    auto map   = new ::map<string, vector<char>>();
+    for (auto &entry:pairs)
     {
-      string *key = readString();
-      vector<char> *value = readByteBlock();
-      map->insert(pair<string, vector<char>>(*key, *value));
-      delete key;
-      delete value;
+      map->insert(std::move(entry));
     }
     return map;
   }
@@ -415,4 +733,208 @@ public:
 //  }
 };
 
+/*!
+@brief writer for the serialized data format
+
+Counterpart of sdf_istream, always writes the current version of the format (integers with sign in the first byte,
+version 13 and above). The data is either appended directly to a vector or buffered and written in blocks of
+SDF_OSTREAM_BUFFER_SIZE bytes to an output stream, so no allocation is needed per field.
+*/
+class sdf_ostream
+{
+private:
+  ostream *sink;          //!< output stream for buffered mode, nullptr if writing to a vector
+  vector<char> buffer;    //!< own buffer in buffered mode
+  vector<char> *out;      //!< either the target vector or &buffer
+
+  void flushIfFull()
+  {
+    if (sink && out->size() >= SDF_OSTREAM_BUFFER_SIZE)
+    {
+      flush();
+    }
+  }
+
+public:
+  /*!
+  @brief constructor for writing into a vector
+
+  @param target the data is appended to this vector
+  @param writeHeader if true, the version of the format is written first
+  */
+  explicit sdf_ostream(vector<char> *target, bool writeHeader = true)
+  {
+    sink = nullptr;
+    out  = target;
+    if (writeHeader)
+    {
+      this->writeHeader();
+    }
+  }
+
+  /*!
+  @brief constructor for buffered writing into an output stream
+
+  @param _sink the data is written to this stream in blocks, the rest when flush() is called or on destruction
+  @param writeHeader if true, the version of the format is written first
+  */
+  explicit sdf_ostream(ostream *_sink, bool writeHeader = true)
+  {
+    sink = _sink;
+    out  = &buffer;
+    buffer.reserve(SDF_OSTREAM_BUFFER_SIZE + 64);
+    if (writeHeader)
+    {
+      this->writeHeader();
+    }
+  }
+
+  ~sdf_ostream()
+  {
+    flush();
+  }
+
+  void flush()
+  {
+    if (sink && !buffer.empty())
+    {
+      sink->write(&buffer[0], buffer.size());
+      buffer.clear();
+    }
+  }
+
+  void writeHeader()
+  {
+    // the header is read with the format of version 5 (7 bits per byte without sign)
+    for (unsigned long v = currentVersion;; v >>= 7)
+    {
+      if (v < 0x80)
+      {
+        writeByte(static_cast<char>(v));
+        break;
+      }
+      writeByte(static_cast<char>((v & 0x7F) | 0x80));
+    }
+  }
+
+  void writeInt(long v)
+  {
+    const bool isNegative = v < 0;
+    unsigned long magnitude = isNegative ? 0UL - (unsigned long) v : (unsigned long) v;
+    char b = static_cast<char>((magnitude & 0x3F) | (isNegative ? 0x40 : 0));
+    magnitude >>= 6;
+    if (magnitude)
+    {
+      b |= 0x80;
+    }
+    writeByte(b);
+    while (magnitude)
+    {
+      b = static_cast<char>(magnitude & 0x7F);
+      magnitude >>= 7;
+      if (magnitude)
+      {
+        b |= 0x80;
+      }
+      writeByte(b);
+    }
+  }
+
+  void writeByte(char b)
+  {
+    out->push_back(b);
+    flushIfFull();
+  }
+
+  void writeBoolean(bool b)
+  {
+    writeByte(static_cast<char>(b ? 1 : 0));
+  }
+
+  void writeRaw(const void *b, size_t len)
+  {
+    const char *data = static_cast<const char *>(b);
+    out->insert(out->end(), data, data + len);
+    flushIfFull();
+  }
+
+  void write(const string &str)
+  {
+    writeInt(static_cast<long>(str.size()));
+    writeRaw(str.data(), str.size());
+  }
+
+  void writeOpt(const string *optStr)
+  {
+    writeBoolean(optStr != nullptr);
+    if (optStr)
+    {
+      write(*optStr);
+    }
+  }
+
+  void writeOptInt(const int *optInt)
+  {
+    writeBoolean(optInt != nullptr);
+    if (optInt)
+    {
+      writeInt(*optInt);
+    }
+  }
+
+  void writeDate(long date)
+  {
+    writeInt(date);
+  }
+
+  void writeByteBlock(const vector<char> &data)
+  {
+    writeInt(static_cast<long>(data.size()));
+    writeRaw(data.data(), data.size());
+  }
+
+  void writeOptByteBlock(const vector<char> *optData)
+  {
+    writeBoolean(optData != nullptr);
+    if (optData)
+    {
+      writeByteBlock(*optData);
+    }
+  }
+
+  /*!
+  @brief writes a list of elements
+
+  @param lst any container of elements
+  @param writeElement callable writing one element to this stream
+  */
+  template <class Container, class ElementWriter>
+  void writeList(const Container &lst, ElementWriter writeElement)
+  {
+    writeInt(static_cast<long>(lst.size()));
+    for (const auto &element:lst)
+    {
+      writeElement(element);
+    }
+  }
+
+  void writeList(const vector<vector<char>> &lst)
+  {
+    writeList(lst, [this](const vector<char> &data)
+    {
+      writeByteBlock(data);
+    });
+  }
+
+  void writeMap(const map<string, vector<char>> &m)
+  {
+    writeInt(static_cast<long>(m.size()));
+    for (const auto &e:m)
+    {
+      write(e.first);
+      writeByteBlock(e.second);
+    }
+  }
+};
+
 #endif //CEALR_SERIALIZED_DATA_FORMAT_H
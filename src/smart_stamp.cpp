@@ -29,18 +29,27 @@ SmartStamp::SmartStamp(vector<char> _data)
   data = new vector<char>(_data.begin(), _data.end());
 }
 
+SmartStamp::SmartStamp(sdf_istream &in)
+{
+  const byte_span raw = in.readByteBlockSpan();
+  data                = new vector<char>(raw.begin(), raw.end());
+}
+
 SmartStamp::~SmartStamp()
 {
   delete data;
-  delete docHash;
-  delete rootHash;
+  delete[] docHash;
+  delete[] rootHash;
 //  delete blockchain;
 //  delete documentInfo;
 //  delete sealedMetaData;
-  for (SmartStamp::Operation *o:*operations){
-    delete o;
+  if (operations)
+  {
+    for (SmartStamp::Operation *o:*operations){
+      delete o;
+    }
+    delete operations;
   }
-  delete operations;
 }
 
 void SmartStamp::parse()
@@ -70,8 +79,10 @@ void SmartStamp::parse()
 
   bundleMethod = in.supports(8) ? static_cast<BundleMethod>((int) in.readInt()) :
                               BundleMethod::BALANCED_MERKLE_TREE;
+  unsigned char hash[SHA256_DIGEST_LENGTH];
   for (bool finished = false; !finished;)
   {
+    long opcodeOffset = inRaw.position();
     int opcode = in.readByte();
     Operation *operation;
     switch (opcode)
@@ -82,48 +93,80 @@ void SmartStamp::parse()
         break;
 
       case OPCODE_DOC_SHA256:
-        docHash   = readSHA256(&in);
-        operation = new DocHash(docHash);
+        docHashOffset = opcodeOffset;
+        in.readRaw(hash, SHA256_DIGEST_LENGTH);
+        delete[] docHash;
+        docHash       = new unsigned char[SHA256_DIGEST_LENGTH];
+        memcpy(docHash, hash, SHA256_DIGEST_LENGTH);
+        operation     = new DocHash(docHash);
         break;
 
       case OPCODE_APPEND_THEN_SHA256:
-        operation = new Append(readSHA256(&in));
+        in.readRaw(hash, SHA256_DIGEST_LENGTH);
+        operation = new Append(hash);
         break;
 
       case OPCODE_PREPEND_THEN_SHA256:
-        operation = new Prepend(readSHA256(&in));
+        in.readRaw(hash, SHA256_DIGEST_LENGTH);
+        operation = new Prepend(hash);
+        break;
+
+      case OPCODE_LEAF_SHA256:
+        operation = new Leaf();
+        break;
+
+      case OPCODE_APPEND_THEN_NODE_SHA256:
+        in.readRaw(hash, SHA256_DIGEST_LENGTH);
+        operation = new Append(hash, true);
+        break;
+
+      case OPCODE_PREPEND_THEN_NODE_SHA256:
+        in.readRaw(hash, SHA256_DIGEST_LENGTH);
+        operation = new Prepend(hash, true);
         break;
 
       case OPCODE_ANCHOR_SHA256:
-        rootHash  = readSHA256(&in);
+        in.readRaw(hash, SHA256_DIGEST_LENGTH);
+        delete[] rootHash;
+        rootHash  = new unsigned char[SHA256_DIGEST_LENGTH];
+        memcpy(rootHash, hash, SHA256_DIGEST_LENGTH);
         operation = new Anchor(rootHash);
         break;
 
       case OPCODE_BLOCKCHAIN:
       {
-        BlockchainDescriptor *desc      = in.supports(3) ?
-                                          new BlockchainDescriptor(in) :
-                                          new BlockchainDescriptor(*in.readString(), (string &) "unknown");
-        string *blockChainId            = in.readString();
+        unique_ptr<BlockchainDescriptor> desc; // owned by the Blockchain operation once it is complete
+        if (in.supports(3))
+        {
+          desc.reset(new BlockchainDescriptor(in));
+        }
+        else
+        {
+          string generalName     = in.readStringSpan().str();
+          string unknownInstance = "unknown";
+          desc.reset(new BlockchainDescriptor(generalName, unknownInstance));
+        }
+        string blockChainId             = in.readStringSpan().str();
         time_t insertedIntoBlockchainAt = in.readInt();
-        blockchain                      = new Blockchain(desc, *blockChainId, insertedIntoBlockchainAt);
+        blockchain                      = new Blockchain(desc.release(), blockChainId, insertedIntoBlockchainAt);
         operation                       = blockchain;
         break;
       }
       case OPCODE_DOCUMENTINFO:
       {
-        string *optReferenceId          = in.readOptString();
-        string *optName                 = in.readOptString();
-        string *optContentType          = in.readOptString();
-        documentInfo                    = new DocumentInfo(optReferenceId, optName, optContentType);
+        unique_ptr<string> optReferenceId(in.readOptString());
+        unique_ptr<string> optName(in.readOptString());
+        unique_ptr<string> optContentType(in.readOptString());
+        documentInfo                    = new DocumentInfo(optReferenceId.release(), optName.release(),
+                                                           optContentType.release());
         operation                       = documentInfo;
         break;
       }
       case OPCODE_SEALEDMETADATA:
       {
-        string *metaData                = in.readString();
-        list<vector<char>> *mdStamps    = in.readList(Reader<vector<char>>(&in));
-        sealedMetaData                  = new SealedMetaData(metaData, mdStamps);
+        unique_ptr<string> metaData(in.readString());
+        vector<vector<char>> *mdStamps  = in.readByteBlockList();
+        sealedMetaData                  = new SealedMetaData(metaData.release(), mdStamps);
         operation                       = sealedMetaData;
         break;
       }
@@ -146,8 +189,10 @@ void SmartStamp::initFields()
 
 unsigned char *SmartStamp::readSHA256(sdf_istream *in)
 {
+  unsigned char buf[SHA256_DIGEST_LENGTH];
+  in->readRaw(buf, SHA256_DIGEST_LENGTH);
   auto *hash = new unsigned char[SHA256_DIGEST_LENGTH];
-  in->readRaw(hash, SHA256_DIGEST_LENGTH);
+  memcpy(hash, buf, SHA256_DIGEST_LENGTH);
   return hash;
 }
 
@@ -163,6 +208,29 @@ vector<char> *SmartStamp::toRawData()
   return data;
 }
 
+void SmartStamp::encode(const list<Operation *> &operations, BundleMethod bundleMethod, vector<char> *out)
+{
+  out->push_back('S');
+  out->push_back('T');
+  out->push_back(MAX_VERSION);
+  sdf_ostream sdf(out);
+  sdf.writeInt(bundleMethod);
+  for (const Operation *operation:operations)
+  {
+    operation->write(sdf);
+  }
+  sdf.writeByte(OPCODE_END);
+}
+
+vector<char> *SmartStamp::reencode()
+{
+  initFields();
+  auto raw = new vector<char>();
+  raw->reserve(data->size());
+  encode(*operations, bundleMethod, raw);
+  return raw;
+}
+
 unsigned char *SmartStamp::getDocHash()
 {
   initFields();
@@ -173,16 +241,18 @@ unsigned char *SmartStamp::getDocHash()
   return docHash;
 }
 
-SmartStamp::VerificationResult *SmartStamp::verifyByContents(char *documentContents, char *optHashInBlockchain, bool provideInstructions)
+SmartStamp::VerificationResult *SmartStamp::verifyByContents(char *documentContents, char * /*optHashInBlockchain*/, bool provideInstructions)
 {
-  auto *vm = new OperationEvaluator();
-  return verifyByHashHelper(vm, vm->hash(documentContents, SHA256_DIGEST_LENGTH), provideInstructions);
+  OperationEvaluator vm;
+  unique_ptr<unsigned char[]> hash(vm.hash(documentContents, SHA256_DIGEST_LENGTH));
+  return verifyByHashHelper(&vm, hash.get(), provideInstructions);
 }
 
-SmartStamp::VerificationResult *SmartStamp::verifyByHash(unsigned char *documentHash, char *optHashInBlockchain, bool provideInstructions)
+SmartStamp::VerificationResult *SmartStamp::verifyByHash(unsigned char *documentHash, char * /*optHashInBlockchain*/, bool provideInstructions)
 {
-  auto *vm = new OperationEvaluator();
-  return verifyByHashHelper(vm, documentHash, provideInstructions);
+  // the result keeps copies of the trace and the verification sources, not the evaluator
+  OperationEvaluator vm;
+  return verifyByHashHelper(&vm, documentHash, provideInstructions);
 }
 
 SmartStamp::VerificationResult *SmartStamp::verifyByHashHelper(SmartStamp::OperationEvaluator *vm, unsigned char *documentHash, bool provideInstructions)
@@ -221,6 +291,12 @@ BundleMethod SmartStamp::getBundleMethod() const
   return bundleMethod;
 }
 
+long SmartStamp::getDocHashOffset()
+{
+  initFields();
+  return docHashOffset;
+}
+
 void SmartStamp::BlockchainDescriptor::init(string &_blockchainGeneralName, string &_instanceName)
 {
   blockchainGeneralName = new string(_blockchainGeneralName);
@@ -232,16 +308,25 @@ SmartStamp::BlockchainDescriptor::BlockchainDescriptor(string &_blockchainGenera
   init(_blockchainGeneralName, _instanceName);
 }
 
-//void SmartStamp::BlockchainDescriptor::write(sdf_ostream &out)
-//{
-//  out.write(blockchainGeneralName);
-//  out.write(instanceName);
-//}
+void SmartStamp::BlockchainDescriptor::write(sdf_ostream &out) const
+{
+  out.write(*blockchainGeneralName);
+  out.write(*instanceName);
+}
 
-SmartStamp::BlockchainDescriptor::BlockchainDescriptor(sdf_istream in)
+SmartStamp::BlockchainDescriptor::BlockchainDescriptor(sdf_istream &in)
 {
-  blockchainGeneralName = in.readString();
-  instanceName=in.readString();
+  // both names are read before anything is allocated, so nothing leaks if the input is truncated
+  string generalName    = in.readStringSpan().str();
+  string instance       = in.readStringSpan().str();
+  blockchainGeneralName = new string(std::move(generalName));
+  instanceName          = new string(std::move(instance));
+}
+
+SmartStamp::BlockchainDescriptor::~BlockchainDescriptor()
+{
+  delete blockchainGeneralName;
+  delete instanceName;
 }
 
 json SmartStamp::BlockchainDescriptor::toJson()
@@ -254,8 +339,8 @@ json SmartStamp::BlockchainDescriptor::toJson()
 
 SmartStamp::OperationEvaluator::OperationEvaluator()
 {
-  additionalInfo                  = new string();
-  optInstructions                 = nullptr;
+  trace                           = new vector<TraceEvent>();
+  provideInstructions             = false;
   origDocComparisonDone           = false;
   anchorComparisonDone            = false;
   verificationSources             = new list<VerificationSource>();
@@ -268,17 +353,16 @@ SmartStamp::OperationEvaluator::OperationEvaluator()
 SmartStamp::VerificationResult *SmartStamp::OperationEvaluator::verify( list<SmartStamp::Operation *> *operations,
                                                                         unsigned char *origDocHash,
                                                                         char *optoptBCAnchor,
-                                                                        bool provideInstructions)
+                                                                        bool _provideInstructions)
 {
   memcpy(accu, origDocHash, SHA256_DIGEST_LENGTH);
   bool verified         = false;
   optUsrProvAnchorInBC  = optoptBCAnchor;
   origDocComparisonDone = false;
   anchorComparisonDone  = false;
-  if (provideInstructions)
-  {
-    optInstructions = new string();
-  }
+  provideInstructions   = _provideInstructions;
+  trace->clear();
+  trace->reserve(operations->size());
   for (const Operation *operation: *operations)
   {
     operation->execute(*this);
@@ -287,7 +371,7 @@ SmartStamp::VerificationResult *SmartStamp::OperationEvaluator::verify( list<Sma
   {
     verified = true;
   }
-  return new VerificationResult(verified, *verificationSources, *additionalInfo, optInstructions);
+  return new VerificationResult(verified, *verificationSources, *trace, provideInstructions);
 }
 
 SmartStamp::OperationEvaluator::~OperationEvaluator()
@@ -296,9 +380,8 @@ SmartStamp::OperationEvaluator::~OperationEvaluator()
   delete optUsrProvAnchorInBC;
   delete optLookedUpAnchorInBlockchain;
   delete optLookedUpVerificationSources;
-  delete additionalInfo;
   delete verificationSources;
-  delete optInstructions;
+  delete trace;
 }
 
 unsigned char *SmartStamp::OperationEvaluator::accu_ptr()
@@ -337,12 +420,44 @@ SmartStamp::VerificationSource::VerificationSource(string &_sourceName, Blockcha
 }
 
 SmartStamp::VerificationResult::VerificationResult(bool _verified, list<VerificationSource> _verificationSources,
-                                                   string _additionalInfo, string *_optInstructions)
+                                                   vector<TraceEvent> _trace, bool _provideInstructions)
 {
   verified            = _verified;
   verificationSources = std::move(_verificationSources);
-  additionalInfo      = std::move(_additionalInfo);
-  optInstructions     = _optInstructions;
+  trace               = std::move(_trace);
+  provideInstructions = _provideInstructions;
+}
+
+string SmartStamp::VerificationResult::getAdditionalInfo()
+{
+  string additionalInfo;
+  for (const TraceEvent &event:trace)
+  {
+    additionalInfo.append(event.operation->info());
+  }
+  return additionalInfo;
+}
+
+string *SmartStamp::VerificationResult::getInstructions()
+{
+  if (!provideInstructions)
+  {
+    return nullptr;
+  }
+  auto instructions = new string();
+  for (const TraceEvent &event:trace)
+  {
+    const string instruction = event.operation->instruction(event.accu);
+    if (!instruction.empty())
+    {
+      instructions->append(instruction);
+      if (instructions->back() != '\n')
+      {
+        instructions->append("\n");
+      }
+    }
+  }
+  return instructions;
 }
 
 json SmartStamp::VerificationResult::toJson()
@@ -355,39 +470,71 @@ json SmartStamp::VerificationResult::toJson()
     sources.push_back(je);
   }
   j["sources"]        = sources;
-  j["additionalInfo"] = additionalInfo;
+  j["additionalInfo"] = getAdditionalInfo();
+  string *optInstructions = getInstructions();
   if (optInstructions != nullptr)
   {
     j["instructions"] = *optInstructions;
+    delete optInstructions;
   }
   return j;
 }
 
+void SmartStamp::Leaf::execute(OperationEvaluator &vm) const
+{
+  char combo[1 + SHA256_DIGEST_LENGTH];
+  combo[0] = MERKLE_LEAF_PREFIX;
+  memcpy(combo + 1, vm.accu_ptr(), SHA256_DIGEST_LENGTH);
+  unsigned char *combined = vm.hash(combo, sizeof(combo));
+  memcpy(vm.accu_ptr(), combined, SHA256_DIGEST_LENGTH);
+  delete[] combined;
+  vm.instruct(OPCODE_LEAF_SHA256, this);
+}
+
+string SmartStamp::Leaf::instruction(const unsigned char *accu) const
+{
+  return "Prepend 00 to hash it as leaf of the bundle, resulting in " + to_hex(accu, SHA256_DIGEST_LENGTH) + ".";
+}
+
+void SmartStamp::Leaf::write(sdf_ostream &out) const
+{
+  out.writeByte(OPCODE_LEAF_SHA256);
+}
+
 void SmartStamp::Append::execute(OperationEvaluator &vm) const
 {
-  char combo[2*SHA256_DIGEST_LENGTH];
-  memcpy(combo, vm.accu_ptr(), SHA256_DIGEST_LENGTH);
-  memcpy(combo+SHA256_DIGEST_LENGTH, hash, SHA256_DIGEST_LENGTH);
-  memcpy(vm.accu_ptr(), vm.hash(combo, 2*SHA256_DIGEST_LENGTH), SHA256_DIGEST_LENGTH);
-  vm.instruct("Append " + to_hex(hash, SHA256_DIGEST_LENGTH) + " and hash it, resulting in " + to_hex(vm.accu_ptr(), SHA256_DIGEST_LENGTH) + ".");
+  char combo[1 + 2*SHA256_DIGEST_LENGTH];
+  combo[0] = MERKLE_NODE_PREFIX;
+  char *pair = node ? combo + 1 : combo;
+  memcpy(pair, vm.accu_ptr(), SHA256_DIGEST_LENGTH);
+  memcpy(pair+SHA256_DIGEST_LENGTH, hash, SHA256_DIGEST_LENGTH);
+  unsigned char *combined = vm.hash(combo, (node ? 1 : 0) + 2*SHA256_DIGEST_LENGTH);
+  memcpy(vm.accu_ptr(), combined, SHA256_DIGEST_LENGTH);
+  delete[] combined;
+  vm.instruct(node ? OPCODE_APPEND_THEN_NODE_SHA256 : OPCODE_APPEND_THEN_SHA256, this);
+}
+
+string SmartStamp::Append::instruction(const unsigned char *accu) const
+{
+  return "Append " + to_hex(hash, SHA256_DIGEST_LENGTH) + (node ? ", prepend 01" : "") + " and hash it, resulting in " +
+         to_hex(accu, SHA256_DIGEST_LENGTH) + ".";
 }
 
-SmartStamp::Append::Append(unsigned char *_hash)
+SmartStamp::Append::Append(unsigned char *_hash, bool _node)
 {
   memcpy(hash, _hash, SHA256_DIGEST_LENGTH);
+  node = _node;
 }
 
-//void SmartStamp::Append::write(sdf_ostream out)
-//{
-//  out.write(OPCODE_APPEND_THEN_SHA256);
-//  SmartStamp::writeSHA256(out, hash);
-//}
+void SmartStamp::Append::write(sdf_ostream &out) const
+{
+  out.writeByte(node ? OPCODE_APPEND_THEN_NODE_SHA256 : OPCODE_APPEND_THEN_SHA256);
+  SmartStamp::writeSHA256(out, hash);
+}
 
 void SmartStamp::DocHash::execute(SmartStamp::OperationEvaluator &vm) const
 {
-  vm.instruct(
-      "Check that hash in SmartStamp " + to_hex(vm.accu_ptr(), SHA256_DIGEST_LENGTH) + " equals actual document hash " +
-      to_hex(docHash, SHA256_DIGEST_LENGTH) + ".");
+  vm.instruct(OPCODE_DOC_SHA256, this);
   if (memcmp(vm.accu_ptr(), docHash, SHA256_DIGEST_LENGTH) != 0)
   {
     throw SmartStampError(__FILE__, __LINE__,
@@ -396,18 +543,47 @@ void SmartStamp::DocHash::execute(SmartStamp::OperationEvaluator &vm) const
   vm.setOrigDocComparisonDone(true);
 }
 
-SmartStamp::Prepend::Prepend(unsigned char *_hash)
+string SmartStamp::DocHash::instruction(const unsigned char *accu) const
+{
+  return "Check that hash in SmartStamp " + to_hex(accu, SHA256_DIGEST_LENGTH) + " equals actual document hash " +
+         to_hex(docHash, SHA256_DIGEST_LENGTH) + ".";
+}
+
+void SmartStamp::DocHash::write(sdf_ostream &out) const
+{
+  out.writeByte(OPCODE_DOC_SHA256);
+  SmartStamp::writeSHA256(out, docHash);
+}
+
+SmartStamp::Prepend::Prepend(unsigned char *_hash, bool _node)
 {
   memcpy(hash, _hash, SHA256_DIGEST_LENGTH);
+  node = _node;
 }
 
 void SmartStamp::Prepend::execute(SmartStamp::OperationEvaluator &vm) const
 {
-  char combo[2*SHA256_DIGEST_LENGTH];
-  memcpy(combo, hash, SHA256_DIGEST_LENGTH);
-  memcpy(combo+SHA256_DIGEST_LENGTH, vm.accu_ptr(), SHA256_DIGEST_LENGTH);
-  memcpy(vm.accu_ptr(), vm.hash(combo, 2*SHA256_DIGEST_LENGTH), SHA256_DIGEST_LENGTH);
-  vm.instruct("Prepend " + to_hex(hash, SHA256_DIGEST_LENGTH) + " and hash it, resulting in " + to_hex(vm.accu_ptr(), SHA256_DIGEST_LENGTH) + ".");
+  char combo[1 + 2*SHA256_DIGEST_LENGTH];
+  combo[0] = MERKLE_NODE_PREFIX;
+  char *pair = node ? combo + 1 : combo;
+  memcpy(pair, hash, SHA256_DIGEST_LENGTH);
+  memcpy(pair+SHA256_DIGEST_LENGTH, vm.accu_ptr(), SHA256_DIGEST_LENGTH);
+  unsigned char *combined = vm.hash(combo, (node ? 1 : 0) + 2*SHA256_DIGEST_LENGTH);
+  memcpy(vm.accu_ptr(), combined, SHA256_DIGEST_LENGTH);
+  delete[] combined;
+  vm.instruct(node ? OPCODE_PREPEND_THEN_NODE_SHA256 : OPCODE_PREPEND_THEN_SHA256, this);
+}
+
+string SmartStamp::Prepend::instruction(const unsigned char *accu) const
+{
+  return "Prepend " + to_hex(hash, SHA256_DIGEST_LENGTH) + (node ? ", prepend 01" : "") + " and hash it, resulting in " +
+         to_hex(accu, SHA256_DIGEST_LENGTH) + ".";
+}
+
+void SmartStamp::Prepend::write(sdf_ostream &out) const
+{
+  out.writeByte(node ? OPCODE_PREPEND_THEN_NODE_SHA256 : OPCODE_PREPEND_THEN_SHA256);
+  SmartStamp::writeSHA256(out, hash);
 }
 
 SmartStamp::Anchor::Anchor(unsigned char *_hash)
@@ -417,13 +593,13 @@ SmartStamp::Anchor::Anchor(unsigned char *_hash)
 
 void SmartStamp::Anchor::execute(SmartStamp::OperationEvaluator &vm) const
 {
-  vm.instruct("Check that provided anchor " + to_hex(hash, SHA256_DIGEST_LENGTH) + " equals calculated anchor " +
-              to_hex(vm.accu_ptr(), SHA256_DIGEST_LENGTH) + ".");
+  vm.instruct(OPCODE_ANCHOR_SHA256, this);
   if (memcmp(vm.accu_ptr(), hash, SHA256_DIGEST_LENGTH) != 0) {
     throw SmartStampError(__FILE__, __LINE__, "Calculated anchor does not equal stored anchor in SmartStamp.");
   }
   string str("AnchorInStamp");
-  vm.verificationSourcesAdd(new VerificationSource(str));
+  VerificationSource in_stamp(str);
+  vm.verificationSourcesAdd(&in_stamp);
   if (vm.optUsrProvAnchorInBC)
   {
     if (memcmp(vm.accu, vm.optUsrProvAnchorInBC, SHA256_DIGEST_LENGTH) != 0)
@@ -431,7 +607,8 @@ void SmartStamp::Anchor::execute(SmartStamp::OperationEvaluator &vm) const
       throw SmartStampError(__FILE__, __LINE__, "Calculated anchor does not equal provided anchor in blockchain.");
     }
     string str1("AnchorFromUser");
-    vm.verificationSourcesAdd(new VerificationSource(str1));
+    VerificationSource from_user(str1);
+    vm.verificationSourcesAdd(&from_user);
   }
   vm.anchorComparisonDone = true;
   memcpy(vm.optContainedAnchor, hash, SHA256_DIGEST_LENGTH);
@@ -448,6 +625,18 @@ void SmartStamp::Anchor::execute(SmartStamp::OperationEvaluator &vm) const
   }
 }
 
+string SmartStamp::Anchor::instruction(const unsigned char *accu) const
+{
+  return "Check that provided anchor " + to_hex(hash, SHA256_DIGEST_LENGTH) + " equals calculated anchor " +
+         to_hex(accu, SHA256_DIGEST_LENGTH) + ".";
+}
+
+void SmartStamp::Anchor::write(sdf_ostream &out) const
+{
+  out.writeByte(OPCODE_ANCHOR_SHA256);
+  SmartStamp::writeSHA256(out, hash);
+}
+
 SmartStamp::Blockchain::Blockchain(SmartStamp::BlockchainDescriptor *_blockChainDesc, string _blockChainId,
                                    time_t _insertedIntoBlockchainAt)
 {
@@ -463,9 +652,7 @@ SmartStamp::Blockchain::~Blockchain()
 
 void SmartStamp::Blockchain::execute(SmartStamp::OperationEvaluator &vm) const
 {
-  string msg="Registered in blockchain "+blockChainDesc->toString()+" using TxId or Id "+blockChainId+" at "+format_time(insertedIntoBlockchainAt, "%H:%M:%ST%Y-%m-%d");
-  vm.additionalInfo->append(msg+"\n");
-  vm.instruct(msg);
+  vm.instruct(OPCODE_BLOCKCHAIN, this);
 
 //      if (vm.optUsrProvAnchorInBC==nullptr && vm.optBCLookup!=nullptr) {
 //        char *anchorInBlockchain = vm.optBCLookup.findAnchor(blockChainDesc, blockChainId);
@@ -494,6 +681,16 @@ void SmartStamp::Blockchain::execute(SmartStamp::OperationEvaluator &vm) const
 //      }
 }
 
+string SmartStamp::Blockchain::instruction(const unsigned char *) const
+{
+  return "Registered in blockchain "+blockChainDesc->toString()+" using TxId or Id "+blockChainId+" at "+format_time(insertedIntoBlockchainAt, "%H:%M:%ST%Y-%m-%d");
+}
+
+string SmartStamp::Blockchain::info() const
+{
+  return instruction(nullptr)+"\n";
+}
+
 time_t SmartStamp::Blockchain::getInsertedIntoBlockchainAt() const
 {
   return insertedIntoBlockchainAt;
@@ -509,6 +706,14 @@ const string &SmartStamp::Blockchain::getBlockChainId() const
   return blockChainId;
 }
 
+void SmartStamp::Blockchain::write(sdf_ostream &out) const
+{
+  out.writeByte(OPCODE_BLOCKCHAIN);
+  blockChainDesc->write(out);
+  out.write(blockChainId);
+  out.writeInt(insertedIntoBlockchainAt);
+}
+
 SmartStamp::DocumentInfo::DocumentInfo(string *_optLookupInfo, string *_optName, string *_optContentType)
 {
   optLookupInfo   = _optLookupInfo;
@@ -524,6 +729,16 @@ SmartStamp::DocumentInfo::~DocumentInfo()
 }
 
 void SmartStamp::DocumentInfo::execute(SmartStamp::OperationEvaluator &vm) const
+{
+  vm.instruct(OPCODE_DOCUMENTINFO, this);
+}
+
+string SmartStamp::DocumentInfo::instruction(const unsigned char *) const
+{
+  return info();
+}
+
+string SmartStamp::DocumentInfo::info() const
 {
   string infoText;
   if (optLookupInfo != nullptr)
@@ -538,14 +753,18 @@ void SmartStamp::DocumentInfo::execute(SmartStamp::OperationEvaluator &vm) const
   {
     infoText.append("Document content type=" + *optContentType + "\n");
   }
-  vm.additionalInfo->append(infoText);
-  if (!infoText.empty())
-  {
-    vm.instruct(infoText);
-  }
+  return infoText;
 }
 
-SmartStamp::SealedMetaData::SealedMetaData(string *_data, list<vector<char>> *_metaDataStamps)
+void SmartStamp::DocumentInfo::write(sdf_ostream &out) const
+{
+  out.writeByte(OPCODE_DOCUMENTINFO);
+  out.writeOpt(optLookupInfo);
+  out.writeOpt(optName);
+  out.writeOpt(optContentType);
+}
+
+SmartStamp::SealedMetaData::SealedMetaData(string *_data, vector<vector<char>> *_metaDataStamps)
 {
   data            = _data;
   metaDataStamps  = _metaDataStamps;
@@ -558,6 +777,16 @@ SmartStamp::SealedMetaData::~SealedMetaData()
 }
 
 void SmartStamp::SealedMetaData::execute(SmartStamp::OperationEvaluator &vm) const
+{
+  vm.instruct(OPCODE_SEALEDMETADATA, this);
+}
+
+string SmartStamp::SealedMetaData::instruction(const unsigned char *) const
+{
+  return info();
+}
+
+string SmartStamp::SealedMetaData::info() const
 {
   string infoText;
   string str;
@@ -566,12 +795,7 @@ void SmartStamp::SealedMetaData::execute(SmartStamp::OperationEvaluator &vm) con
 //    str+= to_hex((unsigned char*)&chVector[0], static_cast<int>(chVector.size()));
   }
   infoText.append("Sealed meta data: contents=(" + *data + "), meta data SmartStamps=(" + str + ")\n");
-//    string infoText=info.toString();
-  vm.additionalInfo->append(infoText);
-  if (!infoText.empty())
-  {
-    vm.instruct(infoText);
-  }
+  return infoText;
 }
 
 string *SmartStamp::SealedMetaData::getData() const
@@ -579,8 +803,14 @@ string *SmartStamp::SealedMetaData::getData() const
   return data;
 }
 
-list<vector<char>> *SmartStamp::SealedMetaData::getMetaDataStamps() const
+vector<vector<char>> *SmartStamp::SealedMetaData::getMetaDataStamps() const
 {
   return metaDataStamps;
 }
 
+void SmartStamp::SealedMetaData::write(sdf_ostream &out) const
+{
+  out.writeByte(OPCODE_SEALEDMETADATA);
+  out.write(*data);
+  out.writeList(*metaDataStamps);
+}
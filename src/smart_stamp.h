@@ -14,6 +14,7 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include "properties.h"
 #include "file_util.h"
 #include "message_digest.h"
@@ -38,6 +39,13 @@ using namespace std;
 #define OPCODE_END                  ((char)6)
 #define OPCODE_DOCUMENTINFO         ((char)7)
 #define OPCODE_SEALEDMETADATA       ((char)8)
+#define OPCODE_LEAF_SHA256                  ((char)9)
+#define OPCODE_APPEND_THEN_NODE_SHA256      ((char)10)
+#define OPCODE_PREPEND_THEN_NODE_SHA256     ((char)11)
+
+// prefixes separating the leaves from the inner nodes of a Merkle tree, so an inner node cannot pass for a document hash
+#define MERKLE_LEAF_PREFIX ((char)0)
+#define MERKLE_NODE_PREFIX ((char)1)
 
 #define MAX_VERSION ((char)5)
 #define MIN_VERSION ((char)1)
@@ -57,22 +65,6 @@ public:
   }
 };
 
-template <>
-class Reader<vector<char>>
-{
-  sdf_istream *in;
-public:
-  explicit Reader<vector<char>>(sdf_istream *_in)
-  {
-    in = _in;
-  }
-
-  vector<char> read()
-  {
-    return *(in->readByteBlock());
-  }
-};
-
 enum BundleMethod
 {
   BALANCED_MERKLE_TREE,
@@ -95,9 +87,15 @@ public:
 
     void init(string &_blockchainGeneralName, string &_instanceName);
 
-//    void write(sdf_ostream &out);
+    void write(sdf_ostream &out) const;
+
+    explicit BlockchainDescriptor(sdf_istream &in);
 
-    explicit BlockchainDescriptor(sdf_istream in);
+    BlockchainDescriptor(const BlockchainDescriptor &) = delete;
+
+    BlockchainDescriptor &operator=(const BlockchainDescriptor &) = delete;
+
+    ~BlockchainDescriptor();
 
     json toJson();
 
@@ -122,17 +120,43 @@ public:
     json toJson();
   };
 
+  class Operation;
+
+  /*!
+  @brief compact record of one executed operation
+
+  Trace events are recorded while a SmartStamp is evaluated instead of formatting instruction text right away. They
+  refer to the (immutable) operation of the SmartStamp and hold a snapshot of the accumulator, so the text can be
+  rendered later on demand.
+  */
+  struct TraceEvent
+  {
+    char             opcode;                            //!< opcode of the executed operation
+    const Operation *operation;                         //!< executed operation (owned by the SmartStamp)
+    unsigned char    accu[SHA256_DIGEST_LENGTH];        //!< accumulator at the time the operation was executed
+  };
+
+  /*!
+  @brief result of the verification of a SmartStamp
+
+  The additional info and the instructions are rendered from trace events that point to the operations of the verified
+  SmartStamp. toJson(), getAdditionalInfo() and getInstructions() must therefore be called while that SmartStamp still
+  exists, only hasBeenVerified() may be called after it has been destroyed.
+  */
   class VerificationResult
   {
   private:
     bool verified;
     list<VerificationSource> verificationSources;
-    string additionalInfo;
-    string *optInstructions;
+    vector<TraceEvent> trace;
+    bool provideInstructions;
 
   public:
-    VerificationResult(bool _verified, list<VerificationSource> _verificationSources, string _additionalInfo,
-                       string *_optInstructions);
+    /*!
+    @brief constructor with the trace of the evaluation
+    */
+    VerificationResult(bool _verified, list<VerificationSource> _verificationSources, vector<TraceEvent> _trace,
+                       bool _provideInstructions);
 
     json toJson();
 
@@ -141,17 +165,44 @@ public:
       return verified;
     }
 
-    string getAdditionalInfo()
-    {
-      return additionalInfo;
-    }
+    /*!
+    @brief renders the additional info (blockchain, document info and sealed meta data) from the trace
+    */
+    string getAdditionalInfo();
+
+    /*!
+    @brief renders the step by step instructions from the trace
+
+    @return instructions or nullptr, if instructions were not requested for the verification
+    */
+    string *getInstructions();
   };
 
   class Operation
   {
   public:
     virtual void execute(OperationEvaluator &vm) const = 0;
-//    virtual void write(sdf_ostream out) = 0;
+
+    /*!
+    @brief renders the instruction text for this operation
+
+    @param accu snapshot of the accumulator taken when the operation was executed
+    */
+    virtual string instruction(const unsigned char *accu) const = 0;
+
+    /*!
+    @brief renders additional info for this operation, empty if there is nothing to report
+    */
+    virtual string info() const
+    {
+      return "";
+    }
+
+    /*!
+    @brief serializes this operation (opcode followed by its arguments) in the format read by SmartStamp::parse()
+    */
+    virtual void write(sdf_ostream &out) const = 0;
+
     virtual ~Operation() = default;
   };
 
@@ -165,9 +216,9 @@ public:
     char *optUsrProvAnchorInBC;
     char *optLookedUpAnchorInBlockchain;
     list<VerificationSource> *optLookedUpVerificationSources;
-    string *additionalInfo;
     list<VerificationSource> *verificationSources;
-    string *optInstructions;
+    vector<TraceEvent> *trace;
+    bool provideInstructions;
 
     unsigned char optContainedAnchor[SHA256_DIGEST_LENGTH];
 
@@ -196,18 +247,14 @@ public:
       return static_cast<int>(digest->digest_length());
     }
 
-    /* used for lazy evaluation in order to not waste time calculating the parameter if it's not required */
-    void instruct(const string &instruction)
+    /* used for lazy evaluation: only records the event, the text is rendered when it is requested */
+    void instruct(char opcode, const Operation *operation)
     {
-      if (optInstructions != nullptr)
-      {
-        optInstructions->append(instruction);
-        if (optInstructions->at(optInstructions->size()-1)!='\n')
-          optInstructions->append("\n");
-      }
+      trace->push_back(TraceEvent{opcode, operation, {}});
+      memcpy(trace->back().accu, accu, SHA256_DIGEST_LENGTH);
     }
 
-    void setOrigDocComparisonDone(bool b){
+    void setOrigDocComparisonDone(bool){
       origDocComparisonDone = true;
     }
 
@@ -237,45 +284,63 @@ public:
 
     void execute(OperationEvaluator &vm) const override;
 
-//    void write(sdf_ostream out)
-//    {
-//      out.writeRaw(docHash, OPCODE_DOC_SHA256);
-//    }
+    string instruction(const unsigned char *accu) const override;
+
+    void write(sdf_ostream &out) const override;
+  };
+
+  /*!
+  @brief hashes a document hash as leaf of a Merkle tree: SHA256(MERKLE_LEAF_PREFIX || accu)
+  */
+  class Leaf: public Operation
+  {
+  public:
+    Leaf() = default;
+
+    ~Leaf() override = default;
+
+    void execute(OperationEvaluator &vm) const override;
+
+    string instruction(const unsigned char *accu) const override;
+
+    void write(sdf_ostream &out) const override;
   };
 
   class Append: public Operation
   {
   private:
     unsigned char hash[SHA256_DIGEST_LENGTH]{};
+    bool          node; //!< hashes an inner node of a Merkle tree: SHA256(MERKLE_NODE_PREFIX || accu || hash)
 
   public:
-    explicit Append(unsigned char *_hash);
+    explicit Append(unsigned char *_hash, bool _node = false);
 
     ~Append() override = default;
 
     void execute(OperationEvaluator &vm) const override;
 
-//    void write(sdf_ostream out);
+    string instruction(const unsigned char *accu) const override;
+
+    void write(sdf_ostream &out) const override;
   };
 
   class Prepend: public Operation
   {
   private:
     unsigned char hash[SHA256_DIGEST_LENGTH]{};
+    bool          node; //!< hashes an inner node of a Merkle tree: SHA256(MERKLE_NODE_PREFIX || hash || accu)
 
   public:
 
-    explicit Prepend(unsigned char *_hash);
+    explicit Prepend(unsigned char *_hash, bool _node = false);
 
     ~Prepend() override = default;
 
     void execute(OperationEvaluator &vm) const override;
 
-//    void write(sdf_ostream out)
-//    {
-//      out.write(OPCODE_PREPEND_THEN_SHA256);
-//      writeSHA256(out, hash);
-//    }
+    string instruction(const unsigned char *accu) const override;
+
+    void write(sdf_ostream &out) const override;
   };
 
   class Anchor: public Operation
@@ -289,11 +354,9 @@ public:
 
     void execute(OperationEvaluator &vm) const override;
 
-    //    void write(sdf_ostream out)
-//    {
-//      out.write(OPCODE_ANCHOR_SHA256);
-//      writeSHA256(out, hash);
-//    }
+    string instruction(const unsigned char *accu) const override;
+
+    void write(sdf_ostream &out) const override;
   };
 
   class Blockchain: public Operation
@@ -310,20 +373,17 @@ public:
 
     void execute(OperationEvaluator &vm) const override;
 
+    string instruction(const unsigned char *accu) const override;
+
+    string info() const override;
+
     time_t getInsertedIntoBlockchainAt() const;
 
     const string &getBlockChainId() const;
 
     BlockchainDescriptor *getBlockChainDesc() const;
 
-
-//    void write(sdf_ostream out)
-//    {
-//      out.write(OPCODE_BLOCKCHAIN);
-//      blockChainDesc->write(out);
-//      out.write(blockChainId);
-//      out.writeInt(insertedIntoBlockchainAt);
-//    }
+    void write(sdf_ostream &out) const override;
   };
 
   class DocumentInfo: public Operation
@@ -340,38 +400,35 @@ public:
 
     void execute(OperationEvaluator &vm) const override;
 
-//    void write(sdf_ostream out)
-//    {
-//      out.write(OPCODE_DOCUMENTINFO);
-//      out.writeOpt(optLookupInfo);
-//      out.writeOpt(optName);
-//      out.writeOpt(optContentType);
-//    }
+    string instruction(const unsigned char *accu) const override;
+
+    string info() const override;
+
+    void write(sdf_ostream &out) const override;
   };
 
   class SealedMetaData: public Operation
   {
   private:
     string *data;
-    list<vector<char>> *metaDataStamps;
+    vector<vector<char>> *metaDataStamps;
 
   public:
-    SealedMetaData(string *_data, list<vector<char>> *_metaDataStamps);
+    SealedMetaData(string *_data, vector<vector<char>> *_metaDataStamps);
 
     ~SealedMetaData() override;
 
     string *getData() const;
 
-    list<vector<char>> *getMetaDataStamps() const;
+    vector<vector<char>> *getMetaDataStamps() const;
 
     void execute(OperationEvaluator &vm) const override;
 
-//    void write(sdf_ostream out)
-//    {
-//      out.write(OPCODE_SEALEDMETADATA);
-//      out.write(data);
-//      out.write(metaDataStamps);
-//    }
+    string instruction(const unsigned char *accu) const override;
+
+    string info() const override;
+
+    void write(sdf_ostream &out) const override;
   };
 
 private:
@@ -384,6 +441,7 @@ private:
   DocumentInfo      *documentInfo   = nullptr;
   SealedMetaData    *sealedMetaData = nullptr;
   BundleMethod       bundleMethod   = BundleMethod::BALANCED_MERKLE_TREE;
+  long               docHashOffset  = -1;
 
 
 public:
@@ -396,6 +454,11 @@ public:
 
   explicit SmartStamp(vector<char> _data);
 
+  /*!
+  @brief constructor reading a SmartStamp that has been written with write(), e.g. from an archive of SmartStamps
+  */
+  explicit SmartStamp(sdf_istream &in);
+
   ~SmartStamp();
 
 public:
@@ -403,12 +466,19 @@ public:
 
   void initFields();
 
-//  static void writeSHA256(sdf_ostream *out, unsigned char hash[SHA256_DIGEST_LENGTH])
-//  {
-//    if (hash.length != 256 / 8)
-//      throw io_error(__FILE__, __LINE__, "Illegal length of hash.");
-//    out->writeRaw(hash, SHA256_DIGEST_LENGTH);
-//  }
+  static void writeSHA256(sdf_ostream &out, const unsigned char *hash)
+  {
+    out.writeRaw(hash, SHA256_DIGEST_LENGTH);
+  }
+
+  /*!
+  @brief serializes a list of operations as SmartStamp (header, bundle method, operations and end marker)
+
+  @param operations operations in the order they are evaluated
+  @param bundleMethod bundle method stored in the SmartStamp
+  @param out raw data of the SmartStamp is appended to this vector
+  */
+  static void encode(const list<Operation*> &operations, BundleMethod bundleMethod, vector<char> *out);
 
   unsigned char *readSHA256(sdf_istream *in);
 
@@ -416,6 +486,13 @@ public:
 
   vector<char> *toRawData();
 
+  /*!
+  @brief serializes the parsed operations of this SmartStamp again in the current version of the format
+
+  @return raw data of the re-encoded SmartStamp, to be deleted by the caller
+  */
+  vector<char> *reencode();
+
   unsigned char *getDocHash();
 
   unsigned char *getRootHash() const;
@@ -430,9 +507,30 @@ public:
 
   BundleMethod getBundleMethod() const;
 
+  /*!
+  @brief returns the position of the OPCODE_DOC_SHA256 operation in the raw data of this SmartStamp
+
+  Used to splice additional operations (e.g. a local Merkle path) into the raw data in front of the document hash.
+
+  @return byte offset of the document hash operation or -1, if the SmartStamp contains no document hash
+  */
+  long getDocHashOffset();
+
+
+  /*!
+  @brief verifies the SmartStamp for the contents of a document
 
+  @return result to be deleted by the caller, to be rendered before this SmartStamp is destroyed (see
+          VerificationResult)
+  */
   VerificationResult *verifyByContents(char *documentContents, char *optHashInBlockchain, bool provideInstructions);
 
+  /*!
+  @brief verifies the SmartStamp for the hash of a document
+
+  @return result to be deleted by the caller, to be rendered before this SmartStamp is destroyed (see
+          VerificationResult)
+  */
   VerificationResult *verifyByHash(unsigned char *documentHash, char *optHashInBlockchain, bool provideInstructions);
 
   VerificationResult *verifyByHashHelper(OperationEvaluator *vm, unsigned char *documentHash, bool provideInstructions);
@@ -446,14 +544,14 @@ public:
 //      //operation.appendTo(stampCreator);
 //    }
 //  }
-//
-//  void write(sdf_ostream out) {
-//    out.writeByteBlock(data);
-//  }
 
-//  SmartStamp(sdf_istream *in) {
-//    this(in->readByteBlock());
-//  }
+  /*!
+  @brief writes the raw data of this SmartStamp as byte block, e.g. as part of sealed meta data
+  */
+  void write(sdf_ostream &out) const
+  {
+    out.writeByteBlock(*data);
+  }
 };
 
 //bool verifySmartStamp(string smartStampTextualRepresentation)
@@ -0,0 +1,71 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+// Runs a fuzz target on the files of a corpus without libFuzzer, so the corpus is checked by ctest with any compiler.
+// Each argument is a file or a directory of files.
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+static void run_file(const string &file)
+{
+  ifstream in(file, ios::binary);
+  const vector<char> data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+}
+
+int main(int argc, char **argv)
+{
+  size_t count = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    const string path = argv[i];
+    struct stat st {};
+    if (stat(path.c_str(), &st) != 0)
+    {
+      cerr << "Cannot read \"" << path << "\"." << endl;
+      return 1;
+    }
+    if (!S_ISDIR(st.st_mode))
+    {
+      run_file(path);
+      count++;
+      continue;
+    }
+    DIR *dir = opendir(path.c_str());
+    if (!dir)
+    {
+      cerr << "Cannot read \"" << path << "\"." << endl;
+      return 1;
+    }
+    while (dirent *entry = readdir(dir))
+    {
+      if (entry->d_name[0] != '.')
+      {
+        run_file(path + "/" + entry->d_name);
+        count++;
+      }
+    }
+    closedir(dir);
+  }
+  cout << "Ran " << count << " input(s)." << endl;
+  return 0;
+}
@@ -0,0 +1,67 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+// Decodes arbitrary input with sdf_istream. Each field is preceded by a byte selecting how it is read, so the fuzzer
+// reaches all decoders. Malformed input has to be rejected with io_error, anything else is a finding.
+
+#include <cstdint>
+#include "src/serialized_data_format.hpp"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  vector<char> input(reinterpret_cast<const char *>(data), reinterpret_cast<const char *>(data) + size);
+  try
+  {
+    sdf_istream in(&input, _compatibility::PermitPre5Header);
+    // every field consumes at least the byte selecting it, so the loop ends with an io_error at the end of the input
+    while (true)
+    {
+      switch (static_cast<unsigned char>(in.readByte()) % 9)
+      {
+        case 0:
+          in.readInt();
+          break;
+        case 1:
+          in.readStringSpan();
+          break;
+        case 2:
+          in.readByteBlockSpan();
+          break;
+        case 3:
+          delete in.readList([&in]() { return in.readInt(); });
+          break;
+        case 4:
+          delete in.readByteBlockList();
+          break;
+        case 5:
+          delete in.readMap();
+          break;
+        case 6:
+          delete in.readOptString();
+          break;
+        case 7:
+          delete in.readOptInt();
+          break;
+        default:
+        {
+          char raw[32];  // e.g. a SHA-256 hash
+          in.readRaw(raw, sizeof(raw));
+          break;
+        }
+      }
+    }
+  }
+  catch (io_error &)
+  {
+    // malformed or truncated input
+  }
+  return 0;
+}
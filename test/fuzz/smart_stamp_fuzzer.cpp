@@ -0,0 +1,41 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+// Parses arbitrary input as the raw data of a SmartStamp, serializes it again and verifies it for its own document
+// hash, like cealr does with the SmartStamps returned by the server. Malformed input has to be rejected with
+// SmartStampError or io_error, anything else is a finding.
+
+#include <cstdint>
+#include "src/smart_stamp.h"
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+  try
+  {
+    SmartStamp smartStamp(vector<char>(reinterpret_cast<const char *>(data), reinterpret_cast<const char *>(data) + size));
+    smartStamp.initFields();
+    smartStamp.toJson();
+    delete smartStamp.reencode();
+    smartStamp.getDocHashOffset();
+    SmartStamp::VerificationResult *result = smartStamp.verifyByHash(smartStamp.getDocHash(), nullptr, true);
+    result->toJson();
+    delete result;
+  }
+  catch (SmartStampError &)
+  {
+    // malformed SmartStamp
+  }
+  catch (io_error &)
+  {
+    // truncated SmartStamp
+  }
+  return 0;
+}
@@ -0,0 +1,252 @@
+/*
+ * _____ _____  _____  ___    ______
+ *|   __|   __|/  _  \|   |  |   _  |  Command line tool for sealing files with Cryptowerk API
+ *|  |__|   __|   _   |   |__|
+ *|_____|_____|__| |__|______|__|\__\  https://github.com/cryptowerk/cealr
+ *
+ *Licensed under the Apache 2.0 License <https://opensource.org/licenses/Apache-2.0>.
+ *Copyright (c) 2018 Cryptowerk <http://www.cryptowerk.com>.
+ *
+ */
+
+// Decodes serialized data from files and pipes that are larger than the buffers of fd_istream and mmap_istream and
+// compares the result with decoding the same data in memory.
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include "src/sdf_file_stream.h"
+
+#define RECORD_COUNT 20000
+#define LARGE_BLOCK_SIZE 0x30000
+
+static int failures = 0;
+
+#define CHECK(condition) \
+  if (!(condition)) \
+  { \
+    cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << endl; \
+    failures++; \
+  }
+
+struct record
+{
+  long                 number;
+  string               text;
+  vector<char>         block;
+  vector<long>         list;
+  vector<vector<char>> blocks;
+};
+
+static void write_record(sdf_ostream &out, long i)
+{
+  out.writeInt(i % 3 ? i * 7919 : -i * 104729);
+  out.write(string(static_cast<size_t>(i % 97), static_cast<char>('a' + i % 26)));
+  // every thousandth block is larger than the buffers, so it has to be made available in one piece
+  out.writeByteBlock(vector<char>(static_cast<size_t>(i % 1000 == 0 ? LARGE_BLOCK_SIZE : i % 300),
+                                  static_cast<char>(i)));
+  vector<long> list(static_cast<size_t>(i % 50));
+  for (size_t j = 0; j < list.size(); j++)
+  {
+    list[j] = i * static_cast<long>(j) - 1000;
+  }
+  out.writeList(list, [&out](long v) { out.writeInt(v); });
+  out.writeList(vector<vector<char>>(static_cast<size_t>(i % 5), vector<char>(3, 'x')));
+}
+
+static vector<record> read_records(sdf_istream &in)
+{
+  vector<record> records;
+  for (long i = 0; i < RECORD_COUNT; i++)
+  {
+    record r;
+    r.number = in.readInt();
+    r.text   = in.readStringSpan().str();
+    r.block  = in.readByteBlockSpan().to_vector();
+    unique_ptr<vector<long>> list(in.readList([&in]() { return in.readInt(); }));
+    r.list   = *list;
+    unique_ptr<vector<vector<char>>> blocks(in.readByteBlockList());
+    r.blocks = *blocks;
+    records.push_back(std::move(r));
+  }
+  return records;
+}
+
+static bool equal(const vector<record> &a, const vector<record> &b)
+{
+  if (a.size() != b.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++)
+  {
+    if (a[i].number != b[i].number || a[i].text != b[i].text || a[i].block != b[i].block || a[i].list != b[i].list ||
+        a[i].blocks != b[i].blocks)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void write_file(const string &file_name, const vector<char> &data)
+{
+  ofstream out(file_name, ios::binary);
+  out.write(data.data(), data.size());
+}
+
+/*!
+@brief returns true, if decoding with the given input throws an io_error
+*/
+static bool fails_with_io_error(int_istream *input, const function<void(sdf_istream &)> &decode)
+{
+  try
+  {
+    sdf_istream in(input, _compatibility::Default);
+    decode(in);
+  }
+  catch (io_error &)
+  {
+    return true;
+  }
+  return false;
+}
+
+/*!
+@brief passes data through a pipe, which is read by decode() while another thread writes it
+*/
+static void with_pipe(const vector<char> &data, const function<void(int fd)> &decode)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    throw io_error(__FILE__, __LINE__, "Cannot create a pipe.");
+  }
+  thread writer([&data, &fds]()
+                {
+                  for (size_t written = 0; written < data.size();)
+                  {
+                    ssize_t n = write(fds[1], data.data() + written, data.size() - written);
+                    if (n <= 0)
+                    {
+                      break;
+                    }
+                    written += n;
+                  }
+                  close(fds[1]);
+                });
+  try
+  {
+    decode(fds[0]);
+  }
+  catch (...)
+  {
+    close(fds[0]);
+    writer.join();
+    throw;
+  }
+  close(fds[0]);
+  writer.join();
+}
+
+int main()
+{
+  vector<char> data;
+  {
+    sdf_ostream out(&data);
+    for (long i = 0; i < RECORD_COUNT; i++)
+    {
+      write_record(out, i);
+    }
+  }
+  CHECK(data.size() > 16 * FD_ISTREAM_BUFFER_SIZE);
+  const string file_name = "sdf_file_stream_test.sdf";
+  write_file(file_name, data);
+
+  sdf_istream in_memory(&data, _compatibility::Default);
+  const vector<record> expected = read_records(in_memory);
+
+  {
+    fd_istream  input(file_name);
+    sdf_istream in(&input, _compatibility::Default);
+    CHECK(equal(read_records(in), expected));
+  }
+  {
+    fd_istream  input(file_name, 256);
+    sdf_istream in(&input, _compatibility::Default);
+    CHECK(equal(read_records(in), expected));
+    CHECK(input.position() == static_cast<streamsize>(data.size()));
+  }
+  {
+    mmap_istream input(file_name, static_cast<size_t>(sysconf(_SC_PAGESIZE)));
+    sdf_istream  in(&input, _compatibility::Default);
+    CHECK(equal(read_records(in), expected));
+    CHECK(input.position() == static_cast<streamsize>(data.size()));
+  }
+  with_pipe(data, [&expected](int fd)
+  {
+    fd_istream  input(fd, 1000);
+    sdf_istream in(&input, _compatibility::Default);
+    CHECK(equal(read_records(in), expected));
+  });
+
+  // a count or length beyond the end of the input is rejected without buffering or allocating for it
+  vector<char> truncated;
+  {
+    sdf_ostream out(&truncated);
+    out.writeInt(100000000);
+    out.writeRaw("0123456789", 10);
+  }
+  write_file(file_name, truncated);
+  const auto read_list   = [](sdf_istream &in) { delete in.readList([&in]() { return in.readByte(); }); };
+  const auto read_block  = [](sdf_istream &in) { in.readByteBlockSpan(); };
+  char       raw[100];
+  const auto read_raw    = [&raw](sdf_istream &in)
+  {
+    in.readInt();
+    in.readRaw(raw, sizeof(raw));
+  };
+  {
+    fd_istream input(file_name, 16);
+    CHECK(fails_with_io_error(&input, read_list));
+  }
+  {
+    fd_istream input(file_name, 16);
+    CHECK(fails_with_io_error(&input, read_block));
+  }
+  {
+    fd_istream input(file_name, 16);
+    CHECK(fails_with_io_error(&input, read_raw));
+  }
+  {
+    mmap_istream input(file_name);
+    CHECK(fails_with_io_error(&input, read_list));
+  }
+  {
+    mmap_istream input(file_name);
+    CHECK(fails_with_io_error(&input, read_block));
+  }
+  with_pipe(truncated, [&read_list](int fd)
+  {
+    fd_istream input(fd, 16);
+    CHECK(fails_with_io_error(&input, read_list));
+  });
+  with_pipe(truncated, [&read_raw](int fd)
+  {
+    fd_istream input(fd, 16);
+    CHECK(fails_with_io_error(&input, read_raw));
+  });
+
+  remove(file_name.c_str());
+  if (failures)
+  {
+    cerr << failures << " checks failed." << endl;
+    return 1;
+  }
+  cout << "All checks passed." << endl;
+  return 0;
+}